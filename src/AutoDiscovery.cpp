@@ -3,16 +3,23 @@
 //
 
 #include "AutoDiscovery.h"
-#include "Poco/JSON/Parser.h"
+#include "SerialNumberCache.h"
 #include "StorageService.h"
 #include "framework/KafkaManager.h"
 #include "framework/KafkaTopics.h"
+#include "framework/MicroServiceFuncs.h"
 #include "framework/ow_constants.h"
 
+#include "nlohmann/json.hpp"
+
 namespace OpenWifi {
 
 	int AutoDiscovery::Start() {
 		poco_information(Logger(), "Starting...");
+		BatchSize_ = MicroServiceConfigGetInt("discovery.batch.size", 200);
+		BatchWindow_ = MicroServiceConfigGetInt("discovery.batch.window", 250);
+		if (BatchSize_ == 0)
+			BatchSize_ = 1;
 		Running_ = true;
 		Types::TopicNotifyFunction F = [this](const std::string &Key, const std::string &Payload) {
 			this->ConnectionReceived(Key, Payload);
@@ -31,59 +38,230 @@ namespace OpenWifi {
 		poco_information(Logger(), "Stopped...");
 	};
 
+	void AutoDiscovery::Stats(Poco::JSON::Object &Answer) {
+		Answer.set("queued", Queue_.size());
+		Answer.set("received", Received_.load());
+		Answer.set("coalesced", Coalesced_.load());
+		Answer.set("unchanged", Unchanged_.load());
+		Answer.set("batches", Batches_.load());
+	}
+
+	/*
+	 * SAX handler pulling only the fields auto-discovery needs out of a connection or ping message.
+	 * Nothing is materialized: the (large) capabilities object is scanned but never stored.
+	 */
+	class ConnectionMessageExtractor : public nlohmann::json_sax<nlohmann::json> {
+	  public:
+		bool null() override { return true; }
+		bool boolean([[maybe_unused]] bool val) override { return true; }
+		bool number_integer([[maybe_unused]] number_integer_t val) override { return true; }
+		bool number_unsigned([[maybe_unused]] number_unsigned_t val) override { return true; }
+		bool number_float([[maybe_unused]] number_float_t val,
+						  [[maybe_unused]] const string_t &s) override {
+			return true;
+		}
+		bool binary([[maybe_unused]] binary_t &val) override { return true; }
+
+		bool string(string_t &val) override {
+			switch (Level()) {
+			case InPayload:
+				if (Key_ == uCentralProtocol::CONNECTIONIP)
+					ConnectionIP_ = std::move(val);
+				else if (Key_ == uCentralProtocol::SERIAL)
+					Serial_ = std::move(val);
+				else if (Key_ == "locale")
+					Locale_ = std::move(val);
+				break;
+			case InCapabilities:
+				if (Key_ == uCentralProtocol::COMPATIBLE)
+					CapabilitiesCompatible_ = std::move(val);
+				break;
+			case InPing:
+				if (Key_ == uCentralProtocol::CONNECTIONIP)
+					PingConnectionIP_ = std::move(val);
+				else if (Key_ == uCentralProtocol::SERIALNUMBER)
+					PingSerialNumber_ = std::move(val);
+				else if (Key_ == uCentralProtocol::COMPATIBLE)
+					PingCompatible_ = std::move(val);
+				break;
+			default:
+				break;
+			}
+			return true;
+		}
+
+		bool key(string_t &val) override {
+			Key_ = std::move(val);
+			switch (Level()) {
+			case InRoot:
+				HasPayload_ |= (Key_ == uCentralProtocol::PAYLOAD);
+				break;
+			case InPayload:
+				HasCapabilities_ |= (Key_ == uCentralProtocol::CAPABILITIES);
+				HasPing_ |= (Key_ == uCentralProtocol::PING);
+				break;
+			case InCapabilities:
+				HasCapabilitiesCompatible_ |= (Key_ == uCentralProtocol::COMPATIBLE);
+				break;
+			case InPing:
+				HasPingFirmware_ |= (Key_ == uCentralProtocol::FIRMWARE);
+				HasPingSerialNumber_ |= (Key_ == uCentralProtocol::SERIALNUMBER);
+				HasPingCompatible_ |= (Key_ == uCentralProtocol::COMPATIBLE);
+				break;
+			default:
+				break;
+			}
+			return true;
+		}
+
+		bool start_object([[maybe_unused]] std::size_t elements) override {
+			auto Current = Level();
+			if (Path_.empty())
+				Path_.push_back(InRoot);
+			else if (Current == InRoot && Key_ == uCentralProtocol::PAYLOAD)
+				Path_.push_back(InPayload);
+			else if (Current == InPayload && Key_ == uCentralProtocol::CAPABILITIES)
+				Path_.push_back(InCapabilities);
+			else if (Current == InPayload && Key_ == uCentralProtocol::PING)
+				Path_.push_back(InPing);
+			else
+				Path_.push_back(Elsewhere);
+			Key_.clear();
+			return true;
+		}
+
+		bool end_object() override {
+			Path_.pop_back();
+			Key_.clear();
+			return true;
+		}
+
+		bool start_array([[maybe_unused]] std::size_t elements) override {
+			Path_.push_back(Elsewhere);
+			return true;
+		}
+
+		bool end_array() override {
+			Path_.pop_back();
+			Key_.clear();
+			return true;
+		}
+
+		bool parse_error([[maybe_unused]] std::size_t position,
+						 [[maybe_unused]] const std::string &last_token,
+						 [[maybe_unused]] const nlohmann::detail::exception &ex) override {
+			return false;
+		}
+
+		//	same selection rules as the former DOM based parsing
+		bool Extract(DeviceConnectionInfo &Connection) {
+			if (!HasPayload_)
+				return false;
+			Connection.ConnectionInfo = ConnectionIP_;
+			if (HasCapabilities_) {
+				if (HasCapabilitiesCompatible_) {
+					Connection.DeviceType = CapabilitiesCompatible_;
+					Connection.SerialNumber = Serial_;
+				}
+			} else if (HasPing_) {
+				if (HasPingFirmware_ && HasPingSerialNumber_ && HasPingCompatible_) {
+					if (!PingConnectionIP_.empty())
+						Connection.ConnectionInfo = PingConnectionIP_;
+					Connection.SerialNumber = PingSerialNumber_;
+					Connection.DeviceType = PingCompatible_;
+				}
+			}
+			Connection.Locale = Locale_;
+			return !Connection.SerialNumber.empty();
+		}
+
+	  private:
+		enum ObjectLevel { Elsewhere, InRoot, InPayload, InCapabilities, InPing };
+		std::vector<ObjectLevel> Path_;
+		std::string Key_;
+		std::string ConnectionIP_, Serial_, Locale_, CapabilitiesCompatible_;
+		std::string PingConnectionIP_, PingSerialNumber_, PingCompatible_;
+		bool HasPayload_ = false, HasCapabilities_ = false, HasPing_ = false;
+		bool HasCapabilitiesCompatible_ = false;
+		bool HasPingFirmware_ = false, HasPingSerialNumber_ = false, HasPingCompatible_ = false;
+
+		[[nodiscard]] inline ObjectLevel Level() const {
+			return Path_.empty() ? Elsewhere : Path_.back();
+		}
+	};
+
+	bool AutoDiscovery::ParseConnectionMessage(const std::string &Payload,
+											   DeviceConnectionInfo &Connection) {
+		ConnectionMessageExtractor Extractor;
+		if (!nlohmann::json::sax_parse(Payload, &Extractor))
+			return false;
+		return Extractor.Extract(Connection);
+	}
+
+	void AutoDiscovery::ProcessBatch(std::map<std::string, DeviceConnectionInfo> &Batch) {
+		if (Batch.empty())
+			return;
+		DeviceConnectionInfoVec Connections;
+		Connections.reserve(Batch.size());
+		for (auto &[_, Connection] : Batch)
+			Connections.emplace_back(std::move(Connection));
+		Batch.clear();
+		Batches_++;
+		try {
+			StorageService()->InventoryDB().CreateFromConnections(Connections);
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		} catch (...) {
+		}
+	}
+
 	void AutoDiscovery::run() {
 		Poco::AutoPtr<Poco::Notification> Note(Queue_.waitDequeueNotification());
 		Utils::SetThreadName("auto-discovery");
+		std::map<std::string, DeviceConnectionInfo> Batch;
 		while (Note && Running_) {
-			auto Msg = dynamic_cast<DiscoveryMessage *>(Note.get());
-			if (Msg != nullptr) {
-				try {
-					Poco::JSON::Parser Parser;
-					auto Object = Parser.parse(Msg->Payload()).extract<Poco::JSON::Object::Ptr>();
-
-					if (Object->has(uCentralProtocol::PAYLOAD)) {
-						auto PayloadObj = Object->getObject(uCentralProtocol::PAYLOAD);
-						std::string ConnectedIP, SerialNumber, DeviceType;
-						if (PayloadObj->has(uCentralProtocol::CONNECTIONIP))
-							ConnectedIP =
-								PayloadObj->get(uCentralProtocol::CONNECTIONIP).toString();
-						if (PayloadObj->has(uCentralProtocol::CAPABILITIES)) {
-							auto CapObj = PayloadObj->getObject(uCentralProtocol::CAPABILITIES);
-							if (CapObj->has(uCentralProtocol::COMPATIBLE)) {
-								DeviceType = CapObj->get(uCentralProtocol::COMPATIBLE).toString();
-								SerialNumber = PayloadObj->get(uCentralProtocol::SERIAL).toString();
-							}
-						} else if (PayloadObj->has(uCentralProtocol::PING)) {
-							auto PingMessage = PayloadObj->getObject(uCentralProtocol::PING);
-							if (PingMessage->has(uCentralProtocol::FIRMWARE) &&
-								PingMessage->has(uCentralProtocol::SERIALNUMBER) &&
-								PingMessage->has(uCentralProtocol::COMPATIBLE)) {
-								if (PingMessage->has(uCentralProtocol::CONNECTIONIP))
-									ConnectedIP =
-										PingMessage->get(uCentralProtocol::CONNECTIONIP).toString();
-								SerialNumber =
-									PingMessage->get(uCentralProtocol::SERIALNUMBER).toString();
-								DeviceType =
-									PingMessage->get(uCentralProtocol::COMPATIBLE).toString();
+			//	gather messages for up to BatchWindow_ ms, keeping only the latest one per device
+			auto BatchStart = std::chrono::steady_clock::now();
+			while (Note) {
+				auto Msg = dynamic_cast<DiscoveryMessage *>(Note.get());
+				if (Msg != nullptr) {
+					Received_++;
+					try {
+						DeviceConnectionInfo Connection;
+						if (ParseConnectionMessage(Msg->Payload(), Connection)) {
+							auto SerialNumber = Poco::toLower(Connection.SerialNumber);
+							auto Hint = Batch.find(SerialNumber);
+							if (SerialNumberCache()->FingerprintMatches(
+									SerialNumber, Connection.Fingerprint())) {
+								//	nothing changed since the last write: no database access needed
+								Unchanged_++;
+								if (Hint != Batch.end())
+									Batch.erase(Hint);
+							} else {
+								if (Hint != Batch.end())
+									Coalesced_++;
+								Batch[SerialNumber] = std::move(Connection);
 							}
 						}
-						std::string Locale;
-						if (PayloadObj->has("locale"))
-							Locale = PayloadObj->get("locale").toString();
-
-						if (!SerialNumber.empty()) {
-							StorageService()->InventoryDB().CreateFromConnection(
-								SerialNumber, ConnectedIP, DeviceType, Locale);
-						}
+					} catch (const Poco::Exception &E) {
+						Logger().log(E);
+					} catch (...) {
 					}
-				} catch (const Poco::Exception &E) {
-					Logger().log(E);
-				} catch (...) {
 				}
-			} else {
+				if (Batch.size() >= BatchSize_ || !Running_)
+					break;
+				auto Elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+								   std::chrono::steady_clock::now() - BatchStart)
+								   .count();
+				if (Elapsed >= (int64_t)BatchWindow_)
+					break;
+				Note = Queue_.waitDequeueNotification(BatchWindow_ - Elapsed);
 			}
+			ProcessBatch(Batch);
+			if (!Running_)
+				break;
 			Note = Queue_.waitDequeueNotification();
 		}
 	}
 
-} // namespace OpenWifi
\ No newline at end of file
+} // namespace OpenWifi
@@ -6,6 +6,7 @@
 
 #include "framework/OpenWifiTypes.h"
 #include "framework/SubSystemServer.h"
+#include "storage/storage_inventory.h"
 
 #include "Poco/Notification.h"
 #include "Poco/NotificationQueue.h"
@@ -33,6 +34,7 @@ namespace OpenWifi {
 
 		int Start() override;
 		void Stop() override;
+		void Stats(Poco::JSON::Object &Answer) override;
 		void ConnectionReceived(const std::string &Key, const std::string &Payload) {
 			std::lock_guard G(Mutex_);
 			poco_trace(Logger(), Poco::format("Device(%s): Connection/Ping message.", Key));
@@ -45,6 +47,16 @@ namespace OpenWifi {
 		Poco::NotificationQueue Queue_;
 		Poco::Thread Worker_;
 		std::atomic_bool Running_ = false;
+		uint64_t BatchSize_ = 200;
+		uint64_t BatchWindow_ = 250;
+		std::atomic_uint64_t Received_ = 0;
+		std::atomic_uint64_t Coalesced_ = 0;
+		std::atomic_uint64_t Unchanged_ = 0;
+		std::atomic_uint64_t Batches_ = 0;
+
+		static bool ParseConnectionMessage(const std::string &Payload,
+										   DeviceConnectionInfo &Connection);
+		void ProcessBatch(std::map<std::string, DeviceConnectionInfo> &Batch);
 
 		AutoDiscovery() noexcept
 			: SubSystemServer("AutoDiscovery", "AUTO-DISCOVERY", "discovery") {}
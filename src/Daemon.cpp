@@ -17,11 +17,13 @@
 #include "FileDownloader.h"
 #include "FindCountry.h"
 #include "JobController.h"
+#include "Kafka_ProvUpdater.h"
 #include "SerialNumberCache.h"
 #include "Signup.h"
 #include "StorageService.h"
 #include "UI_Prov_WebSocketNotifications.h"
 #include "framework/ConfigurationValidator.h"
+#include "framework/RESTAPI_ResponseCache.h"
 #include "framework/UI_WebSocketClientServer.h"
 
 namespace OpenWifi {
@@ -35,7 +37,9 @@ namespace OpenWifi {
 												ConfigurationValidator(), SerialNumberCache(),
 												AutoDiscovery(), JobController(),
 												UI_WebSocketClientServer(), FindCountryFromIP(),
-												Signup(), FileDownloader()});
+												Signup(), FileDownloader(),
+												ProvisioningChangePublisher(),
+												RESTAPI_ResponseCache()});
 		}
 		return instance_;
 	}
@@ -51,6 +55,13 @@ namespace OpenWifi {
 			FWRules_ = ProvObjects::dont_upgrade;
 		}
 
+		std::string Mismatch;
+		if (!ProvObjects::VerifyJSONWriter(Mismatch)) {
+			JSONWriter::Enabled = false;
+			poco_error(logger(), "JSONWriter output differs from Poco::JSON, lists will be built "
+								 "with Poco::JSON. " + Mismatch);
+		}
+
 		WebSocketProcessor_ = std::make_unique<ProvWebSocketClient>(logger());
 
 		AssetDir_ = MicroService::instance().DataDir() + "/wwwassets";
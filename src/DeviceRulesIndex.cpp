@@ -0,0 +1,177 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#include "DeviceRulesIndex.h"
+
+#include <algorithm>
+
+#include "HierarchyIndex.h"
+#include "StorageService.h"
+#include "framework/RESTAPI_utils.h"
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	//	serial numbers that are not hexadecimal cannot be keyed and are left out
+	static inline bool SerialNumberKey(const std::string &SerialNumber, uint64_t &Key) {
+		try {
+			Key = Utils::SerialNumberToInt(SerialNumber);
+			return true;
+		} catch (...) {
+		}
+		return false;
+	}
+
+	static inline std::string RulesKey(const ProvObjects::DeviceRules &R) {
+		return R.rcOnly + '\n' + R.rrm + '\n' + R.firmwareUpgrade;
+	}
+
+	DeviceRulesIndex::Entry DeviceRulesIndex::Intern(const Device &D) {
+		Entry E;
+		auto Owner = OwnerIds_.find(D.Owner);
+		if (Owner == OwnerIds_.end()) {
+			E.Owner = Owners_.size();
+			Owners_.push_back(D.Owner);
+			OwnerIds_[D.Owner] = E.Owner;
+		} else {
+			E.Owner = Owner->second;
+		}
+		auto Key = RulesKey(D.Rules);
+		auto Rules = RuleSetIds_.find(Key);
+		if (Rules == RuleSetIds_.end()) {
+			E.Rules = RuleSets_.size();
+			RuleSets_.push_back(D.Rules);
+			RuleSetIds_[Key] = E.Rules;
+		} else {
+			E.Rules = Rules->second;
+		}
+		return E;
+	}
+
+	void DeviceRulesIndex::Set(const ProvObjects::InventoryTag &T) {
+		uint64_t SerialNumber;
+		if (!SerialNumberKey(T.serialNumber, SerialNumber))
+			return;
+		Device D{T.venue.empty() ? T.entity : T.venue, T.deviceRules};
+		std::lock_guard G(Mutex_);
+		if (Loading_)
+			Journal_[SerialNumber] = D;
+		Devices_[SerialNumber] = Intern(D);
+	}
+
+	void DeviceRulesIndex::Remove(const std::string &SerialNumber) {
+		uint64_t S;
+		if (!SerialNumberKey(SerialNumber, S))
+			return;
+		std::lock_guard G(Mutex_);
+		if (Loading_)
+			Journal_[S] = std::nullopt;
+		Devices_.erase(S);
+	}
+
+	void DeviceRulesIndex::Invalidate() {
+		std::lock_guard G(Mutex_);
+		Loaded_ = false;
+	}
+
+	void DeviceRulesIndex::Refresh() {
+		{
+			std::lock_guard G(Mutex_);
+			if (Loading_ || (Loaded_ && (Utils::Now() - LoadedAt_) <= ReloadInterval))
+				return;
+			Loading_ = true;
+			Journal_.clear();
+		}
+
+		std::vector<DeviceRulesRecord> Records;
+		bool Success = false;
+		try {
+			Success = StorageService()->InventoryDB().GetDeviceRulesRecords(Records);
+		} catch (...) {
+		}
+
+		std::lock_guard G(Mutex_);
+		Loading_ = false;
+		if (!Success)
+			return;
+		Devices_.clear();
+		Owners_.assign(1, "");
+		OwnerIds_ = {{"", 0}};
+		RuleSets_.clear();
+		RuleSetIds_.clear();
+		for (const auto &R : Records) {
+			uint64_t SerialNumber;
+			if (!SerialNumberKey(R.get<0>(), SerialNumber))
+				continue;
+			Device D{R.get<1>().empty() ? R.get<2>() : R.get<1>(),
+					 RESTAPI_utils::to_object<ProvObjects::DeviceRules>(R.get<3>())};
+			Devices_[SerialNumber] = Intern(D);
+		}
+		for (const auto &[SerialNumber, D] : Journal_) {
+			if (D.has_value())
+				Devices_[SerialNumber] = Intern(*D);
+			else
+				Devices_.erase(SerialNumber);
+		}
+		Journal_.clear();
+		Generation_++;
+		Loaded_ = true;
+		LoadedAt_ = Utils::Now();
+	}
+
+	bool DeviceRulesIndex::Evaluate(const std::string &SerialNumber,
+									ProvObjects::DeviceRules &Rules) {
+		uint64_t Key;
+		if (!SerialNumberKey(SerialNumber, Key))
+			return false;
+		std::string Owner;
+		{
+			std::lock_guard G(Mutex_);
+			auto Hint = Devices_.find(Key);
+			if (Hint == Devices_.end())
+				return false;
+			Rules = RuleSets_[Hint->second.Rules];
+			Owner = Owners_[Hint->second.Owner];
+		}
+		if (!Owner.empty())
+			HierarchyIndex()->ApplyRules(Owner, Rules);
+		Storage::ApplyConfigRules(Rules);
+		return true;
+	}
+
+	void DeviceRulesIndex::RRMDevices(Types::UUIDvec_t &SerialNumbers) {
+		ProvObjects::DeviceRules Defaults;
+		Storage::ApplyConfigRules(Defaults);
+
+		while (true) {
+			//	owners are resolved once each, outside of the lock
+			std::vector<std::string> Owners;
+			uint64_t Generation;
+			{
+				std::lock_guard G(Mutex_);
+				Owners = Owners_;
+				Generation = Generation_;
+			}
+			std::vector<ProvObjects::DeviceRules> Effective(Owners.size());
+			for (std::size_t i = 1; i < Owners.size(); ++i)
+				HierarchyIndex()->EffectiveRules(Owners[i], Effective[i]);
+
+			std::lock_guard G(Mutex_);
+			if (Generation != Generation_)
+				continue;
+			for (const auto &[SerialNumber, E] : Devices_) {
+				const auto *RRM = &RuleSets_[E.Rules].rrm;
+				if (*RRM == "inherit" && E.Owner < Effective.size())
+					RRM = &Effective[E.Owner].rrm;
+				if (*RRM == "inherit")
+					RRM = &Defaults.rrm;
+				if (*RRM != "no" && *RRM != "inherit")
+					SerialNumbers.push_back(Utils::IntToSerialNumber(SerialNumber));
+			}
+			break;
+		}
+		std::sort(SerialNumbers.begin(), SerialNumbers.end());
+	}
+
+} // namespace OpenWifi
@@ -0,0 +1,75 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#pragma once
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "RESTObjects/RESTAPI_ProvObjects.h"
+#include "framework/OpenWifiTypes.h"
+
+namespace OpenWifi {
+
+	/*
+	 * Effective device rules. Each device keeps only its own rules and its owner (venue or
+	 * entity); the rules of the owner and its ancestors come resolved from the hierarchy index,
+	 * so evaluating a device is two lookups and listing the RRM devices is a single pass. Owners
+	 * and rule sets are interned: a device entry is two small integers. The inventory table keeps
+	 * it current on writes, and like the hierarchy index it is refreshed by the storage service
+	 * timer, reloading every ReloadInterval seconds to pick up other instances and replaying the
+	 * writes made during a reload. Lookups never load it; a miss is the caller's to resolve.
+	 */
+	class DeviceRulesIndex {
+	  public:
+		static constexpr uint64_t ReloadInterval = 300;
+
+		static auto instance() {
+			static auto instance_ = new DeviceRulesIndex;
+			return instance_;
+		}
+
+		void Set(const ProvObjects::InventoryTag &T);
+		void Remove(const std::string &SerialNumber);
+		void Invalidate();
+		//	reload from the table if never loaded, invalidated, or older than ReloadInterval
+		void Refresh();
+
+		//	device rules over its owner's effective rules, then the configured defaults. False
+		//	when the device is not in the index.
+		bool Evaluate(const std::string &SerialNumber, ProvObjects::DeviceRules &Rules);
+		void RRMDevices(Types::UUIDvec_t &SerialNumbers);
+
+	  private:
+		struct Entry {
+			uint32_t Owner = 0; //	0: no venue or entity
+			uint32_t Rules = 0;
+		};
+
+		struct Device {
+			std::string Owner;
+			ProvObjects::DeviceRules Rules;
+		};
+
+		std::mutex Mutex_;
+		std::unordered_map<uint64_t, Entry> Devices_;
+		std::vector<std::string> Owners_{""};
+		std::unordered_map<std::string, uint32_t> OwnerIds_{{"", 0}};
+		std::vector<ProvObjects::DeviceRules> RuleSets_;
+		std::unordered_map<std::string, uint32_t> RuleSetIds_;
+		bool Loaded_ = false;
+		bool Loading_ = false;
+		uint64_t LoadedAt_ = 0;
+		uint64_t Generation_ = 0; //	bumped when a reload renumbers the owners
+		std::unordered_map<uint64_t, std::optional<Device>> Journal_;
+
+		Entry Intern(const Device &D);
+	};
+
+	inline auto DeviceRulesIndex() { return DeviceRulesIndex::instance(); }
+
+} // namespace OpenWifi
@@ -4,11 +4,19 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <map>
+
+#include "Poco/ExpireLRUCache.h"
 #include "Poco/Net/IPAddress.h"
 
+#include "IPCountryDatabase.h"
 #include "framework/MicroServiceFuncs.h"
 #include "framework/SubSystemServer.h"
 
+#include "fmt/format.h"
 #include "nlohmann/json.hpp"
 
 namespace OpenWifi {
@@ -139,19 +147,46 @@ namespace OpenWifi {
 				Provider_ = IPLocationProvider<IPToCountryProvider, IPInfo, IPData, IP2Location>(
 					ProviderName_);
 				if (Provider_ != nullptr) {
-					Enabled_ = Provider_->Init();
+					RemoteEnabled_ = Provider_->Init();
 				}
 			}
 			Default_ = MicroServiceConfigGetString("iptocountry.default", "US");
+
+			auto DatabaseFile = MicroServiceConfigPath("iptocountry.local.file", "");
+			if (!DatabaseFile.empty()) {
+				std::string Error;
+				if (Local_.Load(DatabaseFile, Error)) {
+					poco_information(Logger(), fmt::format("Loaded {} ranges from {}.",
+														   Local_.Size(), DatabaseFile));
+				} else {
+					poco_warning(Logger(), fmt::format("Local database not loaded: {}", Error));
+				}
+			}
+			Enabled_ = RemoteEnabled_ || Local_.Loaded();
+
+			Cache_ = std::make_unique<Poco::ExpireLRUCache<std::string, std::string>>(
+				MicroServiceConfigGetInt("iptocountry.cache.size", 4096),
+				MicroServiceConfigGetInt("iptocountry.cache.expire", 86400) * 1000);
+			Parallel_ = std::max<std::size_t>(
+				1, MicroServiceConfigGetInt("iptocountry.lookup.parallel", 8));
 			return 0;
 		}
 
 		inline void Stop() final {
 			poco_notice(Logger(), "Stopping...");
-			//	Nothing to do - just to provide the same look at the others.
+			if (Cache_)
+				Cache_->clear();
 			poco_notice(Logger(), "Stopped...");
 		}
 
+		inline void Stats(Poco::JSON::Object &Answer) final {
+			Answer.set("localRanges", (uint64_t)Local_.Size());
+			Answer.set("cacheEntries", Cache_ ? (uint64_t)Cache_->size() : 0);
+			Answer.set("localHits", LocalHits_.load());
+			Answer.set("cacheHits", CacheHits_.load());
+			Answer.set("remoteCalls", RemoteCalls_.load());
+		}
+
 		[[nodiscard]] static inline std::string ReformatAddress(const std::string &I) {
 			if (I.substr(0, 7) == "::ffff:") {
 				std::string ip = I.substr(7);
@@ -169,26 +204,103 @@ namespace OpenWifi {
 		inline std::string Get(const std::string &IP) {
 			if (!Enabled_)
 				return Default_;
-			try {
-				std::string URL = Provider_->URI(IP).toString();
-				std::string Response;
-				if (Utils::wgets(URL, Response)) {
-					auto Answer = Provider_->Country(Response);
-					if (!Answer.empty())
-						return Answer;
+			std::string Country;
+			if (Lookup(IP, Country) || Remote(IP, Country))
+				return Country;
+			return Default_;
+		}
+
+		//	Resolves a list of addresses. Anything not answered by the local database or the cache
+		//	is sent to the remote provider, with up to iptocountry.lookup.parallel calls in flight.
+		inline Types::StringVec Get(const Types::StringVec &IPs) {
+			if (!Enabled_)
+				return Types::StringVec(IPs.size(), Default_);
+
+			Types::StringVec Countries(IPs.size());
+			std::map<std::string, std::vector<std::size_t>> Misses;
+			for (std::size_t i = 0; i < IPs.size(); ++i) {
+				if (!Lookup(IPs[i], Countries[i]))
+					Misses[IPs[i]].push_back(i);
+			}
+
+			if (!Misses.empty() && RemoteEnabled_) {
+				std::vector<std::pair<const std::string *, std::string>> Answers;
+				for (const auto &[IP, Positions] : Misses)
+					Answers.emplace_back(&IP, "");
+				auto Workers = std::min(Answers.size(), Parallel_);
+				std::vector<std::future<void>> Tasks;
+				for (std::size_t w = 0; w < Workers; ++w) {
+					Tasks.push_back(std::async(std::launch::async, [this, w, Workers, &Answers]() {
+						for (auto i = w; i < Answers.size(); i += Workers)
+							(void)Remote(*Answers[i].first, Answers[i].second);
+					}));
+				}
+				for (auto &Task : Tasks)
+					Task.wait();
+				for (const auto &[IP, Country] : Answers) {
+					for (auto Position : Misses[*IP])
+						Countries[Position] = Country;
 				}
-			} catch (...) {
 			}
-			return Default_;
+
+			for (auto &Country : Countries) {
+				if (Country.empty())
+					Country = Default_;
+			}
+			return Countries;
 		}
 
 		inline auto Enabled() const { return Enabled_; }
 
 	  private:
 		bool Enabled_ = false;
+		bool RemoteEnabled_ = false;
 		std::string Default_;
 		std::unique_ptr<IPToCountryProvider> Provider_;
 		std::string ProviderName_;
+		IPCountryDatabase Local_;
+		std::unique_ptr<Poco::ExpireLRUCache<std::string, std::string>> Cache_;
+		std::size_t Parallel_ = 8;
+		std::atomic_uint64_t LocalHits_ = 0;
+		std::atomic_uint64_t CacheHits_ = 0;
+		std::atomic_uint64_t RemoteCalls_ = 0;
+
+		inline bool Lookup(const std::string &IP, std::string &Country) {
+			if (Local_.Find(IP, Country)) {
+				++LocalHits_;
+				return true;
+			}
+			if (Cache_) {
+				auto Hit = Cache_->get(IP);
+				if (!Hit.isNull()) {
+					++CacheHits_;
+					Country = *Hit;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		inline bool Remote(const std::string &IP, std::string &Country) {
+			if (!RemoteEnabled_)
+				return false;
+			try {
+				++RemoteCalls_;
+				std::string URL = Provider_->URI(IP).toString();
+				std::string Response;
+				if (Utils::wgets(URL, Response)) {
+					auto Answer = Provider_->Country(Response);
+					if (!Answer.empty()) {
+						if (Cache_)
+							Cache_->update(IP, Answer);
+						Country = std::move(Answer);
+						return true;
+					}
+				}
+			} catch (...) {
+			}
+			return false;
+		}
 
 		FindCountryFromIP() noexcept : SubSystemServer("IpToCountry", "IPTOC-SVR", "iptocountry") {}
 	};
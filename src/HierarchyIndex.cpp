@@ -0,0 +1,267 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#include "HierarchyIndex.h"
+
+#include "Poco/JSON/Array.h"
+
+#include "StorageService.h"
+#include "framework/RESTAPI_utils.h"
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	void HierarchyIndex::SetEntity(const ProvObjects::Entity &E) {
+		Set(E.info.id, Node{false, E.info.name, E.parent, E.deviceRules});
+	}
+
+	void HierarchyIndex::SetVenue(const ProvObjects::Venue &V) {
+		Set(V.info.id, Node{true, V.info.name, V.parent.empty() ? V.entity : V.parent,
+							V.deviceRules});
+	}
+
+	void HierarchyIndex::Set(const std::string &Id, Node &&N) {
+		std::lock_guard G(Mutex_);
+		if (Loading_)
+			Journal_[Id] = N;
+		Unlink(Id);
+		Link(Id, N);
+		Nodes_[Id] = std::move(N);
+		Resolved_.clear();
+	}
+
+	void HierarchyIndex::Remove(const std::string &Id) {
+		std::lock_guard G(Mutex_);
+		if (Loading_)
+			Journal_[Id] = std::nullopt;
+		Unlink(Id);
+		Nodes_.erase(Id);
+		Resolved_.clear();
+	}
+
+	void HierarchyIndex::Invalidate() {
+		std::lock_guard G(Mutex_);
+		Loaded_ = false;
+	}
+
+	void HierarchyIndex::Link(const std::string &Id, const Node &N) {
+		if (!N.Up.empty())
+			(N.Venue ? Venues_ : Entities_)[N.Up].insert(Id);
+	}
+
+	void HierarchyIndex::Unlink(const std::string &Id) {
+		auto Hint = Nodes_.find(Id);
+		if (Hint == Nodes_.end() || Hint->second.Up.empty())
+			return;
+		auto &Children = Hint->second.Venue ? Venues_ : Entities_;
+		auto Siblings = Children.find(Hint->second.Up);
+		if (Siblings == Children.end())
+			return;
+		Siblings->second.erase(Id);
+		if (Siblings->second.empty())
+			Children.erase(Siblings);
+	}
+
+	void HierarchyIndex::Refresh() {
+		{
+			std::lock_guard G(Mutex_);
+			if (Loading_ || (Loaded_ && (Utils::Now() - LoadedAt_) <= ReloadInterval))
+				return;
+			Loading_ = true;
+			Journal_.clear();
+		}
+
+		std::map<std::string, Node> Nodes;
+		bool Success = Load(Nodes);
+
+		std::lock_guard G(Mutex_);
+		Loading_ = false;
+		if (!Success)
+			return;
+		for (auto &[Id, N] : Journal_) {
+			if (N.has_value())
+				Nodes[Id] = std::move(*N);
+			else
+				Nodes.erase(Id);
+		}
+		Journal_.clear();
+		Nodes_ = std::move(Nodes);
+		Entities_.clear();
+		Venues_.clear();
+		for (const auto &[Id, N] : Nodes_)
+			Link(Id, N);
+		Resolved_.clear();
+		Loaded_ = true;
+		LoadedAt_ = Utils::Now();
+	}
+
+	//	the hierarchy columns of every entity and venue, or of Id only
+	bool HierarchyIndex::Load(std::map<std::string, Node> &Nodes, const std::string &Id) {
+		std::vector<EntityHierarchyRecord> Entities;
+		std::vector<VenueHierarchyRecord> Venues;
+		try {
+			if (!StorageService()->EntityDB().GetHierarchyRecords(Entities, Id) ||
+				!StorageService()->VenueDB().GetHierarchyRecords(Venues, Id))
+				return false;
+		} catch (...) {
+			return false;
+		}
+		for (const auto &E : Entities) {
+			Nodes[E.get<0>()] =
+				Node{false, E.get<1>(), E.get<2>(),
+					 RESTAPI_utils::to_object<ProvObjects::DeviceRules>(E.get<3>())};
+		}
+		for (const auto &V : Venues) {
+			Nodes[V.get<0>()] =
+				Node{true, V.get<1>(), V.get<2>().empty() ? V.get<3>() : V.get<2>(),
+					 RESTAPI_utils::to_object<ProvObjects::DeviceRules>(V.get<4>())};
+		}
+		return true;
+	}
+
+	//	an id missing from the index may have been created since the last reload, possibly by
+	//	another instance: read it, and have the next Refresh pick up whatever else changed
+	bool HierarchyIndex::Fetch(const std::string &Id) {
+		{
+			std::lock_guard G(Mutex_);
+			if (Nodes_.find(Id) != Nodes_.end())
+				return true;
+		}
+		std::map<std::string, Node> Nodes;
+		if (Id.empty() || !Load(Nodes, Id) || Nodes.empty())
+			return false;
+		for (auto &[NodeId, N] : Nodes)
+			Set(NodeId, std::move(N));
+		Invalidate();
+		return true;
+	}
+
+	bool HierarchyIndex::Descendants(const std::string &Id, Types::UUIDvec_t &Entities,
+									 Types::UUIDvec_t &Venues) {
+		if (!Fetch(Id))
+			return false;
+		std::lock_guard G(Mutex_);
+		auto Hint = Nodes_.find(Id);
+		if (Hint == Nodes_.end())
+			return false;
+
+		//	breadth first; the visited set protects against a corrupt hierarchy with a cycle
+		std::set<std::string> Visited{Id};
+		std::vector<std::string> Pending{Id};
+		(Hint->second.Venue ? Venues : Entities).push_back(Id);
+		while (!Pending.empty()) {
+			auto Current = std::move(Pending.back());
+			Pending.pop_back();
+			for (auto *Children : {&Entities_, &Venues_}) {
+				auto C = Children->find(Current);
+				if (C == Children->end())
+					continue;
+				for (const auto &Child : C->second) {
+					if (!Visited.insert(Child).second)
+						continue;
+					(Children == &Venues_ ? Venues : Entities).push_back(Child);
+					Pending.push_back(Child);
+				}
+			}
+		}
+		return true;
+	}
+
+	bool HierarchyIndex::Ancestors(const std::string &Id, Types::UUIDvec_t &Chain) {
+		if (!Fetch(Id))
+			return false;
+		std::lock_guard G(Mutex_);
+		std::set<std::string> Visited;
+		for (auto Current = Id; !Current.empty() && Visited.insert(Current).second;) {
+			auto Hint = Nodes_.find(Current);
+			if (Hint == Nodes_.end())
+				break;
+			Chain.push_back(Current);
+			Current = Hint->second.Up;
+		}
+		return !Chain.empty();
+	}
+
+	bool HierarchyIndex::ApplyRules(const std::string &Id, ProvObjects::DeviceRules &Rules) {
+		ProvObjects::DeviceRules Effective;
+		EffectiveRules(Id, Effective);
+		return Storage::ApplyRules(Effective, Rules);
+	}
+
+	bool HierarchyIndex::EffectiveRules(const std::string &Id, ProvObjects::DeviceRules &Rules) {
+		if (!Fetch(Id))
+			return false;
+		std::lock_guard G(Mutex_);
+		if (Nodes_.find(Id) == Nodes_.end())
+			return false;
+		Rules = Resolve(Id);
+		return true;
+	}
+
+	//	each field takes the first value that is not "inherit" going up the chain
+	const ProvObjects::DeviceRules &HierarchyIndex::Resolve(const std::string &Id) {
+		auto Hint = Resolved_.find(Id);
+		if (Hint != Resolved_.end())
+			return Hint->second;
+
+		ProvObjects::DeviceRules Rules;
+		std::set<std::string> Visited;
+		for (auto Current = Id; !Current.empty() && Visited.insert(Current).second;) {
+			auto Known = Resolved_.find(Current);
+			if (Known != Resolved_.end()) {
+				Storage::ApplyRules(Known->second, Rules);
+				break;
+			}
+			auto N = Nodes_.find(Current);
+			if (N == Nodes_.end() || !Storage::ApplyRules(N->second.Rules, Rules))
+				break;
+			Current = N->second.Up;
+		}
+		return Resolved_[Id] = Rules;
+	}
+
+	bool HierarchyIndex::BuildTree(const std::string &Id, Poco::JSON::Object &Tree) {
+		if (!Fetch(Id))
+			return false;
+		std::lock_guard G(Mutex_);
+		if (Nodes_.find(Id) == Nodes_.end())
+			return false;
+		std::set<std::string> Visited;
+		AddToTree(Id, Tree, Visited);
+		return true;
+	}
+
+	void HierarchyIndex::AddToTree(const std::string &Id, Poco::JSON::Object &Tree,
+								   std::set<std::string> &Visited) {
+		const auto &N = Nodes_[Id];
+		Visited.insert(Id);
+
+		auto AddChildren = [&](const std::map<std::string, std::set<std::string>> &From,
+							   const char *Name) {
+			Poco::JSON::Array Children;
+			auto C = From.find(Id);
+			if (C != From.end()) {
+				for (const auto &Child : C->second) {
+					if (Visited.find(Child) != Visited.end())
+						continue;
+					Poco::JSON::Object O;
+					AddToTree(Child, O, Visited);
+					Children.add(O);
+				}
+			}
+			Tree.set(Name, Children);
+		};
+
+		Tree.set("type", N.Venue ? "venue" : "entity");
+		Tree.set("name", N.Name);
+		Tree.set("uuid", Id);
+		if (N.Venue) {
+			AddChildren(Venues_, "children");
+		} else {
+			AddChildren(Entities_, "children");
+			AddChildren(Venues_, "venues");
+		}
+	}
+
+} // namespace OpenWifi
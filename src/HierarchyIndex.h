@@ -0,0 +1,87 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+
+#include "Poco/JSON/Object.h"
+
+#include "RESTObjects/RESTAPI_ProvObjects.h"
+#include "framework/OpenWifiTypes.h"
+
+namespace OpenWifi {
+
+	/*
+	 * In-memory closure of the entity/venue hierarchy, built from the parent links of the records
+	 * (entity.parent, venue.parent, venue.entity). The entity and venue tables update it on every
+	 * create, update and delete, after the write succeeded. The storage service loads it at start
+	 * and calls Refresh from a timer: it reloads every ReloadInterval seconds to pick up changes
+	 * made by other instances, and soon after Invalidate. A lookup of an id the index does not
+	 * know reads that one record and invalidates the index, so objects created elsewhere are
+	 * found at once. Writes made while a reload reads the tables are journaled and replayed over
+	 * what it read, so a reload never undoes a newer write.
+	 */
+	class HierarchyIndex {
+	  public:
+		static constexpr uint64_t ReloadInterval = 300;
+
+		static auto instance() {
+			static auto instance_ = new HierarchyIndex;
+			return instance_;
+		}
+
+		void SetEntity(const ProvObjects::Entity &E);
+		void SetVenue(const ProvObjects::Venue &V);
+		void Remove(const std::string &Id);
+		void Invalidate();
+		//	reload from the tables if never loaded, invalidated, or older than ReloadInterval
+		void Refresh();
+
+		//	Id itself and all the entities and venues below it, at any depth
+		bool Descendants(const std::string &Id, Types::UUIDvec_t &Entities,
+						 Types::UUIDvec_t &Venues);
+		//	Id, then each parent up to the root. A venue chain continues with its entity.
+		bool Ancestors(const std::string &Id, Types::UUIDvec_t &Chain);
+		//	Resolve the inherited values of Rules along the ancestors of Id. True when some are left.
+		bool ApplyRules(const std::string &Id, ProvObjects::DeviceRules &Rules);
+		//	What Id and its ancestors set, "inherit" where none does. Cached until the next change.
+		bool EffectiveRules(const std::string &Id, ProvObjects::DeviceRules &Rules);
+		bool BuildTree(const std::string &Id, Poco::JSON::Object &Tree);
+
+	  private:
+		struct Node {
+			bool Venue = false;
+			std::string Name;
+			std::string Up; //	parent entity, parent venue, or the entity of a top venue
+			ProvObjects::DeviceRules Rules;
+		};
+
+		std::mutex Mutex_;
+		std::map<std::string, Node> Nodes_;
+		std::map<std::string, std::set<std::string>> Entities_; //	child entities per node
+		std::map<std::string, std::set<std::string>> Venues_;	//	child venues per node
+		std::map<std::string, ProvObjects::DeviceRules> Resolved_;
+		bool Loaded_ = false;
+		bool Loading_ = false;
+		uint64_t LoadedAt_ = 0;
+		std::map<std::string, std::optional<Node>> Journal_;
+
+		static bool Load(std::map<std::string, Node> &Nodes, const std::string &Id = "");
+		bool Fetch(const std::string &Id);
+		void Set(const std::string &Id, Node &&N);
+		void Link(const std::string &Id, const Node &N);
+		void Unlink(const std::string &Id);
+		const ProvObjects::DeviceRules &Resolve(const std::string &Id);
+		void AddToTree(const std::string &Id, Poco::JSON::Object &Tree,
+					   std::set<std::string> &Visited);
+	};
+
+	inline auto HierarchyIndex() { return HierarchyIndex::instance(); }
+
+} // namespace OpenWifi
@@ -0,0 +1,161 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#include "IPCountryDatabase.h"
+
+#include <algorithm>
+#include <cctype>
+#include <string_view>
+
+#include "Poco/File.h"
+#include "Poco/SharedMemory.h"
+
+#include "fmt/format.h"
+
+namespace OpenWifi {
+
+	static std::string_view TrimField(const char *Begin, const char *End) {
+		while (Begin < End && (*Begin == ' ' || *Begin == '\t' || *Begin == '"'))
+			++Begin;
+		while (End > Begin &&
+			   (End[-1] == ' ' || End[-1] == '\t' || End[-1] == '"' || End[-1] == '\r'))
+			--End;
+		return {Begin, (std::size_t)(End - Begin)};
+	}
+
+	static bool ParseDecimal(std::string_view F, CIDR::IPv128 &Value) {
+		if (F.empty())
+			return false;
+		CIDR::IPv128 V = 0;
+		for (auto c : F) {
+			if (c < '0' || c > '9')
+				return false;
+			unsigned Digit = c - '0';
+			if (V > (~(CIDR::IPv128)0 - Digit) / 10)
+				return false;
+			V = V * 10 + Digit;
+		}
+		Value = V;
+		return true;
+	}
+
+	//	Returns false on failure, sets IsInteger when the field was a plain decimal number
+	static bool ParseAddress(std::string_view F, CIDR::IPv128 &Value, bool &IsInteger) {
+		IsInteger = F.find_first_of(".:") == std::string_view::npos;
+		if (IsInteger)
+			return ParseDecimal(F, Value);
+		return CIDR::ToInteger(std::string(F), Value);
+	}
+
+	bool IPCountryDatabase::ParseLine(const char *Begin, const char *End, Range &R) {
+		std::array<std::string_view, 3> Fields;
+		std::size_t Count = 0;
+		for (auto Cur = Begin; Count < Fields.size();) {
+			auto Comma = std::find(Cur, End, ',');
+			Fields[Count++] = TrimField(Cur, Comma);
+			if (Comma == End)
+				break;
+			Cur = Comma + 1;
+		}
+		if (Count < 2 || Fields[0].empty() || Fields[0][0] == '#')
+			return false;
+
+		std::string_view Country;
+		if (Fields[0].find('/') != std::string_view::npos) {
+			CIDR::CompiledRangeVec Compiled;
+			if (!CIDR::CompileRange(std::string(Fields[0]), Compiled) || Compiled.size() != 1)
+				return false;
+			R.Start = Compiled[0].Start;
+			R.End = Compiled[0].End;
+			Country = Fields[1];
+		} else {
+			bool StartIsInteger, EndIsInteger;
+			if (Count < 3 || !ParseAddress(Fields[0], R.Start, StartIsInteger) ||
+				!ParseAddress(Fields[1], R.End, EndIsInteger) || StartIsInteger != EndIsInteger)
+				return false;
+			//	Integer IPv4 tables (ip2location DB1 IPv4) are moved into the IPv4-mapped space.
+			//	IPv6 tables already carry IPv4 as ::ffff:0:0/96, so their values are above 2^32.
+			if (StartIsInteger && R.End <= 0xffffffff) {
+				R.Start |= (IPv128)0xffff << 32;
+				R.End |= (IPv128)0xffff << 32;
+			}
+			Country = Fields[2];
+		}
+
+		if (R.Start > R.End || Country.size() != 2 || !std::isalpha((unsigned char)Country[0]) ||
+			!std::isalpha((unsigned char)Country[1]))
+			return false;
+		R.Country[0] = (char)std::toupper((unsigned char)Country[0]);
+		R.Country[1] = (char)std::toupper((unsigned char)Country[1]);
+		return true;
+	}
+
+	bool IPCountryDatabase::Load(const std::string &FileName, std::string &Error) {
+		Poco::File F(FileName);
+		if (!F.exists() || !F.isFile() || F.getSize() == 0) {
+			Error = fmt::format("File {} does not exist or is empty.", FileName);
+			return false;
+		}
+
+		std::vector<Range> Ranges;
+		try {
+			Poco::SharedMemory Map(F, Poco::SharedMemory::AM_READ);
+			const char *Cur = Map.begin(), *End = Map.end();
+			while (Cur < End) {
+				auto EOL = std::find(Cur, End, '\n');
+				Range R;
+				if (ParseLine(Cur, EOL, R))
+					Ranges.push_back(R);
+				Cur = EOL == End ? End : EOL + 1;
+			}
+		} catch (const Poco::Exception &E) {
+			Error = fmt::format("Could not map {}: {}", FileName, E.displayText());
+			return false;
+		}
+
+		if (Ranges.empty()) {
+			Error = fmt::format("File {} does not contain any usable range.", FileName);
+			return false;
+		}
+
+		//	Sort, clip ranges overlapping an earlier one to the part it does not cover, and merge
+		//	adjacent ranges of the same country so the table stays as small as possible.
+		std::sort(Ranges.begin(), Ranges.end(),
+				  [](const Range &A, const Range &B) { return A.Start < B.Start; });
+		std::size_t Out = 0;
+		for (std::size_t i = 1; i < Ranges.size(); ++i) {
+			auto &Last = Ranges[Out];
+			auto R = Ranges[i];
+			if (R.End <= Last.End)
+				continue;
+			if (R.Start <= Last.End)
+				R.Start = Last.End + 1;
+			if (R.Country == Last.Country && R.Start == Last.End + 1) {
+				Last.End = R.End;
+				continue;
+			}
+			Ranges[++Out] = R;
+		}
+		Ranges.resize(Out + 1);
+		Ranges.shrink_to_fit();
+		Ranges_ = std::move(Ranges);
+		return true;
+	}
+
+	bool IPCountryDatabase::Find(const std::string &IP, std::string &Country) const {
+		IPv128 Value;
+		if (Ranges_.empty() || !CIDR::ToInteger(IP, Value))
+			return false;
+		auto It = std::upper_bound(Ranges_.begin(), Ranges_.end(), Value,
+								   [](IPv128 V, const Range &R) { return V < R.Start; });
+		if (It == Ranges_.begin())
+			return false;
+		--It;
+		if (Value > It->End)
+			return false;
+		Country.assign(It->Country.data(), It->Country.size());
+		return true;
+	}
+
+} // namespace OpenWifi
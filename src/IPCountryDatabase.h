@@ -0,0 +1,45 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "framework/CIDR.h"
+
+namespace OpenWifi {
+
+	/*
+	 * Local IP to country table. The database file is memory-mapped while it is parsed into a
+	 * contiguous array of disjoint ranges sorted by start address; lookups are a binary search.
+	 * IPv4 addresses are keyed as IPv4-mapped IPv6 addresses, like everywhere else in CIDR.h.
+	 *
+	 * Accepted line formats (CSV, fields may be quoted, '#' starts a comment):
+	 *     start,end,country[,...]     addresses or decimal integers (ip2location DB1 layout)
+	 *     network/prefix,country
+	 */
+	class IPCountryDatabase {
+	  public:
+		using IPv128 = CIDR::IPv128;
+
+		struct Range {
+			IPv128 Start = 0;
+			IPv128 End = 0;
+			std::array<char, 2> Country{};
+		};
+
+		bool Load(const std::string &FileName, std::string &Error);
+		[[nodiscard]] bool Find(const std::string &IP, std::string &Country) const;
+		[[nodiscard]] inline auto Size() const { return Ranges_.size(); }
+		[[nodiscard]] inline bool Loaded() const { return !Ranges_.empty(); }
+
+	  private:
+		std::vector<Range> Ranges_;
+
+		static bool ParseLine(const char *Begin, const char *End, Range &R);
+	};
+
+} // namespace OpenWifi
@@ -0,0 +1,141 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#include "IPRangeIndex.h"
+
+#include <algorithm>
+
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	void IPRangeIndex::Set(const std::string &Id, const Types::StringVec &Ranges) {
+		CIDR::CompiledRangeVec Compiled;
+		(void)CIDR::CompileRanges(Ranges, Compiled);
+
+		std::lock_guard G(Mutex_);
+		auto Hint = Sources_.find(Id);
+		if (Compiled.empty()) {
+			if (Hint != Sources_.end()) {
+				Sources_.erase(Hint);
+				Dirty_ = true;
+			}
+			return;
+		}
+		if (Hint != Sources_.end() && Hint->second == Compiled)
+			return;
+		Sources_[Id] = std::move(Compiled);
+		Dirty_ = true;
+	}
+
+	void IPRangeIndex::Remove(const std::string &Id) {
+		std::lock_guard G(Mutex_);
+		if (Sources_.erase(Id) > 0)
+			Dirty_ = true;
+	}
+
+	void IPRangeIndex::Load(std::map<std::string, Types::StringVec> &&Sources) {
+		std::map<std::string, CIDR::CompiledRangeVec> Compiled;
+		for (const auto &[Id, Ranges] : Sources) {
+			CIDR::CompiledRangeVec C;
+			(void)CIDR::CompileRanges(Ranges, C);
+			if (!C.empty())
+				Compiled[Id] = std::move(C);
+		}
+
+		std::lock_guard G(Mutex_);
+		Sources_ = std::move(Compiled);
+		Dirty_ = true;
+		Loaded_ = true;
+		LoadedAt_ = Utils::Now();
+	}
+
+	void IPRangeIndex::AddPrefix(IPv128 Network, uint32_t Length, uint32_t Owner) {
+		uint32_t Node = 0;
+		for (uint32_t i = 0; i < Length; ++i) {
+			auto Bit = (uint32_t)((Network >> (127 - i)) & 1);
+			if (Trie_[Node].Child[Bit] == 0) {
+				Trie_[Node].Child[Bit] = Trie_.size();
+				Trie_.emplace_back();
+			}
+			Node = Trie_[Node].Child[Bit];
+		}
+		if (Trie_[Node].Owner < 0)
+			Trie_[Node].Owner = (int32_t)Owner;
+	}
+
+	void IPRangeIndex::Rebuild() {
+		Owners_.clear();
+		Trie_.clear();
+		Trie_.emplace_back();
+		Intervals_.clear();
+		MaxEnd_.clear();
+
+		for (const auto &[Id, Ranges] : Sources_) {
+			auto Owner = (uint32_t)Owners_.size();
+			Owners_.push_back(Id);
+			for (const auto &Range : Ranges) {
+				if (Range.Prefix > 0)
+					AddPrefix(Range.Start, Range.Prefix, Owner);
+				else
+					Intervals_.push_back(Interval{Range.Start, Range.End, Owner});
+			}
+		}
+
+		std::sort(Intervals_.begin(), Intervals_.end(),
+				  [](const Interval &A, const Interval &B) { return A.Start < B.Start; });
+		IPv128 MaxEnd = 0;
+		for (const auto &I : Intervals_) {
+			MaxEnd = std::max(MaxEnd, I.End);
+			MaxEnd_.push_back(MaxEnd);
+		}
+		Dirty_ = false;
+	}
+
+	bool IPRangeIndex::Find(const std::string &IP, std::string &Id) {
+		IPv128 Target;
+		if (!CIDR::ToInteger(IP, Target))
+			return false;
+
+		std::lock_guard G(Mutex_);
+		if (Dirty_)
+			Rebuild();
+
+		//	longest matching prefix in the trie
+		int32_t Best = Trie_[0].Owner;
+		uint32_t BestLength = 0;
+		uint32_t Node = 0;
+		for (uint32_t i = 0; i < 128; ++i) {
+			auto Bit = (uint32_t)((Target >> (127 - i)) & 1);
+			Node = Trie_[Node].Child[Bit];
+			if (Node == 0)
+				break;
+			if (Trie_[Node].Owner >= 0) {
+				Best = Trie_[Node].Owner;
+				BestLength = i + 1;
+			}
+		}
+		IPv128 BestSpan = BestLength == 0 ? ~(IPv128)0 : (((IPv128)1 << (128 - BestLength)) - 1);
+
+		//	narrowest interval containing the address. MaxEnd_ lets us stop as soon as no earlier
+		//	interval can reach the target.
+		auto It = std::upper_bound(
+			Intervals_.begin(), Intervals_.end(), Target,
+			[](const IPv128 &Value, const Interval &I) { return Value < I.Start; });
+		for (auto Index = (int64_t)(It - Intervals_.begin()) - 1;
+			 Index >= 0 && MaxEnd_[Index] >= Target; --Index) {
+			const auto &I = Intervals_[Index];
+			if (I.End >= Target && (Best < 0 || (I.End - I.Start) < BestSpan)) {
+				Best = (int32_t)I.Owner;
+				BestSpan = I.End - I.Start;
+			}
+		}
+
+		if (Best < 0)
+			return false;
+		Id = Owners_[Best];
+		return true;
+	}
+
+} // namespace OpenWifi
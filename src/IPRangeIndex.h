@@ -0,0 +1,62 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "framework/CIDR.h"
+#include "framework/OpenWifiTypes.h"
+
+namespace OpenWifi {
+
+	/*
+	 * In-memory index of the sourceIP ranges of venues or entities. IPv4 addresses are stored as
+	 * IPv4-mapped IPv6 addresses so both families share one 128-bit key space. CIDRs and single
+	 * addresses live in a binary radix trie, "a-b" ranges in a sorted interval list. When several
+	 * owners match, the most specific (smallest) range wins.
+	 */
+	class IPRangeIndex {
+	  public:
+		using IPv128 = CIDR::IPv128;
+
+		void Set(const std::string &Id, const Types::StringVec &Ranges);
+		void Remove(const std::string &Id);
+		void Load(std::map<std::string, Types::StringVec> &&Sources);
+		bool Find(const std::string &IP, std::string &Id);
+		[[nodiscard]] bool Loaded() const { return Loaded_; }
+		[[nodiscard]] uint64_t LoadedAt() const { return LoadedAt_; }
+		void Invalidate() { Loaded_ = false; }
+
+	  private:
+		struct TrieNode {
+			uint32_t Child[2]{0, 0};
+			int32_t Owner = -1;
+		};
+
+		struct Interval {
+			IPv128 Start = 0;
+			IPv128 End = 0;
+			uint32_t Owner = 0;
+		};
+
+		std::mutex Mutex_;
+		//	ranges are compiled once, when the owning record is loaded or written
+		std::map<std::string, CIDR::CompiledRangeVec> Sources_;
+		std::vector<std::string> Owners_;
+		std::vector<TrieNode> Trie_;
+		std::vector<Interval> Intervals_;
+		std::vector<IPv128> MaxEnd_;
+		bool Dirty_ = true;
+		bool Loaded_ = false;
+		uint64_t LoadedAt_ = 0;
+
+		void Rebuild();
+		void AddPrefix(IPv128 Network, uint32_t Length, uint32_t Owner);
+	};
+
+} // namespace OpenWifi
@@ -3,3 +3,120 @@
 //
 
 #include "Kafka_ProvUpdater.h"
+
+#include "fmt/format.h"
+#include "framework/MicroServiceFuncs.h"
+
+namespace OpenWifi {
+
+	int ProvisioningChangePublisher::Start() {
+		poco_information(Logger(), "Starting...");
+		Window_ = MicroServiceConfigGetInt("provisioning.changes.coalescing.window", 500);
+		{
+			std::lock_guard G(Mutex_);
+			Stopped_ = false;
+		}
+		if (Window_ > 0) {
+			TimerCallback_ = std::make_unique<Poco::TimerCallback<ProvisioningChangePublisher>>(
+				*this, &ProvisioningChangePublisher::onTimer);
+			Timer_.setStartInterval(Window_);
+			Timer_.setPeriodicInterval(Window_);
+			Timer_.start(*TimerCallback_);
+		}
+		return 0;
+	}
+
+	void ProvisioningChangePublisher::Stop() {
+		poco_information(Logger(), "Stopping...");
+		if (Window_ > 0) {
+			Timer_.stop();
+		}
+		{
+			//	handlers still draining post directly from now on; what came before is flushed
+			std::lock_guard G(Mutex_);
+			Stopped_ = true;
+		}
+		Flush();
+		poco_information(Logger(), "Stopped...");
+	}
+
+	void ProvisioningChangePublisher::onTimer([[maybe_unused]] Poco::Timer &timer) {
+		Utils::SetThreadName("prov-changes");
+		Flush();
+	}
+
+	void ProvisioningChangePublisher::Post(ProvisioningOperation Op, const std::string &Id,
+										   const std::string &ObjectType, SerializerFunc Serializer) {
+		{
+			std::lock_guard G(Mutex_);
+			Posted_++;
+			if (Window_ > 0 && !Stopped_) {
+				Queue(Op, Id, ObjectType, std::move(Serializer));
+				return;
+			}
+			Published_++;
+		}
+		Publish(PendingChange{Op, Id, ObjectType, std::move(Serializer)});
+	}
+
+	void ProvisioningChangePublisher::Queue(ProvisioningOperation Op, const std::string &Id,
+											const std::string &ObjectType,
+											SerializerFunc Serializer) {
+		if (Op == modification) {
+			auto Hint = Coalescible_.find(Id);
+			if (Hint != Coalescible_.end()) {
+				Hint->second->Serializer = std::move(Serializer);
+				Coalesced_++;
+				return;
+			}
+			Pending_.emplace_back(PendingChange{Op, Id, ObjectType, std::move(Serializer)});
+			Coalescible_[Id] = std::prev(Pending_.end());
+			return;
+		}
+
+		//	a creation or removal is a barrier: later modifications must not jump ahead of it
+		Coalescible_.erase(Id);
+		Pending_.emplace_back(PendingChange{Op, Id, ObjectType, std::move(Serializer)});
+	}
+
+	void ProvisioningChangePublisher::Flush() {
+		std::list<PendingChange> Changes;
+		{
+			std::lock_guard G(Mutex_);
+			Changes.swap(Pending_);
+			Coalescible_.clear();
+			Published_ += Changes.size();
+		}
+		for (const auto &Change : Changes) {
+			try {
+				Publish(Change);
+			} catch (const Poco::Exception &E) {
+				Logger().log(E);
+			} catch (...) {
+				poco_error(Logger(), fmt::format("Could not publish change for {}", Change.Id));
+			}
+		}
+	}
+
+	void ProvisioningChangePublisher::Publish(const PendingChange &Change) {
+		static const std::vector<std::string> Ops{"creation", "modification", "removal"};
+
+		Poco::JSON::Object Payload;
+		Change.Serializer(Payload);
+		Payload.set("ObjectType", Change.ObjectType);
+		std::ostringstream OS;
+		Payload.stringify(OS);
+		KafkaManager()->PostMessage(KafkaTopics::PROVISIONING_CHANGE, Ops[Change.Op],
+									std::make_shared<std::string>(OS.str()));
+	}
+
+	void ProvisioningChangePublisher::Stats(Poco::JSON::Object &Answer) {
+		std::lock_guard G(Mutex_);
+		Answer.set("window", Window_);
+		Answer.set("pending", Pending_.size());
+		Answer.set("posted", Posted_);
+		Answer.set("coalesced", Coalesced_);
+		Answer.set("published", Published_);
+	}
+
+} // namespace OpenWifi
@@ -4,18 +4,75 @@
 
 #pragma once
 
+#include <functional>
+#include <list>
+
+#include "Poco/Timer.h"
+
 #include "RESTObjects/RESTAPI_ProvObjects.h"
 #include "framework/KafkaManager.h"
 #include "framework/KafkaTopics.h"
+#include "framework/SubSystemServer.h"
 
 namespace OpenWifi {
 
 	enum ProvisioningOperation { creation = 0, modification, removal };
 
+	/*
+	 * Provisioning change messages are held for a short window so that repeated modifications of the
+	 * same object collapse into a single message carrying the latest state. Creations and removals are
+	 * never merged and keep their relative order with respect to the modifications around them.
+	 */
+	class ProvisioningChangePublisher : public SubSystemServer {
+	  public:
+		using SerializerFunc = std::function<void(Poco::JSON::Object &)>;
+
+		static auto instance() {
+			static auto instance_ = new ProvisioningChangePublisher;
+			return instance_;
+		}
+
+		int Start() override;
+		void Stop() override;
+		void Stats(Poco::JSON::Object &Answer) override;
+		void onTimer(Poco::Timer &timer);
+
+		void Post(ProvisioningOperation Op, const std::string &Id, const std::string &ObjectType,
+				  SerializerFunc Serializer);
+
+	  private:
+		struct PendingChange {
+			ProvisioningOperation Op;
+			std::string Id;
+			std::string ObjectType;
+			SerializerFunc Serializer;
+		};
+
+		std::list<PendingChange> Pending_;
+		std::map<std::string, std::list<PendingChange>::iterator> Coalescible_;
+		uint64_t Window_ = 0;
+		bool Stopped_ = false; //	no timer left to flush: changes are published as they come
+		uint64_t Posted_ = 0;
+		uint64_t Coalesced_ = 0;
+		uint64_t Published_ = 0;
+		Poco::Timer Timer_;
+		std::unique_ptr<Poco::TimerCallback<ProvisioningChangePublisher>> TimerCallback_;
+
+		void Flush();
+		//	with Mutex_ held
+		void Queue(ProvisioningOperation Op, const std::string &Id, const std::string &ObjectType,
+				   SerializerFunc Serializer);
+		static void Publish(const PendingChange &Change);
+
+		ProvisioningChangePublisher() noexcept
+			: SubSystemServer("ProvisioningChangePublisher", "PROV-CHANGES",
+							  "provisioning.changes") {}
+	};
+
+	inline auto ProvisioningChangePublisher() { return ProvisioningChangePublisher::instance(); }
+
 	template <typename ObjectType>
 	inline bool UpdateKafkaProvisioningObject(ProvisioningOperation op, const ObjectType &obj) {
-		static std::vector<std::string> Ops{"creation", "modification", "removal"};
-
 		std::string OT{"object"};
 		if constexpr (std::is_same_v<ObjectType, ProvObjects::Venue>) {
 			OT = "Venue";
@@ -36,13 +93,9 @@ namespace OpenWifi {
 			OT = "DeviceConfiguration";
 		}
 
-		Poco::JSON::Object Payload;
-		obj.to_json(Payload);
-		Payload.set("ObjectType", OT);
-		std::ostringstream OS;
-		Payload.stringify(OS);
-		KafkaManager()->PostMessage(KafkaTopics::PROVISIONING_CHANGE, Ops[op], std::make_shared<std::string>(OS.str()));
-
+		//	serialization is deferred until the change is actually published
+		ProvisioningChangePublisher()->Post(op, obj.info.id, OT,
+											[obj](Poco::JSON::Object &Payload) { obj.to_json(Payload); });
 		return true;
 	}
-} // namespace OpenWifi
\ No newline at end of file
+} // namespace OpenWifi
@@ -42,11 +42,19 @@ namespace OpenWifi {
 			Answer.set("entries", Inner);
 			return ReturnObject(Answer);
 		} else if (HasParameter("computedAffected", Arg) && Arg == "true") {
-			Types::UUIDvec_t DeviceSerialNumbers;
-			DB_.GetListOfAffectedDevices(UUID, DeviceSerialNumbers);
-			return ReturnObject("affectedDevices", DeviceSerialNumbers);
+			auto Generation = DB_.ChangeCounter() + StorageService()->InventoryDB().ChangeCounter() +
+							  StorageService()->VenueDB().ChangeCounter() +
+							  StorageService()->EntityDB().ChangeCounter();
+			return ReturnCachedObject(
+				"affectedDevices", Generation, [this, &UUID](Poco::JSON::Object &Answer) {
+					Types::UUIDvec_t DeviceSerialNumbers;
+					DB_.GetListOfAffectedDevices(UUID, DeviceSerialNumbers);
+					RESTAPI_utils::field_to_json(Answer, "affectedDevices", DeviceSerialNumbers);
+				});
 		} else if (QB_.AdditionalInfo) {
 			AddExtendedInfo(Existing, Answer);
+		} else if (RecordNotModified(DB_, UUID, Existing.info.modified)) {
+			return;
 		}
 		Existing.to_json(Answer);
 		ReturnObject(Answer);
@@ -149,59 +149,49 @@ namespace OpenWifi {
 
 	template <typename T>
 	void MakeJSONObjectArray(const char *ArrayName, const std::vector<T> &V, RESTAPIHandler &R) {
-		Poco::JSON::Array ObjArray;
-		for (const auto &i : V) {
-			Poco::JSON::Object Obj;
-			i.to_json(Obj);
-			if (R.NeedAdditionalInfo())
-				AddExtendedInfo(i, Obj);
-			ObjArray.add(Obj);
-		}
-		Poco::JSON::Object Answer;
-		Answer.set(ArrayName, ObjArray);
-		return R.ReturnObject(Answer);
+		R.ReturnJSONList(ArrayName, [&](RESTAPIHandler::JSONListStream &List) {
+			if constexpr (RESTAPI_utils::has_json_writer<T>::value) {
+				if (!R.NeedAdditionalInfo() && JSONWriter::Enabled) {
+					JSONWriter W;
+					for (const auto &i : V)
+						List.AddRaw(W.Write(i));
+					return;
+				}
+			}
+			for (const auto &i : V) {
+				Poco::JSON::Object Obj;
+				i.to_json(Obj);
+				if (R.NeedAdditionalInfo())
+					AddExtendedInfo(i, Obj);
+				List.Add(Obj);
+			}
+		});
 	}
 
 	inline static bool is_uuid(const std::string &u) { return u.find('-') != std::string::npos; }
 
 	template <typename DB>
 	void ReturnRecordList(const char *ArrayName, DB &DBInstance, RESTAPIHandler &R) {
-		Poco::JSON::Array ObjArr;
+		ProvObjects::InventoryTagVec Records;
 		for (const auto &i : R.SelectedRecords()) {
 			ProvObjects::InventoryTag E;
-			if (DBInstance.GetRecord(is_uuid(i) ? "id" : "serialNumber", i, E)) {
-				Poco::JSON::Object Obj;
-				E.to_json(Obj);
-				if (R.NeedAdditionalInfo())
-					AddExtendedInfo(E, Obj);
-				ObjArr.add(Obj);
-			} else {
+			if (!DBInstance.GetRecord(is_uuid(i) ? "id" : "serialNumber", i, E))
 				return R.BadRequest(RESTAPI::Errors::UnknownId);
-			}
+			Records.emplace_back(std::move(E));
 		}
-		Poco::JSON::Object Answer;
-		Answer.set(ArrayName, ObjArr);
-		return R.ReturnObject(Answer);
+		return MakeJSONObjectArray(ArrayName, Records, R);
 	}
 
 	template <typename DB, typename Record>
 	void ReturnRecordList(const char *ArrayName, DB &DBInstance, RESTAPIHandler &R) {
-		Poco::JSON::Array ObjArr;
+		std::vector<Record> Records;
 		for (const auto &i : R.SelectedRecords()) {
 			Record E;
-			if (DBInstance.GetRecord("id", i, E)) {
-				Poco::JSON::Object Obj;
-				E.to_json(Obj);
-				if (R.NeedAdditionalInfo())
-					AddExtendedInfo(E, Obj);
-				ObjArr.add(Obj);
-			} else {
+			if (!DBInstance.GetRecord("id", i, E))
 				return R.BadRequest(RESTAPI::Errors::UnknownId);
-			}
+			Records.emplace_back(std::move(E));
 		}
-		Poco::JSON::Object Answer;
-		Answer.set(ArrayName, ObjArr);
-		return R.ReturnObject(Answer);
+		return MakeJSONObjectArray(ArrayName, Records, R);
 	}
 
 	inline bool NormalizeMac(std::string &Mac) {
@@ -232,17 +222,36 @@ namespace OpenWifi {
 			AddLocationTriplet(i, IDs);
 	}
 
+	//	the entity chain comes from the hierarchy index; entities and locations are read in one
+	//	query each, and the locations are listed from the entity up to the root
 	inline void GetLocationsForEntity(const std::string &ID, std::vector<triplet_t> &IDs) {
-		ProvObjects::Entity Existing;
-		if (StorageService()->EntityDB().template GetRecord("id", ID, Existing)) {
-			if (!Existing.locations.empty()) {
-				AddLocationTriplet(Existing.locations, IDs);
-			}
-			if (!Existing.parent.empty()) {
-				GetLocationsForEntity(Existing.parent, IDs);
-			}
-			if (ID == EntityDB::RootUUID())
-				return;
+		Types::UUIDvec_t Chain;
+		EntityDB::RecordVec Entities;
+		if (!HierarchyIndex()->Ancestors(ID, Chain) ||
+			!StorageService()->EntityDB().GetRecordsIn("id", Chain, Entities))
+			return;
+		std::map<std::string, const ProvObjects::Entity *> EntityById;
+		for (const auto &E : Entities)
+			EntityById[E.info.id] = &E;
+
+		Types::UUIDvec_t LocationIds;
+		for (const auto &id : Chain) {
+			auto Hint = EntityById.find(id);
+			if (Hint != EntityById.end())
+				LocationIds.insert(LocationIds.end(), Hint->second->locations.begin(),
+								   Hint->second->locations.end());
+		}
+		LocationDB::RecordVec Locations;
+		if (!StorageService()->LocationDB().GetRecordsIn("id", LocationIds, Locations))
+			return;
+		std::map<std::string, const ProvObjects::Location *> LocationById;
+		for (const auto &L : Locations)
+			LocationById[L.info.id] = &L;
+		for (const auto &id : LocationIds) {
+			auto Hint = LocationById.find(id);
+			if (Hint != LocationById.end())
+				IDs.emplace_back(std::make_tuple(Hint->second->info.name,
+												 Hint->second->info.description, id));
 		}
 	}
 
@@ -287,6 +296,9 @@ namespace OpenWifi {
 			}
 		}
 
+		if (R.CollectionNotModified(DBInstance))
+			return;
+
 		if (!R.QB_.Select.empty()) {
 			return ReturnRecordList<decltype(DBInstance), RecType>(BlockName, DBInstance, R);
 		}
@@ -24,6 +24,9 @@ namespace OpenWifi {
 			return NotFound();
 		}
 
+		if (RecordNotModified(DB_, UUID, Existing.info.modified))
+			return;
+
 		Poco::JSON::Object Answer;
 		Existing.to_json(Answer);
 		if (NeedAdditionalInfo())
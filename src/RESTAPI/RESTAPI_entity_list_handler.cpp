@@ -13,15 +13,20 @@
 namespace OpenWifi {
 
 	void RESTAPI_entity_list_handler::DoGet() {
+		//	the tree also pulls in venues, so the entity table counter alone cannot validate it
+		if (!GetBoolParameter("getTree", false) && CollectionNotModified(DB_))
+			return;
+
 		if (!QB_.Select.empty()) {
 			return ReturnRecordList<decltype(DB_), ProvObjects::Entity>("entities", DB_, *this);
 		} else if (QB_.CountOnly) {
 			auto C = DB_.Count();
 			return ReturnCountOnly(C);
 		} else if (GetBoolParameter("getTree", false)) {
-			Poco::JSON::Object FullTree;
-			DB_.BuildTree(FullTree);
-			return ReturnObject(FullTree);
+			auto Generation = DB_.ChangeCounter() + StorageService()->VenueDB().ChangeCounter();
+			return ReturnCachedObject("entityTree", Generation, [this](Poco::JSON::Object &Tree) {
+				DB_.BuildTree(Tree);
+			});
 		} else {
 			EntityDB::RecordVec Entities;
 			DB_.GetRecords(QB_.Offset, QB_.Limit, Entities);
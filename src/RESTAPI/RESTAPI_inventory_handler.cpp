@@ -138,6 +138,8 @@ namespace OpenWifi {
 			return ReturnObject(Answer);
 		} else if (QB_.AdditionalInfo) {
 			AddExtendedInfo(Existing, Answer);
+		} else if (RecordNotModified(DB_, Existing.info.id, Existing.info.modified)) {
+			return;
 		}
 		Existing.to_json(Answer);
 		ReturnObject(Answer);
@@ -151,14 +153,20 @@ namespace OpenWifi {
 			return NotFound();
 		}
 
+		//	the references and the record go together or not at all
+		auto Work = StorageService()->UnitOfWork();
 		MoveUsage(StorageService()->PolicyDB(), DB_, Existing.managementPolicy, "",
 				  Existing.info.id);
+		MoveUsage(StorageService()->LocationDB(), DB_, Existing.location, "", Existing.info.id);
+		MoveUsage(StorageService()->ContactDB(), DB_, Existing.contact, "", Existing.info.id);
 		RemoveMembership(StorageService()->VenueDB(), &ProvObjects::Venue::configurations,
 						 Existing.venue, Existing.info.id);
 		RemoveMembership(StorageService()->EntityDB(), &ProvObjects::Entity::configurations,
 						 Existing.entity, Existing.info.id);
-		MoveUsage(StorageService()->LocationDB(), DB_, Existing.location, "", Existing.info.id);
-		MoveUsage(StorageService()->ContactDB(), DB_, Existing.contact, "", Existing.info.id);
+		RemoveMembership(StorageService()->EntityDB(), &ProvObjects::Entity::devices,
+						 Existing.entity, Existing.info.id);
+		RemoveMembership(StorageService()->VenueDB(), &ProvObjects::Venue::devices, Existing.venue,
+						 Existing.info.id);
 
 		if (!Existing.deviceConfiguration.empty()) {
 			ProvObjects::DeviceConfiguration DC;
@@ -172,18 +180,9 @@ namespace OpenWifi {
 						"id", Existing.deviceConfiguration, DB_.Prefix(), Existing.info.id);
 			}
 		}
-
-		MoveUsage(StorageService()->PolicyDB(), DB_, Existing.managementPolicy, "",
-				  Existing.info.id);
-		MoveUsage(StorageService()->LocationDB(), DB_, Existing.location, "", Existing.info.id);
-		MoveUsage(StorageService()->ContactDB(), DB_, Existing.contact, "", Existing.info.id);
-		MoveUsage(StorageService()->ConfigurationDB(), DB_, Existing.deviceConfiguration, "",
-				  Existing.info.id);
-		ManageMembership(StorageService()->EntityDB(), &ProvObjects::Entity::devices,
-						 Existing.entity, "", Existing.info.id);
-		ManageMembership(StorageService()->VenueDB(), &ProvObjects::Venue::devices, Existing.venue,
-						 "", Existing.info.id);
 		DB_.DeleteRecord("id", Existing.info.id);
+		if (!Work.Commit())
+			return InternalError(RESTAPI::Errors::CouldNotBeDeleted);
 		SerialNumberCache()->DeleteSerialNumber(SerialNumber);
 		return OK();
 	}
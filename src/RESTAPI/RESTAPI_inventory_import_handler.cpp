@@ -0,0 +1,321 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#include "RESTAPI_inventory_import_handler.h"
+
+#include <chrono>
+#include <future>
+
+#include "Poco/JSON/Parser.h"
+#include "Poco/String.h"
+
+#include "DeviceTypeCache.h"
+#include "RESTAPI/RESTAPI_db_helpers.h"
+#include "SerialNumberCache.h"
+#include "framework/MicroServiceFuncs.h"
+#include "sdks/SDK_gw.h"
+
+namespace OpenWifi {
+
+	//	concurrent ownership updates sent to the gateway
+	static constexpr std::size_t OwnershipWorkers = 8;
+
+	//	Splits one CSV line. Fields may be quoted, with "" standing for a quote inside a field.
+	static std::vector<std::string> SplitCSV(const std::string &Line) {
+		std::vector<std::string> Fields(1);
+		bool Quoted = false;
+		for (std::size_t i = 0; i < Line.size(); ++i) {
+			auto c = Line[i];
+			if (Quoted) {
+				if (c == '"' && i + 1 < Line.size() && Line[i + 1] == '"') {
+					Fields.back() += c;
+					++i;
+				} else if (c == '"') {
+					Quoted = false;
+				} else {
+					Fields.back() += c;
+				}
+			} else if (c == '"') {
+				Quoted = true;
+			} else if (c == ',') {
+				Fields.emplace_back();
+			} else {
+				Fields.back() += c;
+			}
+		}
+		for (auto &F : Fields)
+			Poco::trimInPlace(F);
+		return Fields;
+	}
+
+	template <typename Table>
+	static bool Exists(Table &DB, const std::string &Id, std::map<std::string, bool> &Known) {
+		auto Hint = Known.find(Id);
+		if (Hint != Known.end())
+			return Hint->second;
+		return Known[Id] = DB.Exists("id", Id);
+	}
+
+	//	the checks a single POST to /inventory/{serialNumber} makes before it writes
+	void RESTAPI_inventory_import_handler::Validate(const Poco::JSON::Object::Ptr &Obj, Row &R) {
+		auto &T = R.Tag;
+		if (!T.from_json(Obj)) {
+			R.Error = &RESTAPI::Errors::InvalidJSONDocument;
+		} else if (T.serialNumber.empty()) {
+			R.Error = &RESTAPI::Errors::MissingSerialNumber;
+		} else if (!NormalizeMac(T.serialNumber)) {
+			R.Error = &RESTAPI::Errors::InvalidSerialNumber;
+		} else if (Obj->has("deviceRules") && !ValidDeviceRules(T.deviceRules)) {
+			R.Error = &RESTAPI::Errors::InvalidRRM;
+		} else if (!Provisioning::DeviceClass::Validate(T.devClass.c_str())) {
+			R.Error = &RESTAPI::Errors::InvalidDeviceClass;
+		} else if (!ProvObjects::CreateObjectInfo(Obj, UserInfo_.userinfo, T.info)) {
+			R.Error = &RESTAPI::Errors::NameMustBeSet;
+		} else if (T.deviceType.empty() ||
+				   !DeviceTypeCache()->IsAcceptableDeviceType(T.deviceType)) {
+			R.Error = &RESTAPI::Errors::InvalidDeviceTypes;
+		} else if (EntityDB::IsRoot(T.entity) ||
+				   (!T.entity.empty() &&
+					!Exists(StorageService()->EntityDB(), T.entity, Entities_))) {
+			R.Error = &RESTAPI::Errors::ValidNonRootUUID;
+		} else if (!T.venue.empty() && !Exists(StorageService()->VenueDB(), T.venue, Venues_)) {
+			R.Error = &RESTAPI::Errors::VenueMustExist;
+		} else if (!T.venue.empty() && !T.entity.empty()) {
+			R.Error = &RESTAPI::Errors::NotBoth;
+		} else if (!T.location.empty() &&
+				   !Exists(StorageService()->LocationDB(), T.location, Locations_)) {
+			R.Error = &RESTAPI::Errors::LocationMustExist;
+		} else if (!T.contact.empty() &&
+				   !Exists(StorageService()->ContactDB(), T.contact, Contacts_)) {
+			R.Error = &RESTAPI::Errors::ContactMustExist;
+		} else if (!T.deviceConfiguration.empty() &&
+				   !Exists(StorageService()->ConfigurationDB(), T.deviceConfiguration,
+						   Configurations_)) {
+			R.Error = &RESTAPI::Errors::ConfigurationMustExist;
+		} else if (!T.managementPolicy.empty() &&
+				   !Exists(StorageService()->PolicyDB(), T.managementPolicy, Policies_)) {
+			R.Error = &RESTAPI::Errors::UnknownManagementPolicyUUID;
+		} else if (!Seen_.insert(T.serialNumber).second) {
+			//	listed twice in the same upload
+			R.Error = &RESTAPI::Errors::SerialNumberExists;
+		}
+		if (T.devClass.empty())
+			T.devClass = Provisioning::DeviceClass::ANY;
+	}
+
+	//	Writes the valid rows of a batch in one transaction. Rows whose serial number is already
+	//	in the inventory are rejected; if any write of the batch fails, every row of it is.
+	void RESTAPI_inventory_import_handler::Import(RowVec &Rows) {
+		std::vector<std::string> SerialNumbers;
+		for (const auto &R : Rows) {
+			if (R.Error == nullptr)
+				SerialNumbers.push_back(R.Tag.serialNumber);
+		}
+		if (SerialNumbers.empty())
+			return;
+
+		InventoryDB::RecordVec Existing;
+		DB_.GetRecordsIn("serialNumber", SerialNumbers, Existing);
+		std::set<std::string> Taken;
+		for (const auto &E : Existing)
+			Taken.insert(E.serialNumber);
+
+		auto Work = StorageService()->UnitOfWork();
+		InventoryDB::RecordVec Tags;
+		std::map<std::string, Types::UUIDvec_t> EntityDevices, VenueDevices, PolicyUsage,
+			LocationUsage, ContactUsage, ConfigurationUsage;
+		SerialNumbers.clear();
+		for (auto &R : Rows) {
+			if (R.Error != nullptr)
+				continue;
+			auto &T = R.Tag;
+			if (Taken.find(T.serialNumber) != Taken.end()) {
+				R.Error = &RESTAPI::Errors::SerialNumberExists;
+				continue;
+			}
+			//	created once for the whole import, as a single POST creates it for its device
+			if (!CreatedConfiguration_.empty())
+				T.deviceConfiguration = CreatedConfiguration_;
+			Tags.push_back(T);
+			SerialNumbers.push_back(T.serialNumber);
+			if (!T.entity.empty())
+				EntityDevices[T.entity].push_back(T.info.id);
+			if (!T.venue.empty())
+				VenueDevices[T.venue].push_back(T.info.id);
+			if (!T.managementPolicy.empty())
+				PolicyUsage[T.managementPolicy].push_back(T.info.id);
+			if (!T.location.empty())
+				LocationUsage[T.location].push_back(T.info.id);
+			if (!T.contact.empty())
+				ContactUsage[T.contact].push_back(T.info.id);
+			if (!T.deviceConfiguration.empty())
+				ConfigurationUsage[T.deviceConfiguration].push_back(T.info.id);
+		}
+		if (Tags.empty())
+			return;
+
+		bool Done = DB_.CreateRecords(Tags);
+		for (const auto &[Id, Devices] : PolicyUsage)
+			Done = Done && StorageService()->PolicyDB().AddInUse("id", Id, DB_.Prefix(), Devices);
+		for (const auto &[Id, Devices] : LocationUsage)
+			Done = Done && StorageService()->LocationDB().AddInUse("id", Id, DB_.Prefix(), Devices);
+		for (const auto &[Id, Devices] : ContactUsage)
+			Done = Done && StorageService()->ContactDB().AddInUse("id", Id, DB_.Prefix(), Devices);
+		for (const auto &[Id, Devices] : ConfigurationUsage)
+			Done = Done &&
+				   StorageService()->ConfigurationDB().AddInUse("id", Id, DB_.Prefix(), Devices);
+		Done = Done && StorageService()->EntityDB().AddMembers(&ProvObjects::Entity::devices,
+															   EntityDevices);
+		Done = Done &&
+			   StorageService()->VenueDB().AddMembers(&ProvObjects::Venue::devices, VenueDevices);
+		//	the unit rolls back when it is not committed
+		if (!Done || !Work.Commit()) {
+			for (auto &R : Rows) {
+				if (R.Error == nullptr)
+					R.Error = &RESTAPI::Errors::RecordNotCreated;
+			}
+			return;
+		}
+		SerialNumberCache()->AddSerialNumbers(SerialNumbers);
+		SetOwnership(Rows);
+	}
+
+	//	the gateway learns the owner of each new device, a few calls at a time
+	void RESTAPI_inventory_import_handler::SetOwnership(const RowVec &Rows) {
+		std::vector<std::future<void>> Workers;
+		for (std::size_t w = 0; w < OwnershipWorkers; ++w) {
+			Workers.push_back(std::async(std::launch::async, [this, w, &Rows]() {
+				for (std::size_t i = w; i < Rows.size(); i += OwnershipWorkers) {
+					const auto &R = Rows[i];
+					if (R.Error == nullptr)
+						SDK::GW::Device::SetOwnerShip(this, R.Tag.serialNumber, R.Tag.entity,
+													  R.Tag.venue, R.Tag.subscriber);
+				}
+			}));
+		}
+		for (auto &W : Workers)
+			W.wait();
+	}
+
+	void RESTAPI_inventory_import_handler::DoPost() {
+		const auto &ContentType = Request->getContentType();
+		bool CSV = ContentType.find("text/csv") != std::string::npos;
+		if (!CSV && ContentType.find("application/x-ndjson") == std::string::npos) {
+			return BadRequest(RESTAPI::Errors::UnrecognizedRequest);
+		}
+
+		//	the objects of the createObjects parameter are created once and shared by every
+		//	device of the import, all or nothing
+		{
+			ProvObjects::InventoryTag Template;
+			std::vector<std::string> Errors;
+			auto Work = StorageService()->UnitOfWork();
+			try {
+				CreateObjects(Template, *this, Errors);
+			} catch (...) {
+				Errors.emplace_back("Invalid createObjects parameter");
+			}
+			if (!Errors.empty() || !Work.Commit()) {
+				return BadRequest(RESTAPI::Errors::ConfigBlockInvalid);
+			}
+			CreatedConfiguration_ = Template.deviceConfiguration;
+		}
+		auto BatchSize =
+			std::max<uint64_t>(1, MicroServiceConfigGetInt("inventory.import.batch", 500));
+		auto MaxRows = MicroServiceConfigGetInt("inventory.import.maxrows", 50000);
+		auto Start = std::chrono::steady_clock::now();
+
+		uint64_t Line = 0, Imported = 0, Rejected = 0;
+		bool Truncated = false;
+		std::vector<std::string> Header;
+		Poco::JSON::Array Results;
+		RowVec Rows;
+		Rows.reserve(BatchSize);
+
+		auto Flush = [&]() {
+			Import(Rows);
+			for (const auto &R : Rows) {
+				Poco::JSON::Object Result;
+				Result.set("line", R.Line);
+				Result.set("serialNumber", R.Tag.serialNumber);
+				if (R.Error == nullptr) {
+					Result.set("status", "created");
+					Result.set("id", R.Tag.info.id);
+					Imported++;
+				} else {
+					Result.set("status", "rejected");
+					Result.set("errorCode", R.Error->err_num);
+					Result.set("errorText", R.Error->err_txt);
+					Rejected++;
+				}
+				Results.add(Result);
+			}
+			Rows.clear();
+		};
+
+		std::string Text;
+		auto &Body = Request->stream();
+		while (std::getline(Body, Text)) {
+			++Line;
+			Poco::trimInPlace(Text);
+			if (Text.empty())
+				continue;
+			if (CSV && Header.empty()) {
+				Header = SplitCSV(Text);
+				continue;
+			}
+			if (Imported + Rejected + Rows.size() == MaxRows) {
+				Truncated = true;
+				break;
+			}
+
+			Row R;
+			R.Line = Line;
+			Poco::JSON::Object::Ptr Obj;
+			try {
+				if (CSV) {
+					Obj = Poco::makeShared<Poco::JSON::Object>();
+					auto Fields = SplitCSV(Text);
+					for (std::size_t i = 0; i < Header.size() && i < Fields.size(); ++i) {
+						if (!Fields[i].empty())
+							Obj->set(Header[i], Fields[i]);
+					}
+				} else {
+					Poco::JSON::Parser P;
+					Obj = P.parse(Text).extract<Poco::JSON::Object::Ptr>();
+				}
+			} catch (...) {
+				Obj = nullptr;
+			}
+
+			if (Obj.isNull()) {
+				R.Error = &RESTAPI::Errors::InvalidJSONDocument;
+			} else {
+				//	an imported device is named after its serial number unless told otherwise
+				if (!Obj->has("name") && Obj->has("serialNumber"))
+					Obj->set("name", Obj->get("serialNumber"));
+				Validate(Obj, R);
+			}
+			Rows.push_back(std::move(R));
+			if (Rows.size() == BatchSize)
+				Flush();
+		}
+		Flush();
+
+		auto Elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+						   std::chrono::steady_clock::now() - Start)
+						   .count();
+		poco_information(Logger(),
+						 fmt::format("Inventory import by {}: {} created, {} rejected in {} ms.",
+									 UserInfo_.userinfo.email, Imported, Rejected, Elapsed));
+
+		Poco::JSON::Object Answer;
+		Answer.set("created", Imported);
+		Answer.set("rejected", Rejected);
+		Answer.set("truncated", Truncated);
+		Answer.set("results", Results);
+		return ReturnObject(Answer);
+	}
+
+} // namespace OpenWifi
@@ -0,0 +1,55 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#pragma once
+#include "StorageService.h"
+#include "framework/RESTAPI_Handler.h"
+
+namespace OpenWifi {
+
+	/*
+	 * Bulk creation of inventory devices. The body is streamed as NDJSON (one inventory object
+	 * per line) or as CSV with a header line naming the inventory fields. Lines are validated and
+	 * written in batches: one multi-row insert, one update of the venue and entity device lists and
+	 * of the usage of policies, locations, contacts and configurations, all in a single transaction
+	 * per batch. The answer reports the outcome of every line.
+	 */
+	class RESTAPI_inventory_import_handler : public RESTAPIHandler {
+	  public:
+		RESTAPI_inventory_import_handler(const RESTAPIHandler::BindingMap &bindings,
+										 Poco::Logger &L, RESTAPI_GenericServerAccounting &Server,
+										 uint64_t TransactionId, bool Internal)
+			: RESTAPIHandler(bindings, L,
+							 std::vector<std::string>{Poco::Net::HTTPRequest::HTTP_POST,
+													  Poco::Net::HTTPRequest::HTTP_OPTIONS},
+							 Server, TransactionId, Internal) {}
+		static auto PathName() { return std::list<std::string>{"/api/v1/inventory/import"}; };
+
+		//	one line of the upload and what became of it
+		struct Row {
+			uint64_t Line = 0;
+			ProvObjects::InventoryTag Tag;
+			const RESTAPI::Errors::msg *Error = nullptr;
+		};
+		typedef std::vector<Row> RowVec;
+
+	  private:
+		InventoryDB &DB_ = StorageService()->InventoryDB();
+		//	referenced ids already looked up during this import, per table
+		std::map<std::string, bool> Entities_, Venues_, Locations_, Contacts_, Configurations_,
+			Policies_;
+		std::set<std::string> Seen_;
+		//	the configuration created by the createObjects parameter, if any
+		std::string CreatedConfiguration_;
+
+		void DoGet() final{};
+		void DoPost() final;
+		void DoPut() final{};
+		void DoDelete() final{};
+
+		void Validate(const Poco::JSON::Object::Ptr &Obj, Row &R);
+		void Import(RowVec &Rows);
+		void SetOwnership(const RowVec &Rows);
+	};
+} // namespace OpenWifi
@@ -13,24 +13,25 @@
 namespace OpenWifi {
 	void RESTAPI_inventory_list_handler::SendList(const ProvObjects::InventoryTagVec &Tags,
 												  bool SerialOnly) {
-		Poco::JSON::Array Array;
-		for (const auto &i : Tags) {
-			if (SerialOnly) {
-				Array.add(i.serialNumber);
-			} else {
-				Poco::JSON::Object O;
-				i.to_json(O);
-				if (QB_.AdditionalInfo)
-					AddExtendedInfo(i, O);
-				Array.add(O);
+		ReturnJSONList(SerialOnly ? "serialNumbers" : "taglist", [&](JSONListStream &List) {
+			if (!SerialOnly && !QB_.AdditionalInfo && JSONWriter::Enabled) {
+				JSONWriter W;
+				for (const auto &i : Tags)
+					List.AddRaw(W.Write(i));
+				return;
 			}
-		}
-		Poco::JSON::Object Answer;
-		if (SerialOnly)
-			Answer.set("serialNumbers", Array);
-		else
-			Answer.set("taglist", Array);
-		ReturnObject(Answer);
+			for (const auto &i : Tags) {
+				if (SerialOnly) {
+					List.Add(i.serialNumber);
+				} else {
+					Poco::JSON::Object O;
+					i.to_json(O);
+					if (QB_.AdditionalInfo)
+						AddExtendedInfo(i, O);
+					List.Add(O);
+				}
+			}
+		});
 	}
 
 	void RESTAPI_inventory_list_handler::DoGet() {
@@ -51,6 +52,10 @@ namespace OpenWifi {
 			}
 		}
 
+		//	rrmOnly resolves rules through venues and entities, every other list reads only inventory
+		if (!GetBoolParameter("rrmOnly") && CollectionNotModified(DB_))
+			return;
+
 		if (!QB_.Select.empty()) {
 			return ReturnRecordList<decltype(DB_)>("taglist", DB_, *this);
 		} else if (HasParameter("entity", UUID)) {
@@ -121,13 +126,13 @@ namespace OpenWifi {
 			auto C = DB_.Count();
 			return ReturnCountOnly(C);
 		} else if (GetBoolParameter("rrmOnly")) {
-			Types::UUIDvec_t DeviceList;
-			DB_.GetRRMDeviceList(DeviceList);
-			if (QB_.CountOnly)
-				return ReturnCountOnly(DeviceList.size());
-			else {
-				return ReturnObject("serialNumbers", DeviceList);
-			}
+			auto Generation = DB_.ChangeCounter() + StorageService()->VenueDB().ChangeCounter() +
+							  StorageService()->EntityDB().ChangeCounter();
+			return ReturnCachedObject("rrmDevices", Generation, [this](Poco::JSON::Object &Answer) {
+				Types::UUIDvec_t DeviceList;
+				DB_.GetRRMDeviceList(DeviceList);
+				RESTAPI_utils::field_to_json(Answer, "serialNumbers", DeviceList);
+			});
 		} else {
 			ProvObjects::InventoryTagVec Tags;
 			DB_.GetRecords(QB_.Offset, QB_.Limit, Tags, "", OrderBy);
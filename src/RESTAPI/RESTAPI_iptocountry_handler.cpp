@@ -14,14 +14,15 @@ namespace OpenWifi {
 			return BadRequest(RESTAPI::Errors::MissingOrInvalidParameters);
 		}
 
-		auto IPAddresses = Poco::StringTokenizer(IPList, ",");
+		auto IPAddresses = Poco::StringTokenizer(IPList, ",", Poco::StringTokenizer::TOK_TRIM);
 		Poco::JSON::Object Answer;
 
 		Answer.set("enabled", FindCountryFromIP()->Enabled());
 		Poco::JSON::Array Countries;
 
-		for (const auto &i : IPAddresses) {
-			Countries.add(FindCountryFromIP()->Get(i));
+		Types::StringVec IPs(IPAddresses.begin(), IPAddresses.end());
+		for (const auto &i : FindCountryFromIP()->Get(IPs)) {
+			Countries.add(i);
 		}
 		Answer.set("countryCodes", Countries);
 
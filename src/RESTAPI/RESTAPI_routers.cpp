@@ -10,6 +10,7 @@
 #include "RESTAPI/RESTAPI_entity_handler.h"
 #include "RESTAPI/RESTAPI_entity_list_handler.h"
 #include "RESTAPI/RESTAPI_inventory_handler.h"
+#include "RESTAPI/RESTAPI_inventory_import_handler.h"
 #include "RESTAPI/RESTAPI_inventory_list_handler.h"
 #include "RESTAPI/RESTAPI_iptocountry_handler.h"
 #include "RESTAPI/RESTAPI_location_handler.h"
@@ -50,7 +51,8 @@ namespace OpenWifi {
             RESTAPI_entity_handler, RESTAPI_entity_list_handler,
 			RESTAPI_contact_handler, RESTAPI_contact_list_handler, RESTAPI_location_handler,
 			RESTAPI_location_list_handler, RESTAPI_venue_handler, RESTAPI_venue_list_handler,
-			RESTAPI_inventory_handler, RESTAPI_inventory_list_handler,
+			RESTAPI_inventory_import_handler, RESTAPI_inventory_handler,
+			RESTAPI_inventory_list_handler,
 			RESTAPI_managementPolicy_handler, RESTAPI_managementPolicy_list_handler,
 			RESTAPI_managementRole_list_handler, RESTAPI_configurations_handler,
 			RESTAPI_configurations_list_handler, RESTAPI_map_handler, RESTAPI_map_list_handler,
@@ -72,7 +74,8 @@ namespace OpenWifi {
             RESTAPI_entity_list_handler,
 			RESTAPI_contact_handler, RESTAPI_contact_list_handler, RESTAPI_location_handler,
 			RESTAPI_location_list_handler, RESTAPI_venue_handler, RESTAPI_venue_list_handler,
-			RESTAPI_inventory_handler, RESTAPI_inventory_list_handler,
+			RESTAPI_inventory_import_handler, RESTAPI_inventory_handler,
+			RESTAPI_inventory_list_handler,
 			RESTAPI_managementPolicy_handler, RESTAPI_managementPolicy_list_handler,
 			RESTAPI_managementRole_list_handler, RESTAPI_configurations_handler,
 			RESTAPI_configurations_list_handler, RESTAPI_map_handler, RESTAPI_map_list_handler,
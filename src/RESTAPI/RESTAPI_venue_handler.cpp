@@ -22,36 +22,19 @@
 namespace OpenWifi {
 
 	static Types::UUIDvec_t GetDevices(const ProvObjects::Venue &V, bool GetChildren) {
-		Types::UUIDvec_t R;
-		std::copy(V.devices.begin(), V.devices.end(), std::back_inserter(R));
-		if (GetChildren) {
-			for (const auto &i : V.children) {
-				ProvObjects::Venue V2;
-				if (StorageService()->VenueDB().GetRecord("id", i, V2)) {
-					std::copy(V2.devices.begin(), V2.devices.end(), std::back_inserter(R));
-					auto LowerDevs = GetDevices(V2, GetChildren);
-					std::copy(LowerDevs.begin(), LowerDevs.end(), std::back_inserter(R));
-				}
-			}
-		}
-
-		std::sort(R.begin(), R.end());
-		auto Last = std::unique(R.begin(), R.end());
-		R.erase(Last, R.end());
+		InventoryDB::RecordVec Devices;
+		StorageService()->InventoryDB().GetDevicesUnder(V.info.id, Devices, GetChildren);
 
 		std::vector<std::string> SerialNumbers;
-
-		for (const auto &device : R) {
-			ProvObjects::InventoryTag IT;
-			if (StorageService()->InventoryDB().GetRecord("id", device, IT)) {
-				SerialNumbers.push_back(IT.serialNumber);
-			}
-		}
-
+		for (const auto &device : Devices)
+			SerialNumbers.push_back(device.serialNumber);
+		std::sort(SerialNumbers.begin(), SerialNumbers.end());
 		return SerialNumbers;
 	}
 
 	void RESTAPI_venue_handler::DoGet() {
+		//	taken before Existing is read, so a concurrent change cannot be cached as current
+		auto Generation = DB_.ChangeCounter() + StorageService()->InventoryDB().ChangeCounter();
 		std::string UUID = GetBinding("uuid", "");
 		ProvObjects::Venue Existing;
 		if (UUID.empty() || !DB_.GetRecord("id", UUID, Existing)) {
@@ -59,16 +42,20 @@ namespace OpenWifi {
 		}
 
 		if (GetBoolParameter("getDevices")) {
-			ProvObjects::VenueDeviceList VDL;
-			VDL.id = Existing.info.id;
-			VDL.name = Existing.info.name;
-			VDL.description = Existing.info.description;
-			auto GetChildren = GetBoolParameter("getChildren");
-			VDL.devices = GetDevices(Existing, GetChildren);
-			Poco::JSON::Object Answer;
-			VDL.to_json(Answer);
-			return ReturnObject(Answer);
-		}
+			return ReturnCachedObject(
+				"venueDevices", Generation, [this, &Existing](Poco::JSON::Object &Answer) {
+					ProvObjects::VenueDeviceList VDL;
+					VDL.id = Existing.info.id;
+					VDL.name = Existing.info.name;
+					VDL.description = Existing.info.description;
+					auto GetChildren = GetBoolParameter("getChildren");
+					VDL.devices = GetDevices(Existing, GetChildren);
+					VDL.to_json(Answer);
+				});
+		}
+
+		if (RecordNotModified(DB_, UUID, Existing.info.modified))
+			return;
 
 		Poco::JSON::Object Answer;
 		if (QB_.AdditionalInfo)
@@ -89,6 +76,8 @@ namespace OpenWifi {
 			return BadRequest(RESTAPI::Errors::StillInUse);
 		}
 
+		//	the references and the record go together or not at all
+		auto Work = StorageService()->UnitOfWork();
 		if (!Existing.contacts.empty()) {
 			for (const auto &contact_uuid : Existing.contacts)
 				StorageService()->ContactDB().DeleteInUse(
@@ -110,6 +99,8 @@ namespace OpenWifi {
 		if (!Existing.entity.empty())
 			StorageService()->EntityDB().DeleteVenue("id", Existing.entity, UUID);
 		DB_.DeleteRecord("id", UUID);
+		if (!Work.Commit())
+			return InternalError(RESTAPI::Errors::CouldNotBeDeleted);
 
 		UpdateKafkaProvisioningObject(ProvisioningOperation::removal, Existing);
 
@@ -7,35 +7,46 @@
 //
 
 #include "RESTAPI_ProvObjects.h"
+
+#include <sstream>
+
+#include "Poco/JSON/Stringifier.h"
+
+#include "fmt/format.h"
 #include "framework/MicroServiceFuncs.h"
+#include "framework/RESTAPI_FieldTable.h"
 #include "framework/RESTAPI_utils.h"
 #include "framework/utils.h"
 
+using OpenWifi::RESTAPI_utils::Embedded;
+using OpenWifi::RESTAPI_utils::Field;
 using OpenWifi::RESTAPI_utils::field_from_json;
 using OpenWifi::RESTAPI_utils::field_to_json;
+using OpenWifi::RESTAPI_utils::fields_from_json;
+using OpenWifi::RESTAPI_utils::fields_to_json;
 
 namespace OpenWifi::ProvObjects {
 
+	static constexpr auto ObjectInfoFields = std::make_tuple(
+		Field("id", &ObjectInfo::id),
+		Field("name", &ObjectInfo::name),
+		Field("description", &ObjectInfo::description),
+		Field("created", &ObjectInfo::created),
+		Field("modified", &ObjectInfo::modified),
+		Field("notes", &ObjectInfo::notes),
+		Field("tags", &ObjectInfo::tags));
+
 	void ObjectInfo::to_json(Poco::JSON::Object &Obj) const {
-		field_to_json(Obj, "id", id);
-		field_to_json(Obj, "name", name);
-		field_to_json(Obj, "description", description);
-		field_to_json(Obj, "created", created);
-		field_to_json(Obj, "modified", modified);
-		field_to_json(Obj, "notes", notes);
-		field_to_json(Obj, "tags", tags);
+		fields_to_json(Obj, *this, ObjectInfoFields);
+	}
+
+	void ObjectInfo::to_json(JSONWriter &W) const {
+		fields_to_json(W, *this, ObjectInfoFields);
 	}
 
 	bool ObjectInfo::from_json(const Poco::JSON::Object::Ptr &Obj) {
 		try {
-			field_from_json(Obj, "id", id);
-			field_from_json(Obj, "name", name);
-			field_from_json(Obj, "description", description);
-			field_from_json(Obj, "created", created);
-			field_from_json(Obj, "modified", modified);
-			field_from_json(Obj, "notes", notes);
-			field_from_json(Obj, "tags", tags);
-			return true;
+			return fields_from_json(Obj, *this, ObjectInfoFields);
 		} catch (...) {
 		}
 		return false;
@@ -79,110 +90,92 @@ namespace OpenWifi::ProvObjects {
 		return false;
 	}
 
+	static constexpr auto EntityFields = std::make_tuple(
+		Embedded(&Entity::info),
+		Field("parent", &Entity::parent),
+		Field("venues", &Entity::venues),
+		Field("children", &Entity::children),
+		Field("contacts", &Entity::contacts),
+		Field("locations", &Entity::locations),
+		Field("managementPolicy", &Entity::managementPolicy),
+		Field("deviceConfiguration", &Entity::deviceConfiguration),
+		Field("devices", &Entity::devices),
+		Field("deviceRules", &Entity::deviceRules),
+		Field("sourceIP", &Entity::sourceIP),
+		Field("variables", &Entity::variables),
+		Field("managementPolicies", &Entity::managementPolicies),
+		Field("managementRoles", &Entity::managementRoles),
+		Field("maps", &Entity::maps),
+		Field("configurations", &Entity::configurations));
+
 	void Entity::to_json(Poco::JSON::Object &Obj) const {
-		info.to_json(Obj);
-		field_to_json(Obj, "parent", parent);
-		field_to_json(Obj, "venues", venues);
-		field_to_json(Obj, "children", children);
-		field_to_json(Obj, "contacts", contacts);
-		field_to_json(Obj, "locations", locations);
-		field_to_json(Obj, "managementPolicy", managementPolicy);
-		field_to_json(Obj, "deviceConfiguration", deviceConfiguration);
-		field_to_json(Obj, "devices", devices);
-		field_to_json(Obj, "deviceRules", deviceRules);
-		field_to_json(Obj, "sourceIP", sourceIP);
-		field_to_json(Obj, "variables", variables);
-		field_to_json(Obj, "managementPolicies", managementPolicies);
-		field_to_json(Obj, "managementRoles", managementRoles);
-		field_to_json(Obj, "maps", maps);
-		field_to_json(Obj, "configurations", configurations);
+		fields_to_json(Obj, *this, EntityFields);
+	}
+
+	void Entity::to_json(JSONWriter &W) const {
+		fields_to_json(W, *this, EntityFields);
 	}
 
 	bool Entity::from_json(const Poco::JSON::Object::Ptr &Obj) {
 		try {
-			info.from_json(Obj);
-			field_from_json(Obj, "parent", parent);
-			field_from_json(Obj, "venues", venues);
-			field_from_json(Obj, "children", children);
-			field_from_json(Obj, "contacts", contacts);
-			field_from_json(Obj, "locations", locations);
-			field_from_json(Obj, "managementPolicy", managementPolicy);
-			field_from_json(Obj, "deviceConfiguration", deviceConfiguration);
-			field_from_json(Obj, "devices", devices);
-			field_from_json(Obj, "deviceRules", deviceRules);
-			field_from_json(Obj, "sourceIP", sourceIP);
-			field_from_json(Obj, "variables", variables);
-			field_from_json(Obj, "managementPolicies", managementPolicies);
-			field_from_json(Obj, "managementRoles", managementRoles);
-			field_from_json(Obj, "maps", maps);
-			field_from_json(Obj, "configurations", configurations);
-			return true;
+			return fields_from_json(Obj, *this, EntityFields);
 		} catch (...) {
 		}
 		return false;
 	}
 
+	static constexpr auto DiGraphEntryFields = std::make_tuple(
+		Field("parent", &DiGraphEntry::parent),
+		Field("child", &DiGraphEntry::child));
+
 	void DiGraphEntry::to_json(Poco::JSON::Object &Obj) const {
-		field_to_json(Obj, "parent", parent);
-		field_to_json(Obj, "child", child);
+		fields_to_json(Obj, *this, DiGraphEntryFields);
+	}
+
+	void DiGraphEntry::to_json(JSONWriter &W) const {
+		fields_to_json(W, *this, DiGraphEntryFields);
 	}
 
 	bool DiGraphEntry::from_json(const Poco::JSON::Object::Ptr &Obj) {
 		try {
-			field_from_json(Obj, "parent", parent);
-			field_from_json(Obj, "child", child);
-			return true;
+			return fields_from_json(Obj, *this, DiGraphEntryFields);
 		} catch (...) {
 		}
 		return false;
 	}
 
+	static constexpr auto VenueFields = std::make_tuple(
+		Embedded(&Venue::info),
+		Field("parent", &Venue::parent),
+		Field("entity", &Venue::entity),
+		Field("children", &Venue::children),
+		Field("devices", &Venue::devices),
+		Field("topology", &Venue::topology),
+		Field("design", &Venue::design),
+		Field("managementPolicy", &Venue::managementPolicy),
+		Field("deviceConfiguration", &Venue::deviceConfiguration),
+		Field("contacts", &Venue::contacts),
+		Field("location", &Venue::location),
+		Field("deviceRules", &Venue::deviceRules),
+		Field("sourceIP", &Venue::sourceIP),
+		Field("variables", &Venue::variables),
+		Field("managementPolicies", &Venue::managementPolicies),
+		Field("managementRoles", &Venue::managementRoles),
+		Field("maps", &Venue::maps),
+		Field("configurations", &Venue::configurations),
+		Field("boards", &Venue::boards));
+
 	void Venue::to_json(Poco::JSON::Object &Obj) const {
-		info.to_json(Obj);
-		field_to_json(Obj, "parent", parent);
-		field_to_json(Obj, "entity", entity);
-		field_to_json(Obj, "children", children);
-		field_to_json(Obj, "devices", devices);
-		field_to_json(Obj, "topology", topology);
-		field_to_json(Obj, "parent", parent);
-		field_to_json(Obj, "design", design);
-		field_to_json(Obj, "managementPolicy", managementPolicy);
-		field_to_json(Obj, "deviceConfiguration", deviceConfiguration);
-		field_to_json(Obj, "contacts", contacts);
-		field_to_json(Obj, "location", location);
-		field_to_json(Obj, "deviceRules", deviceRules);
-		field_to_json(Obj, "sourceIP", sourceIP);
-		field_to_json(Obj, "variables", variables);
-		field_to_json(Obj, "managementPolicies", managementPolicies);
-		field_to_json(Obj, "managementRoles", managementRoles);
-		field_to_json(Obj, "maps", maps);
-		field_to_json(Obj, "configurations", configurations);
-		field_to_json(Obj, "boards", boards);
+		fields_to_json(Obj, *this, VenueFields);
+	}
+
+	void Venue::to_json(JSONWriter &W) const {
+		fields_to_json(W, *this, VenueFields);
 	}
 
 	bool Venue::from_json(const Poco::JSON::Object::Ptr &Obj) {
 		try {
-			info.from_json(Obj);
-			field_from_json(Obj, "parent", parent);
-			field_from_json(Obj, "entity", entity);
-			field_from_json(Obj, "children", children);
-			field_from_json(Obj, "devices", devices);
-			field_from_json(Obj, "topology", topology);
-			field_from_json(Obj, "parent", parent);
-			field_from_json(Obj, "design", design);
-			field_from_json(Obj, "managementPolicy", managementPolicy);
-			field_from_json(Obj, "deviceConfiguration", deviceConfiguration);
-			field_from_json(Obj, "contacts", contacts);
-			field_from_json(Obj, "location", location);
-			field_from_json(Obj, "deviceRules", deviceRules);
-			field_from_json(Obj, "sourceIP", sourceIP);
-			field_from_json(Obj, "variables", variables);
-			field_from_json(Obj, "managementPolicies", managementPolicies);
-			field_from_json(Obj, "managementRoles", managementRoles);
-			field_from_json(Obj, "maps", maps);
-			field_from_json(Obj, "configurations", configurations);
-			field_from_json(Obj, "boards", boards);
-			return true;
+			return fields_from_json(Obj, *this, VenueFields);
 		} catch (...) {
 		}
 		return false;
@@ -388,32 +381,29 @@ namespace OpenWifi::ProvObjects {
 		return false;
 	}
 
+	static constexpr auto SubLocationFields = std::make_tuple(
+		Field("type", &SubLocation::type),
+		Field("buildingName", &SubLocation::buildingName),
+		Field("addressLines", &SubLocation::addressLines),
+		Field("city", &SubLocation::city),
+		Field("state", &SubLocation::state),
+		Field("postal", &SubLocation::postal),
+		Field("country", &SubLocation::country),
+		Field("phones", &SubLocation::phones),
+		Field("mobiles", &SubLocation::mobiles),
+		Field("geoCode", &SubLocation::geoCode));
+
 	void SubLocation::to_json(Poco::JSON::Object &Obj) const {
-		field_to_json(Obj, "type", type);
-		field_to_json(Obj, "buildingName", buildingName);
-		field_to_json(Obj, "addressLines", addressLines);
-		field_to_json(Obj, "city", city);
-		field_to_json(Obj, "state", state);
-		field_to_json(Obj, "postal", postal);
-		field_to_json(Obj, "country", country);
-		field_to_json(Obj, "phones", phones);
-		field_to_json(Obj, "mobiles", mobiles);
-		field_to_json(Obj, "geoCode", geoCode);
+		fields_to_json(Obj, *this, SubLocationFields);
+	}
+
+	void SubLocation::to_json(JSONWriter &W) const {
+		fields_to_json(W, *this, SubLocationFields);
 	}
 
 	bool SubLocation::from_json(const Poco::JSON::Object::Ptr &Obj) {
 		try {
-			field_from_json(Obj, "type", type);
-			field_from_json(Obj, "buildingName", buildingName);
-			field_from_json(Obj, "addressLines", addressLines);
-			field_from_json(Obj, "city", city);
-			field_from_json(Obj, "state", state);
-			field_from_json(Obj, "postal", postal);
-			field_from_json(Obj, "country", country);
-			field_from_json(Obj, "phones", phones);
-			field_from_json(Obj, "mobiles", mobiles);
-			field_from_json(Obj, "geoCode", geoCode);
-			return true;
+			return fields_from_json(Obj, *this, SubLocationFields);
 		} catch (...) {
 		}
 		return false;
@@ -520,36 +510,31 @@ namespace OpenWifi::ProvObjects {
 		return false;
 	}
 
+	static constexpr auto SubContactFields = std::make_tuple(
+		Field("type", &SubContact::type),
+		Field("title", &SubContact::title),
+		Field("salutation", &SubContact::salutation),
+		Field("firstname", &SubContact::firstname),
+		Field("lastname", &SubContact::lastname),
+		Field("initials", &SubContact::initials),
+		Field("visual", &SubContact::visual),
+		Field("mobiles", &SubContact::mobiles),
+		Field("phones", &SubContact::phones),
+		Field("primaryEmail", &SubContact::primaryEmail),
+		Field("secondaryEmail", &SubContact::secondaryEmail),
+		Field("accessPIN", &SubContact::accessPIN));
+
 	void SubContact::to_json(Poco::JSON::Object &Obj) const {
-		field_to_json(Obj, "type", type);
-		field_to_json(Obj, "title", title);
-		field_to_json(Obj, "salutation", salutation);
-		field_to_json(Obj, "firstname", firstname);
-		field_to_json(Obj, "lastname", lastname);
-		field_to_json(Obj, "initials", initials);
-		field_to_json(Obj, "visual", visual);
-		field_to_json(Obj, "mobiles", mobiles);
-		field_to_json(Obj, "phones", phones);
-		field_to_json(Obj, "primaryEmail", primaryEmail);
-		field_to_json(Obj, "secondaryEmail", secondaryEmail);
-		field_to_json(Obj, "accessPIN", accessPIN);
+		fields_to_json(Obj, *this, SubContactFields);
+	}
+
+	void SubContact::to_json(JSONWriter &W) const {
+		fields_to_json(W, *this, SubContactFields);
 	}
 
 	bool SubContact::from_json(const Poco::JSON::Object::Ptr &Obj) {
 		try {
-			field_from_json(Obj, "type", type);
-			field_from_json(Obj, "title", title);
-			field_from_json(Obj, "salutation", salutation);
-			field_from_json(Obj, "firstname", firstname);
-			field_from_json(Obj, "lastname", lastname);
-			field_from_json(Obj, "initials", initials);
-			field_from_json(Obj, "visual", visual);
-			field_from_json(Obj, "mobiles", mobiles);
-			field_from_json(Obj, "phones", phones);
-			field_from_json(Obj, "primaryEmail", primaryEmail);
-			field_from_json(Obj, "secondaryEmail", secondaryEmail);
-			field_from_json(Obj, "accessPIN", accessPIN);
-			return true;
+			return fields_from_json(Obj, *this, SubContactFields);
 		} catch (...) {
 		}
 		return false;
@@ -568,48 +553,37 @@ namespace OpenWifi::ProvObjects {
 		return false;
 	}
 
+	static constexpr auto InventoryTagFields = std::make_tuple(
+		Embedded(&InventoryTag::info),
+		Field("serialNumber", &InventoryTag::serialNumber),
+		Field("venue", &InventoryTag::venue),
+		Field("entity", &InventoryTag::entity),
+		Field("subscriber", &InventoryTag::subscriber),
+		Field("deviceType", &InventoryTag::deviceType),
+		Field("qrCode", &InventoryTag::qrCode),
+		Field("geoCode", &InventoryTag::geoCode),
+		Field("location", &InventoryTag::location),
+		Field("contact", &InventoryTag::contact),
+		Field("deviceConfiguration", &InventoryTag::deviceConfiguration),
+		Field("deviceRules", &InventoryTag::deviceRules),
+		Field("managementPolicy", &InventoryTag::managementPolicy),
+		Field("state", &InventoryTag::state),
+		Field("devClass", &InventoryTag::devClass),
+		Field("locale", &InventoryTag::locale),
+		Field("realMacAddress", &InventoryTag::realMacAddress),
+		Field("doNotAllowOverrides", &InventoryTag::doNotAllowOverrides));
+
 	void InventoryTag::to_json(Poco::JSON::Object &Obj) const {
-		info.to_json(Obj);
-		field_to_json(Obj, "serialNumber", serialNumber);
-		field_to_json(Obj, "venue", venue);
-		field_to_json(Obj, "entity", entity);
-		field_to_json(Obj, "subscriber", subscriber);
-		field_to_json(Obj, "deviceType", deviceType);
-		field_to_json(Obj, "qrCode", qrCode);
-		field_to_json(Obj, "geoCode", geoCode);
-		field_to_json(Obj, "location", location);
-		field_to_json(Obj, "contact", contact);
-		field_to_json(Obj, "deviceConfiguration", deviceConfiguration);
-		field_to_json(Obj, "deviceRules", deviceRules);
-		field_to_json(Obj, "managementPolicy", managementPolicy);
-		field_to_json(Obj, "state", state);
-		field_to_json(Obj, "devClass", devClass);
-		field_to_json(Obj, "locale", locale);
-		field_to_json(Obj, "realMacAddress", realMacAddress);
-		field_to_json(Obj, "doNotAllowOverrides", doNotAllowOverrides);
+		fields_to_json(Obj, *this, InventoryTagFields);
+	}
+
+	void InventoryTag::to_json(JSONWriter &W) const {
+		fields_to_json(W, *this, InventoryTagFields);
 	}
 
 	bool InventoryTag::from_json(const Poco::JSON::Object::Ptr &Obj) {
 		try {
-			info.from_json(Obj);
-			field_from_json(Obj, "serialNumber", serialNumber);
-			field_from_json(Obj, "venue", venue);
-			field_from_json(Obj, "entity", entity);
-			field_from_json(Obj, "subscriber", subscriber);
-			field_from_json(Obj, "deviceType", deviceType);
-			field_from_json(Obj, "qrCode", qrCode);
-			field_from_json(Obj, "geoCode", geoCode);
-			field_from_json(Obj, "location", location);
-			field_from_json(Obj, "contact", contact);
-			field_from_json(Obj, "deviceConfiguration", deviceConfiguration);
-			field_from_json(Obj, "deviceRules", deviceRules);
-			field_from_json(Obj, "managementPolicy", managementPolicy);
-			field_from_json(Obj, "state", state);
-			field_from_json(Obj, "devClass", devClass);
-			field_from_json(Obj, "locale", locale);
-			field_from_json(Obj, "realMacAddress", realMacAddress);
-			field_from_json(Obj, "doNotAllowOverrides", doNotAllowOverrides);
-			return true;
+			return fields_from_json(Obj, *this, InventoryTagFields);
 		} catch (...) {
 		}
 		return false;
@@ -647,53 +621,52 @@ namespace OpenWifi::ProvObjects {
 		return false;
 	};
 
+	static constexpr auto DeviceConfigurationElementFields = std::make_tuple(
+		Field("name", &DeviceConfigurationElement::name),
+		Field("description", &DeviceConfigurationElement::description),
+		Field("weight", &DeviceConfigurationElement::weight),
+		Field("configuration", &DeviceConfigurationElement::configuration));
+
 	void DeviceConfigurationElement::to_json(Poco::JSON::Object &Obj) const {
-		field_to_json(Obj, "name", name);
-		field_to_json(Obj, "description", description);
-		field_to_json(Obj, "weight", weight);
-		field_to_json(Obj, "configuration", configuration);
+		fields_to_json(Obj, *this, DeviceConfigurationElementFields);
+	}
+
+	void DeviceConfigurationElement::to_json(JSONWriter &W) const {
+		fields_to_json(W, *this, DeviceConfigurationElementFields);
 	}
 
 	bool DeviceConfigurationElement::from_json(const Poco::JSON::Object::Ptr &Obj) {
 		try {
-			field_from_json(Obj, "name", name);
-			field_from_json(Obj, "description", description);
-			field_from_json(Obj, "weight", weight);
-			field_from_json(Obj, "configuration", configuration);
-			return true;
+			return fields_from_json(Obj, *this, DeviceConfigurationElementFields);
 		} catch (...) {
 		}
 		return false;
 	}
 
+	static constexpr auto DeviceConfigurationFields = std::make_tuple(
+		Embedded(&DeviceConfiguration::info),
+		Field("managementPolicy", &DeviceConfiguration::managementPolicy),
+		Field("deviceTypes", &DeviceConfiguration::deviceTypes),
+		Field("subscriberOnly", &DeviceConfiguration::subscriberOnly),
+		Field("entity", &DeviceConfiguration::entity),
+		Field("venue", &DeviceConfiguration::venue),
+		Field("subscriber", &DeviceConfiguration::subscriber),
+		Field("configuration", &DeviceConfiguration::configuration),
+		Field("inUse", &DeviceConfiguration::inUse),
+		Field("variables", &DeviceConfiguration::variables),
+		Field("deviceRules", &DeviceConfiguration::deviceRules));
+
 	void DeviceConfiguration::to_json(Poco::JSON::Object &Obj) const {
-		info.to_json(Obj);
-		field_to_json(Obj, "managementPolicy", managementPolicy);
-		field_to_json(Obj, "deviceTypes", deviceTypes);
-		field_to_json(Obj, "subscriberOnly", subscriberOnly);
-		field_to_json(Obj, "entity", entity);
-		field_to_json(Obj, "venue", venue);
-		field_to_json(Obj, "subscriber", subscriber);
-		field_to_json(Obj, "configuration", configuration);
-		field_to_json(Obj, "inUse", inUse);
-		field_to_json(Obj, "variables", variables);
-		field_to_json(Obj, "deviceRules", deviceRules);
+		fields_to_json(Obj, *this, DeviceConfigurationFields);
+	}
+
+	void DeviceConfiguration::to_json(JSONWriter &W) const {
+		fields_to_json(W, *this, DeviceConfigurationFields);
 	}
 
 	bool DeviceConfiguration::from_json(const Poco::JSON::Object::Ptr &Obj) {
 		try {
-			info.from_json(Obj);
-			field_from_json(Obj, "managementPolicy", managementPolicy);
-			field_from_json(Obj, "deviceTypes", deviceTypes);
-			field_from_json(Obj, "inUse", inUse);
-			field_from_json(Obj, "variables", variables);
-			field_from_json(Obj, "subscriberOnly", subscriberOnly);
-			field_from_json(Obj, "entity", entity);
-			field_from_json(Obj, "venue", venue);
-			field_from_json(Obj, "subscriber", subscriber);
-			field_from_json(Obj, "configuration", configuration);
-			field_from_json(Obj, "deviceRules", deviceRules);
-			return true;
+			return fields_from_json(Obj, *this, DeviceConfigurationFields);
 		} catch (...) {
 		}
 		return false;
@@ -971,48 +944,37 @@ namespace OpenWifi::ProvObjects {
 		return false;
 	}
 
+	static constexpr auto SubscriberDeviceFields = std::make_tuple(
+		Embedded(&SubscriberDevice::info),
+		Field("serialNumber", &SubscriberDevice::serialNumber),
+		Field("deviceType", &SubscriberDevice::deviceType),
+		Field("operatorId", &SubscriberDevice::operatorId),
+		Field("subscriberId", &SubscriberDevice::subscriberId),
+		Field("location", &SubscriberDevice::location),
+		Field("contact", &SubscriberDevice::contact),
+		Field("managementPolicy", &SubscriberDevice::managementPolicy),
+		Field("serviceClass", &SubscriberDevice::serviceClass),
+		Field("qrCode", &SubscriberDevice::qrCode),
+		Field("geoCode", &SubscriberDevice::geoCode),
+		Field("deviceRules", &SubscriberDevice::deviceRules),
+		Field("state", &SubscriberDevice::state),
+		Field("locale", &SubscriberDevice::locale),
+		Field("billingCode", &SubscriberDevice::billingCode),
+		Field("configuration", &SubscriberDevice::configuration),
+		Field("suspended", &SubscriberDevice::suspended),
+		Field("realMacAddress", &SubscriberDevice::realMacAddress));
+
 	void SubscriberDevice::to_json(Poco::JSON::Object &Obj) const {
-		info.to_json(Obj);
-		field_to_json(Obj, "serialNumber", serialNumber);
-		field_to_json(Obj, "deviceType", deviceType);
-		field_to_json(Obj, "operatorId", operatorId);
-		field_to_json(Obj, "subscriberId", subscriberId);
-		field_to_json(Obj, "location", location);
-		field_to_json(Obj, "contact", contact);
-		field_to_json(Obj, "managementPolicy", managementPolicy);
-		field_to_json(Obj, "serviceClass", serviceClass);
-		field_to_json(Obj, "qrCode", qrCode);
-		field_to_json(Obj, "geoCode", geoCode);
-		field_to_json(Obj, "deviceRules", deviceRules);
-		field_to_json(Obj, "state", state);
-		field_to_json(Obj, "locale", locale);
-		field_to_json(Obj, "billingCode", billingCode);
-		field_to_json(Obj, "configuration", configuration);
-		field_to_json(Obj, "suspended", suspended);
-		field_to_json(Obj, "realMacAddress", realMacAddress);
+		fields_to_json(Obj, *this, SubscriberDeviceFields);
+	}
+
+	void SubscriberDevice::to_json(JSONWriter &W) const {
+		fields_to_json(W, *this, SubscriberDeviceFields);
 	}
 
 	bool SubscriberDevice::from_json(const Poco::JSON::Object::Ptr &Obj) {
 		try {
-			info.from_json(Obj);
-			field_from_json(Obj, "serialNumber", serialNumber);
-			field_from_json(Obj, "deviceType", deviceType);
-			field_from_json(Obj, "operatorId", operatorId);
-			field_from_json(Obj, "subscriberId", subscriberId);
-			field_from_json(Obj, "location", location);
-			field_from_json(Obj, "contact", contact);
-			field_from_json(Obj, "managementPolicy", managementPolicy);
-			field_from_json(Obj, "serviceClass", serviceClass);
-			field_from_json(Obj, "qrCode", qrCode);
-			field_from_json(Obj, "geoCode", geoCode);
-			field_from_json(Obj, "deviceRules", deviceRules);
-			field_from_json(Obj, "state", state);
-			field_from_json(Obj, "locale", locale);
-			field_from_json(Obj, "billingCode", billingCode);
-			field_from_json(Obj, "configuration", configuration);
-			field_from_json(Obj, "suspended", suspended);
-			field_from_json(Obj, "realMacAddress", realMacAddress);
-			return true;
+			return fields_from_json(Obj, *this, SubscriberDeviceFields);
 		} catch (...) {
 		}
 		return false;
@@ -1105,18 +1067,22 @@ namespace OpenWifi::ProvObjects {
 		return true;
 	}
 
+	static constexpr auto DeviceRulesFields = std::make_tuple(
+		Field("rcOnly", &DeviceRules::rcOnly),
+		Field("rrm", &DeviceRules::rrm),
+		Field("firmwareUpgrade", &DeviceRules::firmwareUpgrade));
+
 	void DeviceRules::to_json(Poco::JSON::Object &Obj) const {
-		field_to_json(Obj, "rcOnly", rcOnly);
-		field_to_json(Obj, "rrm", rrm);
-		field_to_json(Obj, "firmwareUpgrade", firmwareUpgrade);
+		fields_to_json(Obj, *this, DeviceRulesFields);
+	}
+
+	void DeviceRules::to_json(JSONWriter &W) const {
+		fields_to_json(W, *this, DeviceRulesFields);
 	}
 
 	bool DeviceRules::from_json(const Poco::JSON::Object::Ptr &Obj) {
 		try {
-			field_from_json(Obj, "rcOnly", rcOnly);
-			field_from_json(Obj, "rrm", rrm);
-			field_from_json(Obj, "firmwareUpgrade", firmwareUpgrade);
-			return true;
+			return fields_from_json(Obj, *this, DeviceRulesFields);
 		} catch (...) {
 		}
 		return false;
@@ -1194,4 +1160,101 @@ namespace OpenWifi::ProvObjects {
 		return false;
 	}
 
+	//	Every struct written by JSONWriter, filled with strings that exercise the escaping, plus
+	//	the double formatting, compared with what Poco::JSON::Stringifier makes of the same values.
+	bool VerifyJSONWriter(std::string &Mismatch) {
+		static const std::vector<std::string> Samples{
+			"plain",
+			"a/b/c",
+			"quote\" and back\\slash",
+			std::string("nul\0byte", 8),
+			"\x01\x1f\x7f",
+			"\n\t\r\b\f",
+			"caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x93\xb6"};
+
+		JSONWriter W;
+		auto Same = [&W, &Mismatch](const char *Name, const std::string &Written,
+									const Poco::JSON::Object &O) {
+			std::ostringstream OS;
+			Poco::JSON::Stringifier::stringify(O, OS);
+			if (Written == OS.str())
+				return true;
+			Mismatch = fmt::format("{}: wrote {} where Poco writes {}", Name, Written, OS.str());
+			return false;
+		};
+		auto Check = [&](const char *Name, const auto &V) {
+			Poco::JSON::Object O;
+			V.to_json(O);
+			return Same(Name, W.Write(V), O);
+		};
+
+		for (const auto &S : Samples) {
+			ObjectInfo Info;
+			Info.id = Info.name = Info.description = S;
+			Info.notes.push_back(SecurityObjects::NoteInfo{1, S, S});
+			Info.created = 1;
+			Info.modified = 2;
+			Info.tags = {3, 4};
+
+			DeviceRules Rules;
+			Rules.rrm = Rules.rcOnly = Rules.firmwareUpgrade = S;
+
+			Entity E;
+			E.info = Info;
+			E.parent = S;
+			E.children = E.venues = E.devices = E.sourceIP = {S, S};
+			E.deviceRules = Rules;
+
+			Venue V;
+			V.info = Info;
+			V.entity = V.parent = V.design = V.location = S;
+			V.devices = V.sourceIP = {S};
+			V.topology = {DiGraphEntry{S, S}};
+			V.deviceRules = Rules;
+
+			InventoryTag T;
+			T.info = Info;
+			T.serialNumber = T.venue = T.deviceType = T.state = T.locale = T.realMacAddress = S;
+			T.deviceRules = Rules;
+			T.doNotAllowOverrides = true;
+
+			DeviceConfiguration C;
+			C.info = Info;
+			C.deviceTypes = C.inUse = {S};
+			C.configuration = {DeviceConfigurationElement{S, S, 7, S}};
+			C.deviceRules = Rules;
+			C.subscriberOnly = true;
+			C.venue = C.entity = C.subscriber = S;
+
+			SubscriberDevice D;
+			D.info = Info;
+			D.serialNumber = D.qrCode = D.billingCode = S;
+			D.location.city = D.location.geoCode = S;
+			D.location.addressLines = D.location.phones = {S};
+			D.contact.firstname = D.contact.primaryEmail = S;
+			D.contact.mobiles = {S};
+			D.configuration = C.configuration;
+			D.deviceRules = Rules;
+			D.suspended = true;
+
+			if (!Check("Entity", E) || !Check("Venue", V) || !Check("InventoryTag", T) ||
+				!Check("DeviceConfiguration", C) || !Check("SubscriberDevice", D))
+				return false;
+		}
+
+		for (double Value : {0.0, -0.5, 0.1, 1.0 / 3.0, 3.141592653589793, 1e-7, 1e21,
+							 123456789.125}) {
+			Poco::JSON::Object O;
+			O.set("value", Value);
+			W.Clear();
+			W.BeginObject();
+			W.Key("value");
+			W.Double(Value);
+			W.EndObject();
+			if (!Same("double", W.str(), O))
+				return false;
+		}
+		return true;
+	}
+
 } // namespace OpenWifi::ProvObjects
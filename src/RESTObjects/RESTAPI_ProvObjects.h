@@ -29,6 +29,7 @@ namespace OpenWifi::ProvObjects {
 		Types::TagList tags;
 
 		void to_json(Poco::JSON::Object &Obj) const;
+		void to_json(JSONWriter &W) const;
 		bool from_json(const Poco::JSON::Object::Ptr &Obj);
 	};
 
@@ -82,6 +83,7 @@ namespace OpenWifi::ProvObjects {
 		std::string firmwareUpgrade{"inherit"};
 
 		void to_json(Poco::JSON::Object &Obj) const;
+		void to_json(JSONWriter &W) const;
 		bool from_json(const Poco::JSON::Object::Ptr &Obj);
 	};
 
@@ -104,6 +106,7 @@ namespace OpenWifi::ProvObjects {
 		Types::UUIDvec_t configurations;
 
 		void to_json(Poco::JSON::Object &Obj) const;
+		void to_json(JSONWriter &W) const;
 		bool from_json(const Poco::JSON::Object::Ptr &Obj);
 	};
 	typedef std::vector<Entity> EntityVec;
@@ -113,6 +116,7 @@ namespace OpenWifi::ProvObjects {
 		Types::UUID_t child;
 
 		void to_json(Poco::JSON::Object &Obj) const;
+		void to_json(JSONWriter &W) const;
 		bool from_json(const Poco::JSON::Object::Ptr &Obj);
 	};
 
@@ -140,6 +144,7 @@ namespace OpenWifi::ProvObjects {
 		Types::UUIDvec_t boards;
 
 		void to_json(Poco::JSON::Object &Obj) const;
+		void to_json(JSONWriter &W) const;
 		bool from_json(const Poco::JSON::Object::Ptr &Obj);
 	};
 	typedef std::vector<Venue> VenueVec;
@@ -270,6 +275,7 @@ namespace OpenWifi::ProvObjects {
 		std::string geoCode;
 
 		void to_json(Poco::JSON::Object &Obj) const;
+		void to_json(JSONWriter &W) const;
 		bool from_json(const Poco::JSON::Object::Ptr &Obj);
 	};
 
@@ -397,6 +403,7 @@ namespace OpenWifi::ProvObjects {
 		std::string accessPIN;
 
 		void to_json(Poco::JSON::Object &Obj) const;
+		void to_json(JSONWriter &W) const;
 		bool from_json(const Poco::JSON::Object::Ptr &Obj);
 	};
 
@@ -416,6 +423,7 @@ namespace OpenWifi::ProvObjects {
 		std::string configuration;
 
 		void to_json(Poco::JSON::Object &Obj) const;
+		void to_json(JSONWriter &W) const;
 		bool from_json(const Poco::JSON::Object::Ptr &Obj);
 	};
 	typedef std::vector<DeviceConfigurationElement> DeviceConfigurationElementVec;
@@ -434,6 +442,7 @@ namespace OpenWifi::ProvObjects {
 		std::string subscriber;
 
 		void to_json(Poco::JSON::Object &Obj) const;
+		void to_json(JSONWriter &W) const;
 		bool from_json(const Poco::JSON::Object::Ptr &Obj);
 	};
 	typedef std::vector<DeviceConfiguration> DeviceConfigurationVec;
@@ -459,6 +468,7 @@ namespace OpenWifi::ProvObjects {
 		bool doNotAllowOverrides = false;
 
 		void to_json(Poco::JSON::Object &Obj) const;
+		void to_json(JSONWriter &W) const;
 		bool from_json(const Poco::JSON::Object::Ptr &Obj);
 	};
 
@@ -710,6 +720,7 @@ namespace OpenWifi::ProvObjects {
 		std::string realMacAddress;
 
 		void to_json(Poco::JSON::Object &Obj) const;
+		void to_json(JSONWriter &W) const;
 		bool from_json(const Poco::JSON::Object::Ptr &Obj);
 	};
 
@@ -746,4 +757,8 @@ namespace OpenWifi::ProvObjects {
 	bool CreateObjectInfo(const Poco::JSON::Object::Ptr &O, const SecurityObjects::UserInfo &U,
 						  ObjectInfo &I);
 	bool CreateObjectInfo(const SecurityObjects::UserInfo &U, ObjectInfo &I);
+
+	//	false, with the first difference in Mismatch, when a JSONWriter output differs from the
+	//	Poco::JSON text of the same object
+	bool VerifyJSONWriter(std::string &Mismatch);
 }; // namespace OpenWifi::ProvObjects
@@ -436,6 +436,12 @@ namespace OpenWifi::SecurityObjects {
 		field_to_json(Obj, "note", note);
 	}
 
+	void NoteInfo::to_json(JSONWriter &W) const {
+		field_to_json(W, "created", created);
+		field_to_json(W, "createdBy", createdBy);
+		field_to_json(W, "note", note);
+	}
+
 	bool NoteInfo::from_json(const Poco::JSON::Object::Ptr &Obj) {
 		try {
 			field_from_json(Obj, "created", created);
@@ -3,11 +3,15 @@
 //
 
 #include "SerialNumberCache.h"
+#include "framework/MicroServiceFuncs.h"
 #include "framework/utils.h"
 
 namespace OpenWifi {
 
-	int SerialNumberCache::Start() { return 0; }
+	int SerialNumberCache::Start() {
+		FingerprintTTL_ = MicroServiceConfigGetInt("discovery.fingerprint.ttl", 3600);
+		return 0;
+	}
 
 	void SerialNumberCache::Stop() {}
 
@@ -27,6 +31,30 @@ namespace OpenWifi {
 		}
 	}
 
+	void SerialNumberCache::AddSerialNumbers(const std::vector<std::string> &SerialNumbers) {
+		std::vector<std::pair<uint64_t, uint64_t>> Added;
+		Added.reserve(SerialNumbers.size());
+		for (const auto &S : SerialNumbers)
+			Added.emplace_back(std::stoull(S, nullptr, 16),
+							   std::stoull(ReverseSerialNumber(S), nullptr, 16));
+		std::sort(Added.begin(), Added.end());
+
+		std::lock_guard G(Mutex_);
+		auto SNsEnd = SNs_.size(), RSNsEnd = Reverse_SNs_.size();
+		for (std::size_t i = 0; i < Added.size(); ++i) {
+			const auto &[SN, RSN] = Added[i];
+			if ((i > 0 && Added[i - 1].first == SN) ||
+				std::binary_search(SNs_.begin(), SNs_.begin() + SNsEnd, SN))
+				continue;
+			SNs_.push_back(SN);
+			Reverse_SNs_.push_back(RSN);
+		}
+		std::inplace_merge(SNs_.begin(), SNs_.begin() + SNsEnd, SNs_.end());
+		std::sort(Reverse_SNs_.begin() + RSNsEnd, Reverse_SNs_.end());
+		std::inplace_merge(Reverse_SNs_.begin(), Reverse_SNs_.begin() + RSNsEnd,
+						   Reverse_SNs_.end());
+	}
+
 	void SerialNumberCache::DeleteSerialNumber(const std::string &S) {
 		std::lock_guard G(Mutex_);
 
@@ -42,6 +70,59 @@ namespace OpenWifi {
 				Reverse_SNs_.erase(RIt);
 			}
 		}
+		Fingerprints_.erase(SN);
+	}
+
+	uint64_t SerialNumberCache::ConnectionFingerprint(const std::string &DeviceType,
+													  const std::string &Locale,
+													  const std::string &ConnectionIP) {
+		//	FNV-1a, with a separator between fields so that ("ab","c") and ("a","bc") differ
+		uint64_t Hash = 14695981039346656037ULL;
+		auto Add = [&Hash](const std::string &S) {
+			for (const auto c : S) {
+				Hash ^= (uint8_t)c;
+				Hash *= 1099511628211ULL;
+			}
+			Hash ^= 0xff;
+			Hash *= 1099511628211ULL;
+		};
+		Add(DeviceType);
+		Add(Locale);
+		Add(ConnectionIP);
+		return Hash;
+	}
+
+	bool SerialNumberCache::FingerprintMatches(const std::string &S, uint64_t Fingerprint) {
+		if (S.empty() || !Utils::ValidSerialNumber(S))
+			return false;
+		std::lock_guard G(Mutex_);
+		auto Hint = Fingerprints_.find(Utils::SerialNumberToInt(S));
+		if (Hint == Fingerprints_.end())
+			return false;
+		if ((Utils::Now() - Hint->second.Created) > FingerprintTTL_) {
+			Fingerprints_.erase(Hint);
+			return false;
+		}
+		return Hint->second.Fingerprint == Fingerprint;
+	}
+
+	void SerialNumberCache::SetFingerprint(const std::string &S, uint64_t Fingerprint) {
+		if (S.empty() || !Utils::ValidSerialNumber(S))
+			return;
+		std::lock_guard G(Mutex_);
+		Fingerprints_[Utils::SerialNumberToInt(S)] = FingerprintEntry{Fingerprint, Utils::Now()};
+	}
+
+	void SerialNumberCache::ClearFingerprint(const std::string &S) {
+		if (S.empty() || !Utils::ValidSerialNumber(S))
+			return;
+		std::lock_guard G(Mutex_);
+		Fingerprints_.erase(Utils::SerialNumberToInt(S));
+	}
+
+	void SerialNumberCache::ClearFingerprints() {
+		std::lock_guard G(Mutex_);
+		Fingerprints_.clear();
 	}
 
 	uint64_t Reverse(uint64_t N) {
@@ -6,6 +6,7 @@
 
 #include "framework/SubSystemServer.h"
 #include <mutex>
+#include <unordered_map>
 
 namespace OpenWifi {
 	class SerialNumberCache : public SubSystemServer {
@@ -19,6 +20,8 @@ namespace OpenWifi {
 		void Stop() override;
 		void AddSerialNumber(const std::string &SerialNumber,
 							 [[maybe_unused]] const std::string &DeviceType);
+		//	one sort per call instead of one insert per serial number
+		void AddSerialNumbers(const std::vector<std::string> &SerialNumbers);
 		void DeleteSerialNumber(const std::string &SerialNumber);
 		void FindNumbers(const std::string &SerialNumber, uint HowMany, std::vector<uint64_t> &A);
 		inline std::vector<uint64_t> GetCacheCopy() {
@@ -30,6 +33,15 @@ namespace OpenWifi {
 			return std::find(SNs_.begin(), SNs_.end(), SerialNumber) != SNs_.end();
 		}
 
+		//	fingerprint of the connection attributes last written to the inventory for a device
+		static uint64_t ConnectionFingerprint(const std::string &DeviceType,
+											  const std::string &Locale,
+											  const std::string &ConnectionIP);
+		bool FingerprintMatches(const std::string &SerialNumber, uint64_t Fingerprint);
+		void SetFingerprint(const std::string &SerialNumber, uint64_t Fingerprint);
+		void ClearFingerprint(const std::string &SerialNumber);
+		void ClearFingerprints();
+
 		static inline std::string ReverseSerialNumber(const std::string &S) {
 			std::string ReversedString;
 			std::copy(rbegin(S), rend(S), std::back_inserter(ReversedString));
@@ -39,6 +51,12 @@ namespace OpenWifi {
 	  private:
 		std::vector<uint64_t> SNs_;
 		std::vector<uint64_t> Reverse_SNs_;
+		struct FingerprintEntry {
+			uint64_t Fingerprint = 0;
+			uint64_t Created = 0;
+		};
+		std::unordered_map<uint64_t, FingerprintEntry> Fingerprints_;
+		uint64_t FingerprintTTL_ = 3600;
 
 		void ReturnNumbers(const std::string &S, uint HowMany, const std::vector<uint64_t> &SNArr,
 						   std::vector<uint64_t> &A, bool ReverseResult);
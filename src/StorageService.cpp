@@ -6,7 +6,15 @@
 //	Arilia Wireless Inc.
 //
 
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <set>
+#include <unordered_set>
+
 #include "StorageService.h"
+#include "DeviceRulesIndex.h"
+#include "HierarchyIndex.h"
 #include "RESTObjects/RESTAPI_ProvObjects.h"
 #include "fmt/format.h"
 #include "framework/utils.h"
@@ -39,7 +47,10 @@ namespace OpenWifi {
 		OpLocationDB_ = std::make_unique<OpenWifi::OpLocationDB>(dbType_, *Pool_, Logger());
 		OpContactDB_ = std::make_unique<OpenWifi::OpContactDB>(dbType_, *Pool_, Logger());
 		OverridesDB_ = std::make_unique<OpenWifi::OverridesDB>(dbType_, *Pool_, Logger());
+		MembershipDB_ = std::make_unique<OpenWifi::MembershipDB>(dbType_, *Pool_, Logger());
 
+		//	first: the entity and venue upgrades move their lists into it
+		MembershipDB_->Create();
 		EntityDB_->Create();
 		PolicyDB_->Create();
 		VenueDB_->Create();
@@ -216,6 +227,16 @@ namespace OpenWifi {
 		Timer_.setStartInterval(20 * 1000);				// first run in 20 seconds
 		Timer_.setPeriodicInterval(1 * 60 * 60 * 1000); // 1 hours
 		Timer_.start(*TimerCallback_);
+
+		//	the in-memory indexes are loaded here and reloaded in the background, never on a
+		//	request thread
+		HierarchyIndex()->Refresh();
+		DeviceRulesIndex()->Refresh();
+		IndexTimerCallback_ =
+			std::make_unique<Poco::TimerCallback<Storage>>(*this, &Storage::onIndexTimer);
+		IndexTimer_.setStartInterval(5 * 1000);
+		IndexTimer_.setPeriodicInterval(5 * 1000);
+		IndexTimer_.start(*IndexTimerCallback_);
 		return 0;
 	}
 
@@ -223,8 +244,15 @@ namespace OpenWifi {
 		Utils::SetThreadName("strg-janitor");
 	}
 
+	void Storage::onIndexTimer([[maybe_unused]] Poco::Timer &timer) {
+		Utils::SetThreadName("strg-indexes");
+		HierarchyIndex()->Refresh();
+		DeviceRulesIndex()->Refresh();
+	}
+
 	void Storage::Stop() {
 		poco_information(Logger(), "Stopping...");
+		IndexTimer_.stop();
 		Timer_.stop();
 		poco_information(Logger(), "Stopped...");
 	}
@@ -308,204 +336,191 @@ namespace OpenWifi {
 		return true;
 	}
 
-	void Storage::ConsistencyCheck() {
-
-		// check that all inventory in venues and entities actually exists, if not, fix it.
-		auto FixVenueDevices = [&](const ProvObjects::Venue &V) -> bool {
-			Types::UUIDvec_t NewDevices;
-			bool modified = false;
-			for (const auto &device : V.devices) {
-				ProvObjects::InventoryTag T;
-				if (InventoryDB().GetRecord("id", device, T)) {
-					NewDevices.emplace_back(device);
-				} else {
-					modified = true;
-				}
-			}
-
-			ProvObjects::Venue NewVenue = V;
-			if (V.deviceRules.rrm == "yes") {
-				NewVenue.deviceRules.rrm = "inherit";
-				modified = true;
-			}
+	//	records read and written per statement batch by the consistency check
+	static constexpr std::size_t ConsistencyBatch = 1000;
+	typedef std::unordered_set<std::string> IdSet;
 
-			if (modified) {
-				poco_warning(Logger(), fmt::format("  fixing venue: {}", V.info.name));
-				NewVenue.devices = NewDevices;
-				VenueDB().UpdateRecord("id", V.info.id, NewVenue);
-			}
-
-			return true;
-		};
+	//	clears a reference to a record that does not exist, true when it did
+	static bool KeepExisting(std::string &Member, const IdSet &Ids) {
+		if (Member.empty() || Ids.count(Member))
+			return false;
+		Member.clear();
+		return true;
+	}
 
-		auto FixEntity = [&](const ProvObjects::Entity &E) -> bool {
-			Types::UUIDvec_t NewDevices;
-			bool Modified = false;
-			for (const auto &device : E.devices) {
-				ProvObjects::InventoryTag T;
-				if (InventoryDB().GetRecord("id", device, T)) {
-					NewDevices.emplace_back(device);
-				} else {
-					Modified = true;
-				}
-			}
+	static bool FixRRM(ProvObjects::DeviceRules &Rules) {
+		if (Rules.rrm != "yes")
+			return false;
+		Rules.rrm = "inherit";
+		return true;
+	}
 
-			Types::UUIDvec_t NewContacts;
-			for (const auto &contact : E.contacts) {
-				ProvObjects::Contact C;
-				if (ContactDB().GetRecord("id", contact, C)) {
-					NewContacts.emplace_back(contact);
-				} else {
-					Modified = true;
-				}
-			}
+	static uint64_t ElapsedMs(std::chrono::steady_clock::time_point Start) {
+		return std::chrono::duration_cast<std::chrono::milliseconds>(
+				   std::chrono::steady_clock::now() - Start)
+			.count();
+	}
 
-			Types::UUIDvec_t NewLocations;
-			for (const auto &location : E.locations) {
-				ProvObjects::Location L;
-				if (LocationDB().GetRecord("id", location, L)) {
-					NewLocations.emplace_back(location);
-				} else {
-					Modified = true;
+	//	Scans a table in large pages, lets Fix correct a copy of each record, then writes the
+	//	corrected records back in batched transactions. Nothing is written in a dry run.
+	template <typename Table, typename Record>
+	static uint64_t CheckTable(Table &DB, const char *Name, bool DryRun, Poco::Logger &Logger,
+							   std::function<bool(Record &)> Fix) {
+		auto Start = std::chrono::steady_clock::now();
+		uint64_t Scanned = 0;
+		std::vector<std::pair<std::string, Record>> Fixes;
+		DB.Iterate(
+			[&](const Record &R) -> bool {
+				Scanned++;
+				Record Fixed{R};
+				if (Fix(Fixed)) {
+					poco_warning(Logger, fmt::format("  {} {}: {}", DryRun ? "would fix" : "fixing",
+													 Name, R.info.name));
+					Fixes.emplace_back(R.info.id, std::move(Fixed));
 				}
+				return true;
+			},
+			"", ConsistencyBatch);
+
+		uint64_t Failed = 0;
+		if (!DryRun) {
+			for (std::size_t i = 0; i < Fixes.size(); i += ConsistencyBatch) {
+				auto Last = std::min(Fixes.size(), i + ConsistencyBatch);
+				std::vector<std::pair<std::string, Record>> Batch(Fixes.begin() + i,
+																  Fixes.begin() + Last);
+				if (!DB.UpdateRecords("id", Batch))
+					Failed += Batch.size();
 			}
+		}
 
-			Types::UUIDvec_t NewVenues;
-			for (const auto &venue : E.venues) {
-				ProvObjects::Venue V;
-				if (VenueDB().GetRecord("id", venue, V)) {
-					NewVenues.emplace_back(venue);
-				} else {
-					Modified = true;
-				}
-			}
+		poco_information(Logger,
+						 fmt::format("Checking DB consistency: {}: {} records, {} {}{}, {} ms", Name,
+									 Scanned, Fixes.size(), DryRun ? "to fix" : "fixed",
+									 Failed ? fmt::format(" ({} failed)", Failed) : "",
+									 ElapsedMs(Start)));
+		return Fixes.size();
+	}
 
-			Types::UUIDvec_t NewVariables;
-			for (const auto &variable : E.variables) {
-				ProvObjects::VariableBlock V;
-				if (VariablesDB().GetRecord("id", variable, V)) {
-					NewVariables.emplace_back(variable);
-				} else {
-					Modified = true;
+	void Storage::ConsistencyCheck() {
+		if (!MicroServiceConfigGetBool("storage.consistency.check", true)) {
+			poco_information(Logger(), "Checking DB consistency: disabled");
+			return;
+		}
+		auto DryRun = MicroServiceConfigGetBool("storage.consistency.dryrun", false);
+		auto Start = std::chrono::steady_clock::now();
+
+		//	the id of every record that can be referenced, each table read once and in parallel
+		IdSet Inventory, Contacts, Locations, Venues, Entities, Variables;
+		auto Ids = [](auto &DB, IdSet &Set) {
+			return std::async(std::launch::async, [&DB, &Set]() {
+				std::vector<std::string> Values;
+				if (!DB.GetFieldValues("id", Values))
+					return false;
+				Set.reserve(Values.size());
+				for (auto &Value : Values)
+					Set.insert(std::move(Value));
+				return true;
+			});
+		};
+		std::vector<std::future<bool>> Loads;
+		Loads.push_back(Ids(InventoryDB(), Inventory));
+		Loads.push_back(Ids(ContactDB(), Contacts));
+		Loads.push_back(Ids(LocationDB(), Locations));
+		Loads.push_back(Ids(VenueDB(), Venues));
+		Loads.push_back(Ids(EntityDB(), Entities));
+		Loads.push_back(Ids(VariablesDB(), Variables));
+		bool Loaded = true;
+		for (auto &L : Loads)
+			Loaded = L.get() && Loaded;
+		//	a partial view would make every reference to the missing table look dangling
+		if (!Loaded) {
+			poco_error(Logger(), "Checking DB consistency: could not read the record ids, skipped");
+			return;
+		}
+		poco_information(
+			Logger(),
+			fmt::format("Checking DB consistency{}: loaded {} ids in {} ms", DryRun ? " (dry run)" : "",
+						Inventory.size() + Contacts.size() + Locations.size() + Venues.size() +
+							Entities.size() + Variables.size(),
+						ElapsedMs(Start)));
+
+		//	every table is checked against the id sets only, so the checks run side by side
+		std::vector<std::future<uint64_t>> Checks;
+		auto Check = [&](auto &DB, const char *Name, auto Fix) {
+			using Table = std::remove_reference_t<decltype(DB)>;
+			Checks.push_back(std::async(std::launch::async, [&DB, Name, DryRun, Fix, this]() {
+				return CheckTable<Table, typename Table::RecordName>(DB, Name, DryRun, Logger(),
+																	   Fix);
+			}));
+		};
+
+		//	the members of venue and entity lists must exist, as must the lists' owners
+		Checks.push_back(std::async(std::launch::async, [&, DryRun, this]() {
+			const std::map<std::string, const IdSet *> Targets{{"devices", &Inventory},
+															   {"contacts", &Contacts},
+															   {"locations", &Locations},
+															   {"venues", &Venues},
+															   {"variables", &Variables}};
+			auto ListsStart = std::chrono::steady_clock::now();
+			uint64_t Scanned = 0;
+			std::vector<std::string> Dangling;
+			std::set<std::string> Owners;
+			MembershipDB().Iterate(
+				[&](const Membership &M) -> bool {
+					Scanned++;
+					auto Target = Targets.find(M.kind);
+					if ((Venues.count(M.owner) || Entities.count(M.owner)) &&
+						(Target == Targets.end() || Target->second->count(M.member)))
+						return true;
+					poco_warning(Logger(), fmt::format("  {} membership: {} {} of {}",
+													   DryRun ? "would remove" : "removing",
+													   M.kind, M.member, M.owner));
+					Dangling.push_back(M.id);
+					Owners.insert(M.owner);
+					return true;
+				},
+				"", ConsistencyBatch);
+			if (!DryRun) {
+				MembershipDB().RemoveMembers(Dangling);
+				//	the lists of these records changed without going through their tables
+				for (const auto &Owner : Owners) {
+					if (Venues.count(Owner))
+						VenueDB().ExternalChange(Owner);
+					else
+						EntityDB().ExternalChange(Owner);
 				}
 			}
-
-			ProvObjects::Entity NewEntity = E;
-
-			if (E.deviceRules.rrm == "yes") {
-				NewEntity.deviceRules.rrm = "inherit";
-				Modified = true;
-			}
-
-			if (Modified) {
-				poco_warning(Logger(), fmt::format("  fixing entity: {}", E.info.name));
-				NewEntity.devices = NewDevices;
-				NewEntity.contacts = NewContacts;
-				NewEntity.locations = NewLocations;
-				NewEntity.venues = NewVenues;
-				NewEntity.variables = NewVariables;
-				EntityDB().UpdateRecord("id", E.info.id, NewEntity);
-			}
-			return true;
-		};
-
-		auto FixInventory = [&](const ProvObjects::InventoryTag &T) -> bool {
-			// check the venue/entity for this device.
-			ProvObjects::InventoryTag NewTag{T};
-			bool modified = false;
-			if (!T.venue.empty() && !VenueDB().Exists("id", T.venue)) {
-				NewTag.venue.clear();
-				modified = true;
-			}
-
-			if (!T.entity.empty() && !EntityDB().Exists("id", T.entity)) {
-				NewTag.entity.clear();
-				modified = true;
-			}
-
-			if (!T.location.empty() && !LocationDB().Exists("id", T.location)) {
-				NewTag.location.clear();
-				modified = true;
-			}
-
-			if (!T.contact.empty() && !ContactDB().Exists("id", T.contact)) {
-				NewTag.contact.clear();
-				modified = true;
-			}
-
-			if (T.deviceRules.rrm == "yes") {
-				NewTag.deviceRules.rrm = "inherit";
-				modified = true;
-			}
-
-			if (modified) {
-				poco_warning(Logger(), fmt::format("  fixing entity: {}", T.info.name));
-				InventoryDB().UpdateRecord("id", T.info.id, NewTag);
-			}
-			return true;
-		};
-
-		auto FixConfiguration = [&](const ProvObjects::DeviceConfiguration &C) -> bool {
-			ProvObjects::DeviceConfiguration NewConfig{C};
-
-			bool modified = false;
-
-			if (C.deviceRules.rrm == "yes") {
-				NewConfig.deviceRules.rrm = "inherit";
-				modified = true;
-			}
-
-			if (modified) {
-				poco_warning(Logger(), fmt::format("  fixing configuration: {}", C.info.name));
-				ConfigurationDB().UpdateRecord("id", C.info.id, NewConfig);
-			}
-			return true;
-		};
-
-		auto FixOperator = [&](const ProvObjects::Operator &O) -> bool {
-			ProvObjects::Operator NewOp{O};
-			bool modified = false;
-
-			if (O.deviceRules.rrm == "yes") {
-				NewOp.deviceRules.rrm = "inherit";
-				modified = true;
-			}
-
-			if (modified) {
-				poco_warning(Logger(), fmt::format("  fixing operator: {}", O.info.name));
-				OperatorDB().UpdateRecord("id", O.info.id, NewOp);
-			}
-			return true;
-		};
-
-		auto FixSubscriber = [&](const ProvObjects::SubscriberDevice &O) -> bool {
-			ProvObjects::SubscriberDevice NewSub{O};
-			bool modified = false;
-
-			if (O.deviceRules.rrm == "yes") {
-				NewSub.deviceRules.rrm = "inherit";
-				modified = true;
-			}
-
-			if (modified) {
-				poco_warning(Logger(), fmt::format("  fixing subscriber: {}", O.info.name));
-				SubscriberDeviceDB().UpdateRecord("id", O.info.id, NewSub);
-			}
-			return true;
-		};
-
-		poco_information(Logger(), "Checking DB consistency: venues");
-		VenueDB().Iterate(FixVenueDevices);
-		poco_information(Logger(), "Checking DB consistency: entities");
-		EntityDB().Iterate(FixEntity);
-		poco_information(Logger(), "Checking DB consistency: inventory");
-		InventoryDB().Iterate(FixInventory);
-		poco_information(Logger(), "Checking DB consistency: configurations");
-		ConfigurationDB().Iterate(FixConfiguration);
-		poco_information(Logger(), "Checking DB consistency: operators");
-		OperatorDB().Iterate(FixOperator);
-		poco_information(Logger(), "Checking DB consistency: subscribers");
-		SubscriberDeviceDB().Iterate(FixSubscriber);
+			poco_information(Logger(),
+							 fmt::format("Checking DB consistency: memberships: {} records, {} {}, "
+										 "{} ms",
+										 Scanned, Dangling.size(), DryRun ? "to fix" : "fixed",
+										 ElapsedMs(ListsStart)));
+			return (uint64_t)Dangling.size();
+		}));
+
+		//	RRM is never forced on below the root
+		Check(VenueDB(), "venue", [](ProvObjects::Venue &V) { return FixRRM(V.deviceRules); });
+		Check(EntityDB(), "entity", [](ProvObjects::Entity &E) { return FixRRM(E.deviceRules); });
+		Check(InventoryDB(), "inventory", [&](ProvObjects::InventoryTag &T) {
+			bool Modified = KeepExisting(T.venue, Venues);
+			Modified = KeepExisting(T.entity, Entities) || Modified;
+			Modified = KeepExisting(T.location, Locations) || Modified;
+			Modified = KeepExisting(T.contact, Contacts) || Modified;
+			return FixRRM(T.deviceRules) || Modified;
+		});
+		Check(ConfigurationDB(), "configuration",
+			  [](ProvObjects::DeviceConfiguration &C) { return FixRRM(C.deviceRules); });
+		Check(OperatorDB(), "operator",
+			  [](ProvObjects::Operator &O) { return FixRRM(O.deviceRules); });
+		Check(SubscriberDeviceDB(), "subscriber",
+			  [](ProvObjects::SubscriberDevice &S) { return FixRRM(S.deviceRules); });
+
+		uint64_t Fixes = 0;
+		for (auto &C : Checks)
+			Fixes += C.get();
+		poco_information(Logger(), fmt::format("Checking DB consistency: {} records {} in {} ms",
+											   Fixes, DryRun ? "to fix" : "fixed",
+											   ElapsedMs(Start)));
 	}
 
 	void Storage::InitializeSystemDBs() {
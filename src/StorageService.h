@@ -17,6 +17,7 @@
 #include "storage/storage_location.h"
 #include "storage/storage_management_roles.h"
 #include "storage/storage_maps.h"
+#include "storage/storage_memberships.h"
 #include "storage/storage_op_contacts.h"
 #include "storage/storage_op_locations.h"
 #include "storage/storage_operataor.h"
@@ -66,6 +67,10 @@ namespace OpenWifi {
 		OpenWifi::OpLocationDB &OpLocationDB() { return *OpLocationDB_; };
 		OpenWifi::OpContactDB &OpContactDB() { return *OpContactDB_; };
 		OpenWifi::OverridesDB &OverridesDB() { return *OverridesDB_; };
+		OpenWifi::MembershipDB &MembershipDB() { return *MembershipDB_; };
+
+		//	until Commit(), the tables used on this thread share one session and transaction
+		[[nodiscard]] inline ORM::UnitOfWork UnitOfWork() { return ORM::UnitOfWork(*Pool_); }
 
 		bool Validate(const Poco::URI::QueryParameters &P, RESTAPI::Errors::msg &Error);
 		bool Validate(const Types::StringVec &P, std::string &Error);
@@ -78,6 +83,7 @@ namespace OpenWifi {
 		bool Validate(const std::string &P);
 
 		void onTimer(Poco::Timer &timer);
+		void onIndexTimer(Poco::Timer &timer);
 
 		inline const std::string &DefaultOperator() { return DefaultOperator_; }
 
@@ -125,6 +131,7 @@ namespace OpenWifi {
 		std::unique_ptr<OpenWifi::OpLocationDB> OpLocationDB_;
 		std::unique_ptr<OpenWifi::OpContactDB> OpContactDB_;
 		std::unique_ptr<OpenWifi::OverridesDB> OverridesDB_;
+		std::unique_ptr<OpenWifi::MembershipDB> MembershipDB_;
 		std::string DefaultOperator_;
 
 		typedef std::function<bool(const char *FieldName, std::string &Value)> exist_func;
@@ -135,6 +142,8 @@ namespace OpenWifi {
 		std::map<std::string, expand_func> ExpandFunc_;
 		Poco::Timer Timer_;
 		std::unique_ptr<Poco::TimerCallback<Storage>> TimerCallback_;
+		Poco::Timer IndexTimer_;
+		std::unique_ptr<Poco::TimerCallback<Storage>> IndexTimerCallback_;
 
 		void ConsistencyCheck();
 		void InitializeSystemDBs();
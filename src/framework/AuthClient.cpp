@@ -6,12 +6,68 @@
 
 #include "fmt/format.h"
 #include "framework/AuthClient.h"
+#include "framework/MicroServiceFuncs.h"
 #include "framework/MicroServiceNames.h"
 #include "framework/OpenAPIRequests.h"
 #include "framework/utils.h"
 
 namespace OpenWifi {
 
+	int AuthClient::Start() {
+		poco_information(Logger(), "Starting...");
+		auto Shards = MicroServiceConfigGetInt("authentication.cache.shards", 16);
+		auto Size = MicroServiceConfigGetInt("authentication.cache.size", 4096);
+		auto Expire = MicroServiceConfigGetInt("authentication.cache.expire", 1200);
+		auto RejectedExpire = MicroServiceConfigGetInt("authentication.cache.rejected.expire", 30);
+		if (Shards == 0)
+			Shards = 1;
+		Cache_.Create(Shards, Size, Expire * 1000);
+		ApiKeyCache_.Create(Shards, Size, Expire * 1000);
+		if (RejectedExpire > 0)
+			Rejected_.Create(Shards, Size, RejectedExpire * 1000);
+		return 0;
+	}
+
+	void AuthClient::Stop() {
+		poco_information(Logger(), "Stopping...");
+		Cache_.clear();
+		ApiKeyCache_.clear();
+		Rejected_.clear();
+		poco_information(Logger(), "Stopped...");
+	}
+
+	void AuthClient::RemovedCachedToken(const std::string &Token) {
+		Cache_.remove(Token);
+		ApiKeyCache_.remove(Token);
+	}
+
+	AuthClient::Validation AuthClient::SingleFlight(const std::string &Key,
+													const std::function<Validation()> &Validate) {
+		std::unique_lock G(Mutex_);
+		auto Hint = InFlight_.find(Key);
+		if (Hint != InFlight_.end()) {
+			auto Pending = Hint->second;
+			G.unlock();
+			Coalesced_++;
+			return Pending.get();
+		}
+		std::promise<Validation> Promise;
+		InFlight_[Key] = Promise.get_future().share();
+		G.unlock();
+
+		Validation Result;
+		try {
+			Result = Validate();
+		} catch (...) {
+			Result = Validation{};
+		}
+		Remote_++;
+		Promise.set_value(Result);
+		G.lock();
+		InFlight_.erase(Key);
+		return Result;
+	}
+
 	bool AuthClient::RetrieveTokenInformation(const std::string &SessionToken,
 											  SecurityObjects::UserInfoAndPolicy &UInfo,
 											  std::uint64_t TID, bool &Expired, bool &Contacted,
@@ -39,15 +95,26 @@ namespace OpenWifi {
 					UInfo.from_json(Response);
 					if (IsTokenExpired(UInfo.webtoken)) {
 						Expired = true;
+						Rejected_.update(TokenKey(SessionToken, Sub), true);
 						return false;
 					}
 					Expired = false;
 					Cache_.update(SessionToken, UInfo);
 					return true;
-				} else {
-					return false;
 				}
+				//	a malformed answer is a service fault, not a verdict on the credentials
+				Contacted = false;
+				return false;
 			}
+			Expired = false;
+			//	only an explicit refusal is remembered; a failing security service must not
+			//	get valid credentials refused until the negative entry expires
+			if (StatusCode == Poco::Net::HTTPServerResponse::HTTP_UNAUTHORIZED ||
+				StatusCode == Poco::Net::HTTPServerResponse::HTTP_FORBIDDEN)
+				Rejected_.update(TokenKey(SessionToken, Sub), false);
+			else
+				Contacted = false;
+			return false;
 		} catch (...) {
 			poco_error(Logger(), fmt::format("Failed to retrieve token={} for TID={}",
 											 Utils::SanitizeToken(SessionToken), TID));
@@ -66,11 +133,32 @@ namespace OpenWifi {
 				Cache_.remove(SessionToken);
 				return false;
 			}
+			Hits_++;
 			Expired = false;
 			UInfo = *User;
 			return true;
 		}
-		return RetrieveTokenInformation(SessionToken, UInfo, TID, Expired, Contacted, Sub);
+		const auto Key = TokenKey(SessionToken, Sub);
+		auto Rejected = Rejected_.get(Key);
+		if (!Rejected.isNull()) {
+			RejectedHits_++;
+			Expired = *Rejected;
+			Contacted = true;
+			return false;
+		}
+
+		Misses_++;
+		auto V = SingleFlight(Key, [&]() {
+			Validation R;
+			R.Valid = RetrieveTokenInformation(SessionToken, R.UInfo, TID, R.Expired, R.Contacted,
+											   Sub);
+			return R;
+		});
+		Expired = V.Expired;
+		Contacted = V.Contacted;
+		if (V.Valid)
+			UInfo = V.UInfo;
+		return V.Valid;
 	}
 
 	bool AuthClient::RetrieveApiKeyInformation(const std::string &SessionToken,
@@ -102,10 +190,20 @@ namespace OpenWifi {
 										ApiKeyCacheEntry{.UserInfo = UInfo,
 														 .ExpiresOn = Response->get("expiresOn")});
 					return true;
-				} else {
-					return false;
 				}
+				//	a malformed answer is a service fault, not a verdict on the credentials
+				Contacted = false;
+				return false;
 			}
+			Expired = false;
+			//	only an explicit refusal is remembered; a failing security service must not
+			//	get valid credentials refused until the negative entry expires
+			if (StatusCode == Poco::Net::HTTPServerResponse::HTTP_UNAUTHORIZED ||
+				StatusCode == Poco::Net::HTTPServerResponse::HTTP_FORBIDDEN)
+				Rejected_.update(ApiKeyKey(SessionToken), false);
+			else
+				Contacted = false;
+			return false;
 		} catch (...) {
 			poco_error(Logger(), fmt::format("Failed to retrieve api key={} for TID={}",
 											 Utils::SanitizeToken(SessionToken), TID));
@@ -119,14 +217,49 @@ namespace OpenWifi {
 								   bool &Expired, bool &Contacted, bool &Suspended) {
 		auto User = ApiKeyCache_.get(SessionToken);
 		if (!User.isNull()) {
-			if (User->ExpiresOn < Utils::Now()) {
+			if (User->ExpiresOn == 0 || User->ExpiresOn > Utils::Now()) {
+				Hits_++;
 				Expired = false;
 				UInfo = User->UserInfo;
 				return true;
 			}
 			ApiKeyCache_.remove(SessionToken);
 		}
-		return RetrieveApiKeyInformation(SessionToken, UInfo, TID, Expired, Contacted, Suspended);
+		const auto Key = ApiKeyKey(SessionToken);
+		auto Rejected = Rejected_.get(Key);
+		if (!Rejected.isNull()) {
+			RejectedHits_++;
+			Expired = *Rejected;
+			Contacted = true;
+			return false;
+		}
+
+		Misses_++;
+		auto V = SingleFlight(Key, [&]() {
+			Validation R;
+			R.Valid = RetrieveApiKeyInformation(SessionToken, R.UInfo, TID, R.Expired,
+												R.Contacted, R.Suspended);
+			return R;
+		});
+		Expired = V.Expired;
+		Contacted = V.Contacted;
+		Suspended = V.Suspended;
+		if (V.Valid)
+			UInfo = V.UInfo;
+		return V.Valid;
+	}
+
+	void AuthClient::Stats(Poco::JSON::Object &Answer) {
+		Answer.set("tokens", Cache_.size());
+		Answer.set("apiKeys", ApiKeyCache_.size());
+		Answer.set("rejected", Rejected_.size());
+		Answer.set("hits", Hits_.load());
+		Answer.set("misses", Misses_.load());
+		Answer.set("rejectedHits", RejectedHits_.load());
+		Answer.set("coalesced", Coalesced_.load());
+		Answer.set("remote", Remote_.load());
+		std::lock_guard G(Mutex_);
+		Answer.set("inFlight", InFlight_.size());
 	}
 
-} // namespace OpenWifi
\ No newline at end of file
+} // namespace OpenWifi
@@ -4,6 +4,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <vector>
+
 #include "Poco/ExpireLRUCache.h"
 #include "RESTObjects/RESTAPI_SecurityObjects.h"
 #include "framework/SubSystemServer.h"
@@ -11,6 +19,13 @@
 
 namespace OpenWifi {
 
+	/*
+	 * Caches are split in shards by token hash, each shard being its own Poco::ExpireLRUCache
+	 * with its own lock. Tokens the security service rejected are remembered for a short while
+	 * so a client retrying a bad token does not reach it every time. Concurrent validations of
+	 * the same token are coalesced: one caller asks the security service, the others wait for
+	 * its answer.
+	 */
 	class AuthClient : public SubSystemServer {
 
 	  public:
@@ -27,19 +42,11 @@ namespace OpenWifi {
 			std::uint64_t ExpiresOn;
 		};
 
-		inline int Start() override { return 0; }
-
-		inline void Stop() override {
-			poco_information(Logger(), "Stopping...");
-			std::lock_guard G(Mutex_);
-			Cache_.clear();
-			poco_information(Logger(), "Stopped...");
-		}
+		int Start() override;
+		void Stop() override;
+		void Stats(Poco::JSON::Object &Answer) override;
 
-		inline void RemovedCachedToken(const std::string &Token) {
-			Cache_.remove(Token);
-			ApiKeyCache_.remove(Token);
-		}
+		void RemovedCachedToken(const std::string &Token);
 
 		inline static bool IsTokenExpired(const SecurityObjects::WebToken &T) {
 			return ((T.expires_in_ + T.created_) < Utils::Now());
@@ -62,9 +69,74 @@ namespace OpenWifi {
 						   bool &Expired, bool &Contacted, bool &Suspended);
 
 	  private:
-		Poco::ExpireLRUCache<std::string, OpenWifi::SecurityObjects::UserInfoAndPolicy> Cache_{
-			512, 1200000};
-		Poco::ExpireLRUCache<std::string, ApiKeyCacheEntry> ApiKeyCache_{512, 1200000};
+		template <typename Value> class ShardedCache {
+		  public:
+			inline void Create(std::size_t Shards, std::size_t Size, uint64_t ExpireMs) {
+				Shards_.clear();
+				for (std::size_t i = 0; i < Shards; ++i)
+					Shards_.push_back(std::make_unique<Poco::ExpireLRUCache<std::string, Value>>(
+						std::max<std::size_t>(Size / Shards, 1), ExpireMs));
+			}
+			inline Poco::SharedPtr<Value> get(const std::string &Key) {
+				if (Shards_.empty())
+					return {};
+				return Shard(Key).get(Key);
+			}
+			inline void update(const std::string &Key, const Value &V) {
+				if (!Shards_.empty())
+					Shard(Key).update(Key, V);
+			}
+			inline void remove(const std::string &Key) {
+				if (!Shards_.empty())
+					Shard(Key).remove(Key);
+			}
+			inline void clear() {
+				for (auto &S : Shards_)
+					S->clear();
+			}
+			[[nodiscard]] inline std::size_t size() {
+				std::size_t Total = 0;
+				for (auto &S : Shards_)
+					Total += S->size();
+				return Total;
+			}
+
+		  private:
+			std::vector<std::unique_ptr<Poco::ExpireLRUCache<std::string, Value>>> Shards_;
+			inline Poco::ExpireLRUCache<std::string, Value> &Shard(const std::string &Key) {
+				return *Shards_[std::hash<std::string>{}(Key) % Shards_.size()];
+			}
+		};
+
+		//	What a validation produced, shared with the callers that waited for it
+		struct Validation {
+			bool Valid = false;
+			bool Expired = false;
+			bool Contacted = false;
+			bool Suspended = false;
+			SecurityObjects::UserInfoAndPolicy UInfo;
+		};
+
+		ShardedCache<SecurityObjects::UserInfoAndPolicy> Cache_;
+		ShardedCache<ApiKeyCacheEntry> ApiKeyCache_;
+		ShardedCache<bool> Rejected_; //	value: the token was rejected because it expired
+		std::map<std::string, std::shared_future<Validation>> InFlight_;
+
+		std::atomic_uint64_t Hits_{0};
+		std::atomic_uint64_t Misses_{0};
+		std::atomic_uint64_t RejectedHits_{0};
+		std::atomic_uint64_t Coalesced_{0};
+		std::atomic_uint64_t Remote_{0};
+
+		Validation SingleFlight(const std::string &Key,
+								const std::function<Validation()> &Validate);
+
+		//	user tokens, subscriber tokens and API keys are validated by different endpoints,
+		//	so their negative entries and validations in flight must not be shared
+		static inline std::string TokenKey(const std::string &Token, bool Sub) {
+			return (Sub ? "s:" : "t:") + Token;
+		}
+		static inline std::string ApiKeyKey(const std::string &Key) { return "k:" + Key; }
 	};
 
 	inline auto AuthClient() { return AuthClient::instance(); }
@@ -4,152 +4,159 @@
 
 #pragma once
 
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstring>
 #include <string>
 
-#include "Poco/Net/IPAddress.h"
-#include "Poco/StringTokenizer.h"
-
 #include "framework/OpenWifiTypes.h"
 
 namespace OpenWifi::CIDR {
 
-	static bool cidr_match(const in_addr &addr, const in_addr &net, uint8_t bits) {
-		if (bits == 0) {
-			return true;
-		}
-		return !((addr.s_addr ^ net.s_addr) & htonl(0xFFFFFFFFu << (32 - bits)));
+	//
+	//  All addresses are handled as 128-bit integers. IPv4 addresses are mapped into ::ffff:0:0/96
+	//  so both families can be compared with plain integer arithmetic.
+	//
+	using IPv128 = unsigned __int128;
+
+	//
+	//  A range parsed once, stored as an inclusive [Start, End] interval. Prefix is the CIDR length
+	//  (in the 128-bit space) when the range is an aligned block, 0 otherwise.
+	//
+	struct CompiledRange {
+		IPv128 Start = 0;
+		IPv128 End = 0;
+		uint32_t Prefix = 0;
+	};
+	typedef std::vector<CompiledRange> CompiledRangeVec;
+
+	inline bool operator==(const CompiledRange &A, const CompiledRange &B) {
+		return A.Start == B.Start && A.End == B.End && A.Prefix == B.Prefix;
 	}
 
-	static bool cidr6_match(const in6_addr &address, const in6_addr &network, uint8_t bits) {
-#ifdef __linux__
-		const uint32_t *a = address.s6_addr32;
-		const uint32_t *n = network.s6_addr32;
-#else
-		const uint32_t *a = address.__u6_addr.__u6_addr32;
-		const uint32_t *n = network.__u6_addr.__u6_addr32;
-#endif
-		int bits_whole, bits_incomplete;
-		bits_whole = bits >> 5;		   // number of whole u32
-		bits_incomplete = bits & 0x1F; // number of bits in incomplete u32
-		if (bits_whole) {
-			if (memcmp(a, n, bits_whole << 2) != 0) {
-				return false;
-			}
+	[[nodiscard]] inline bool ToInteger(const char *IP, IPv128 &Value, bool &IPv4) {
+		in_addr A4{};
+		if (inet_pton(AF_INET, IP, &A4) == 1) {
+			Value = ((IPv128)0xffff << 32) | ntohl(A4.s_addr);
+			IPv4 = true;
+			return true;
 		}
-		if (bits_incomplete) {
-			uint32_t mask = htonl((0xFFFFFFFFu) << (32 - bits_incomplete));
-			if ((a[bits_whole] ^ n[bits_whole]) & mask) {
-				return false;
-			}
+		in6_addr A6{};
+		if (inet_pton(AF_INET6, IP, &A6) == 1) {
+			Value = 0;
+			for (auto Byte : A6.s6_addr)
+				Value = (Value << 8) | Byte;
+			IPv4 = false;
+			return true;
 		}
-		return true;
+		return false;
 	}
 
-	static bool ConvertStringToLong(const char *S, unsigned long &L) {
-		char *end;
-		L = std::strtol(S, &end, 10);
-		return end != S;
+	[[nodiscard]] inline bool ToInteger(std::string IP, IPv128 &Value, bool &IPv4) {
+		auto First = IP.find_first_not_of(" \t");
+		auto Last = IP.find_last_not_of(" \t");
+		if (First == std::string::npos)
+			return false;
+		IP = IP.substr(First, Last - First + 1);
+		return ToInteger(IP.c_str(), Value, IPv4);
 	}
 
-	static bool CidrIPinRange(const Poco::Net::IPAddress &IP, const std::string &Range) {
-		Poco::StringTokenizer TimeTokens(Range, "/", Poco::StringTokenizer::TOK_TRIM);
-
-		Poco::Net::IPAddress RangeIP;
-		if (Poco::Net::IPAddress::tryParse(TimeTokens[0], RangeIP)) {
-			if (TimeTokens.count() == 2) {
-				if (RangeIP.family() == Poco::Net::IPAddress::IPv4) {
-					unsigned long MaskLength;
-					if (ConvertStringToLong(TimeTokens[1].c_str(), MaskLength)) {
-						return cidr_match(*static_cast<const in_addr *>(RangeIP.addr()),
-										  *static_cast<const in_addr *>(IP.addr()), MaskLength);
-					}
-				} else if (RangeIP.family() == Poco::Net::IPAddress::IPv6) {
-					unsigned long MaskLength;
-					if (ConvertStringToLong(TimeTokens[1].c_str(), MaskLength)) {
-						return cidr6_match(*static_cast<const in6_addr *>(RangeIP.addr()),
-										   *static_cast<const in6_addr *>(IP.addr()), MaskLength);
-					}
-				}
-			}
-			return false;
-		}
-		return false;
+	[[nodiscard]] inline bool ToInteger(const std::string &IP, IPv128 &Value) {
+		bool IPv4;
+		return ToInteger(IP, Value, IPv4);
+	}
+
+	[[nodiscard]] inline CompiledRange MakePrefix(IPv128 Network, uint32_t Length) {
+		IPv128 HostMask = Length >= 128 ? 0 : (~(IPv128)0 >> Length);
+		return CompiledRange{Network & ~HostMask, Network | HostMask, Length};
 	}
 
 	//
 	//  Ranges can be a single IP, of IP1-IP2, of A set of IPs: IP1,IP2,IP3, or a cidr IP/24
 	//  These can work for IPv6 too...
 	//
-	static bool ValidateRange(const std::string &R) {
-
-		auto Tokens = Poco::StringTokenizer(R, "-");
-		if (Tokens.count() == 2) {
-			Poco::Net::IPAddress a, b;
-			if (!Poco::Net::IPAddress::tryParse(Tokens[0], a) &&
-				Poco::Net::IPAddress::tryParse(Tokens[1], b))
+	[[nodiscard]] inline bool CompileRange(const std::string &R, CompiledRangeVec &Ranges) {
+		IPv128 Start, End;
+		bool StartIsV4, EndIsV4;
+
+		auto Dash = R.find('-');
+		if (Dash != std::string::npos) {
+			if (!ToInteger(R.substr(0, Dash), Start, StartIsV4) ||
+				!ToInteger(R.substr(Dash + 1), End, EndIsV4) || StartIsV4 != EndIsV4 ||
+				Start > End)
 				return false;
-			return a.family() == b.family();
+			Ranges.push_back(CompiledRange{Start, End, 0});
+			return true;
 		}
 
-		Tokens = Poco::StringTokenizer(R, ",");
-		if (Tokens.count() > 1) {
-			return std::all_of(Tokens.begin(), Tokens.end(), [](const std::string &A) {
-				Poco::Net::IPAddress a;
-				return Poco::Net::IPAddress::tryParse(A, a);
-			});
+		if (R.find(',') != std::string::npos) {
+			std::string::size_type Begin = 0;
+			while (Begin <= R.size()) {
+				auto Comma = R.find(',', Begin);
+				if (Comma == std::string::npos)
+					Comma = R.size();
+				if (!ToInteger(R.substr(Begin, Comma - Begin), Start, StartIsV4))
+					return false;
+				Ranges.push_back(MakePrefix(Start, 128));
+				Begin = Comma + 1;
+			}
+			return true;
 		}
 
-		Tokens = Poco::StringTokenizer(R, "/");
-		if (Tokens.count() == 2) {
-			Poco::Net::IPAddress a;
-			if (!Poco::Net::IPAddress::tryParse(Tokens[0], a))
+		auto Slash = R.find('/');
+		if (Slash != std::string::npos) {
+			if (!ToInteger(R.substr(0, Slash), Start, StartIsV4))
+				return false;
+			char *EndPtr;
+			auto Length = std::strtoul(R.c_str() + Slash + 1, &EndPtr, 10);
+			if (EndPtr == R.c_str() + Slash + 1 || Length == 0)
 				return false;
-			if (std::atoi(Tokens[1].c_str()) == 0)
+			if (StartIsV4)
+				Length += 96;
+			if (Length > 128)
 				return false;
+			Ranges.push_back(MakePrefix(Start, Length));
 			return true;
 		}
 
-		Poco::Net::IPAddress a;
-		return Poco::Net::IPAddress::tryParse(R, a);
+		if (!ToInteger(R, Start, StartIsV4))
+			return false;
+		Ranges.push_back(MakePrefix(Start, 128));
+		return true;
 	}
 
-	static bool IpInRange(const Poco::Net::IPAddress &target, const std::string &R) {
-
-		auto Tokens = Poco::StringTokenizer(R, "-");
-		if (Tokens.count() == 2) {
-			auto a = Poco::Net::IPAddress::parse(Tokens[0]);
-			auto b = Poco::Net::IPAddress::parse(Tokens[1]);
-			if (target.family() != a.family())
-				return false;
-			return (a <= target && b >= target);
-		}
-
-		Tokens = Poco::StringTokenizer(R, ",");
-		if (Tokens.count() > 1) {
-			return std::any_of(Tokens.begin(), Tokens.end(), [target](const std::string &Element) {
-				return Poco::Net::IPAddress::parse(Element) == target;
-			});
-		}
+	[[nodiscard]] inline bool CompileRanges(const Types::StringVec &R, CompiledRangeVec &Ranges) {
+		bool Valid = true;
+		for (const auto &i : R)
+			Valid &= CompileRange(i, Ranges);
+		return Valid;
+	}
 
-		Tokens = Poco::StringTokenizer(R, "/");
-		if (Tokens.count() == 2) {
-			return CidrIPinRange(target, R);
-		}
+	//  a single unsigned comparison: anything below Start wraps around to a huge value
+	[[nodiscard]] inline bool InRange(IPv128 IP, const CompiledRange &R) {
+		return (IP - R.Start) <= (R.End - R.Start);
+	}
 
-		return Poco::Net::IPAddress::parse(R) == target;
+	//  batch form: one address against many ranges, without a data dependent branch per range
+	[[nodiscard]] inline bool InRanges(IPv128 IP, const CompiledRangeVec &Ranges) {
+		bool Match = false;
+		for (const auto &R : Ranges)
+			Match |= InRange(IP, R);
+		return Match;
 	}
 
 	[[nodiscard]] inline bool IpInRanges(const std::string &IP, const Types::StringVec &R) {
-		Poco::Net::IPAddress Target;
-
-		if (!Poco::Net::IPAddress::tryParse(IP, Target))
+		IPv128 Target;
+		if (!ToInteger(IP, Target))
 			return false;
 
-		return std::any_of(cbegin(R), cend(R),
-						   [Target](const std::string &i) { return IpInRange(Target, i); });
+		CompiledRangeVec Ranges;
+		(void)CompileRanges(R, Ranges);
+		return InRanges(Target, Ranges);
 	}
 
 	[[nodiscard]] inline bool ValidateIpRanges(const Types::StringVec &Ranges) {
-		return std::all_of(cbegin(Ranges), cend(Ranges), ValidateRange);
+		CompiledRangeVec Compiled;
+		return CompileRanges(Ranges, Compiled);
 	}
-} // namespace OpenWifi::CIDR
\ No newline at end of file
+} // namespace OpenWifi::CIDR
@@ -0,0 +1,194 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Poco/NumberFormatter.h"
+
+namespace OpenWifi {
+
+	/*
+	 * Writes JSON text straight into a reusable buffer. The output is byte-for-byte what
+	 * Poco::JSON::Stringifier produces for the equivalent Poco::JSON::Object: members sorted by
+	 * key (a later duplicate replaces the earlier one), no whitespace, and Poco's string escaping
+	 * (control characters, '"', '\' and '/'; other UTF-8 is copied as is). Members can be written
+	 * in any order; an object is only rearranged when its keys did not arrive sorted.
+	 * ProvObjects::VerifyJSONWriter checks this at startup and clears Enabled on any difference,
+	 * which sends the list endpoints back to Poco::JSON.
+	 */
+	class JSONWriter {
+	  public:
+		static inline std::atomic_bool Enabled{true};
+
+		inline void Clear() {
+			Buffer_.clear();
+			Frames_.clear();
+			Members_.clear();
+			ArrayFirst_.clear();
+		}
+
+		[[nodiscard]] inline const std::string &str() const { return Buffer_; }
+
+		template <typename T> inline const std::string &Write(const T &Object) {
+			Clear();
+			BeginObject();
+			Object.to_json(*this);
+			EndObject();
+			return Buffer_;
+		}
+
+		inline void BeginObject() {
+			Buffer_ += '{';
+			Frames_.push_back(Frame{Buffer_.size(), Members_.size()});
+		}
+
+		inline void EndObject() {
+			auto F = Frames_.back();
+			Frames_.pop_back();
+			auto First = Members_.begin() + F.FirstMember;
+			if (First != Members_.end()) {
+				Members_.back().End = Buffer_.size();
+				bool Sorted = true;
+				for (auto M = First + 1; M != Members_.end() && Sorted; ++M)
+					Sorted = std::strcmp((M - 1)->Key, M->Key) < 0;
+				if (!Sorted)
+					Reorder(F);
+				Members_.resize(F.FirstMember);
+			}
+			Buffer_ += '}';
+		}
+
+		inline void Key(const char *Name) {
+			if (Members_.size() > Frames_.back().FirstMember) {
+				Members_.back().End = Buffer_.size();
+				Buffer_ += ',';
+			}
+			Members_.push_back(Member{Name, Buffer_.size(), 0});
+			String(Name);
+			Buffer_ += ':';
+		}
+
+		inline void BeginArray() {
+			Buffer_ += '[';
+			ArrayFirst_.push_back(true);
+		}
+
+		inline void EndArray() {
+			ArrayFirst_.pop_back();
+			Buffer_ += ']';
+		}
+
+		//	Must be called before each element of an array.
+		inline void Element() {
+			if (!ArrayFirst_.back())
+				Buffer_ += ',';
+			ArrayFirst_.back() = false;
+		}
+
+		inline void Bool(bool V) { Buffer_ += V ? "true" : "false"; }
+
+		template <typename T> inline void Integer(T V) {
+			char Digits[24];
+			auto R = std::to_chars(Digits, Digits + sizeof(Digits), V);
+			Buffer_.append(Digits, R.ptr);
+		}
+
+		inline void Double(double V) { Buffer_ += Poco::NumberFormatter::format(V); }
+
+		inline void String(const char *S) { String(S, std::strlen(S)); }
+		inline void String(const std::string &S) { String(S.data(), S.size()); }
+
+		inline void String(const char *S, std::size_t Size) {
+			static const char Hex[] = "0123456789ABCDEF";
+			Buffer_ += '"';
+			auto Run = S;
+			for (auto C = S, End = S + Size; C != End; ++C) {
+				const char *Escape = nullptr;
+				switch (*C) {
+				case '"':
+					Escape = "\\\"";
+					break;
+				case '\\':
+					Escape = "\\\\";
+					break;
+				case '/':
+					Escape = "\\/";
+					break;
+				case '\n':
+					Escape = "\\n";
+					break;
+				case '\t':
+					Escape = "\\t";
+					break;
+				case '\r':
+					Escape = "\\r";
+					break;
+				case '\b':
+					Escape = "\\b";
+					break;
+				case '\f':
+					Escape = "\\f";
+					break;
+				default:
+					if (*C >= 0 && *C < 0x20) {
+						Buffer_.append(Run, C);
+						Buffer_ += "\\u00";
+						Buffer_ += Hex[(*C >> 4) & 0x0f];
+						Buffer_ += Hex[*C & 0x0f];
+						Run = C + 1;
+					}
+					continue;
+				}
+				Buffer_.append(Run, C);
+				Buffer_ += Escape;
+				Run = C + 1;
+			}
+			Buffer_.append(Run, S + Size);
+			Buffer_ += '"';
+		}
+
+	  private:
+		struct Frame {
+			std::size_t Begin;		 //	first byte after '{'
+			std::size_t FirstMember; //	index in Members_
+		};
+
+		struct Member {
+			const char *Key;
+			std::size_t Begin, End; //	the member text, without the separating comma
+		};
+
+		std::string Buffer_;
+		std::string Scratch_;
+		std::vector<Frame> Frames_;
+		std::vector<Member> Members_;
+		std::vector<bool> ArrayFirst_;
+
+		inline void Reorder(const Frame &F) {
+			auto First = Members_.begin() + F.FirstMember;
+			std::stable_sort(First, Members_.end(), [](const Member &A, const Member &B) {
+				return std::strcmp(A.Key, B.Key) < 0;
+			});
+			Scratch_.clear();
+			for (auto M = First; M != Members_.end(); ++M) {
+				//	Keep only the last of equal keys, like Poco::JSON::Object::set
+				if (M + 1 != Members_.end() && std::strcmp(M->Key, (M + 1)->Key) == 0)
+					continue;
+				if (!Scratch_.empty())
+					Scratch_ += ',';
+				Scratch_.append(Buffer_, M->Begin, M->End - M->Begin);
+			}
+			Buffer_.resize(F.Begin);
+			Buffer_ += Scratch_;
+		}
+	};
+
+} // namespace OpenWifi
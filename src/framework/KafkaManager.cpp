@@ -4,6 +4,9 @@
 
 #include "KafkaManager.h"
 
+#include "Poco/Environment.h"
+#include "Poco/JSON/Array.h"
+
 #include "fmt/format.h"
 #include "framework/MicroServiceFuncs.h"
 
@@ -233,32 +236,141 @@ namespace OpenWifi {
 		}
 	}
 
-	void KafkaDispatcher::Start() {
+	void KafkaDispatcherWorker::Start(KafkaDispatcher *Dispatcher, uint64_t Index,
+									  uint64_t MaxDepth) {
 		if (!Running_) {
+			Dispatcher_ = Dispatcher;
+			Index_ = Index;
+			MaxDepth_ = MaxDepth;
 			Running_ = true;
 			Worker_.start(*this);
 		}
 	}
 
+	void KafkaDispatcherWorker::Stop() {
+		if (Running_) {
+			{
+				std::lock_guard G(Mutex_);
+				Running_ = false;
+			}
+			Available_.notify_all();
+			Room_.notify_all();
+			Worker_.join();
+		}
+	}
+
+	//	Called from the consumer thread only. A full queue blocks it until the watchers catch up, so
+	//	the consumer stops polling instead of losing messages or exhausting memory.
+	void KafkaDispatcherWorker::Enqueue(const std::string &Topic, const std::string &Key,
+										const std::shared_ptr<std::string> &Payload) {
+		{
+			std::unique_lock Lock(Mutex_);
+			auto &S = Stats_[Topic];
+			if (MaxDepth_ > 0 && S.Depth >= MaxDepth_) {
+				S.Stalled++;
+				poco_warning(KafkaManager()->Logger(),
+							 fmt::format("Dispatcher {}: {} messages waiting on topic {}, pausing "
+										 "the consumer.",
+										 Index_, S.Depth, Topic));
+				Room_.wait(Lock, [this, &S] { return S.Depth < MaxDepth_ || !Running_; });
+				if (!Running_)
+					return;
+			}
+			Queues_[Topic].push_back(Entry{Key, Payload});
+			S.Depth++;
+			if (S.Depth > S.HighWater)
+				S.HighWater = S.Depth;
+			Pending_++;
+		}
+		Available_.notify_one();
+	}
+
+	void KafkaDispatcherWorker::Stats(std::map<std::string, TopicStats> &S) {
+		std::lock_guard G(Mutex_);
+		for (const auto &[Topic, Current] : Stats_) {
+			auto &Total = S[Topic];
+			Total.Depth += Current.Depth;
+			Total.HighWater = std::max(Total.HighWater, Current.HighWater);
+			Total.Dispatched += Current.Dispatched;
+			Total.Stalled += Current.Stalled;
+		}
+	}
+
+	void KafkaDispatcherWorker::run() {
+		Utils::SetThreadName(fmt::format("kafka:disp{}", Index_).c_str());
+		std::vector<std::pair<std::string, Entry>> Batch;
+		while (Running_) {
+			{
+				std::unique_lock Lock(Mutex_);
+				Available_.wait(Lock, [this] { return Pending_ > 0 || !Running_; });
+				if (!Running_)
+					break;
+				//	take at most one message per topic on each pass to keep topics fair
+				for (auto &[Topic, Queue] : Queues_) {
+					if (Queue.empty())
+						continue;
+					Batch.emplace_back(Topic, std::move(Queue.front()));
+					Queue.pop_front();
+					auto &S = Stats_[Topic];
+					S.Depth--;
+					S.Dispatched++;
+					Pending_--;
+				}
+			}
+			Room_.notify_all();
+			for (const auto &[Topic, Msg] : Batch) {
+				try {
+					Dispatcher_->Deliver(Topic, Msg.Key, *Msg.Payload);
+				} catch (const Poco::Exception &E) {
+					KafkaManager()->Logger().log(E);
+				} catch (...) {
+					poco_error(KafkaManager()->Logger(),
+							   fmt::format("Exception while dispatching message on topic {}", Topic));
+				}
+			}
+			Batch.clear();
+		}
+	}
+
+	void KafkaDispatcher::Start() {
+		if (!Running_) {
+			Running_ = true;
+			auto NumberOfWorkers = MicroServiceConfigGetInt("openwifi.kafka.dispatcher.workers",
+															Poco::Environment::processorCount());
+			if (NumberOfWorkers == 0)
+				NumberOfWorkers = 1;
+			auto MaxDepth = MicroServiceConfigGetInt("openwifi.kafka.dispatcher.queue.max", 10000);
+			poco_information(KafkaManager()->Logger(),
+							 fmt::format("Starting {} dispatcher workers.", NumberOfWorkers));
+			std::lock_guard G(Mutex_);
+			for (uint64_t i = 0; i < NumberOfWorkers; ++i) {
+				Workers_.emplace_back(std::make_unique<KafkaDispatcherWorker>());
+				Workers_.back()->Start(this, i, MaxDepth);
+			}
+		}
+	}
+
 	void KafkaDispatcher::Stop() {
 		if (Running_) {
 			Running_ = false;
-			Queue_.wakeUpAll();
-			Worker_.join();
+			std::vector<std::unique_ptr<KafkaDispatcherWorker>> Workers;
+			{
+				std::lock_guard G(Mutex_);
+				Workers.swap(Workers_);
+			}
+			for (auto &Worker : Workers)
+				Worker->Stop();
 		}
 	}
 
 	auto KafkaDispatcher::RegisterTopicWatcher(const std::string &Topic,
 											   Types::TopicNotifyFunction &F) {
 		std::lock_guard G(Mutex_);
-		auto It = Notifiers_.find(Topic);
-		if (It == Notifiers_.end()) {
-			Types::TopicNotifyFunctionList L;
-			L.emplace(L.end(), std::make_pair(F, FunctionId_));
-			Notifiers_[Topic] = std::move(L);
-		} else {
-			It->second.emplace(It->second.end(), std::make_pair(F, FunctionId_));
-		}
+		auto &Current = Notifiers_[Topic];
+		auto L = Current ? std::make_shared<Types::TopicNotifyFunctionList>(*Current)
+						 : std::make_shared<Types::TopicNotifyFunctionList>();
+		L->emplace(L->end(), std::make_pair(F, FunctionId_));
+		Current = std::move(L);
 		return FunctionId_++;
 	}
 
@@ -266,52 +378,81 @@ namespace OpenWifi {
 		std::lock_guard G(Mutex_);
 		auto It = Notifiers_.find(Topic);
 		if (It != Notifiers_.end()) {
-			Types::TopicNotifyFunctionList &L = It->second;
-			for (auto it = L.begin(); it != L.end(); it++)
+			auto L = std::make_shared<Types::TopicNotifyFunctionList>(*It->second);
+			for (auto it = L->begin(); it != L->end(); it++)
 				if (it->second == Id) {
-					L.erase(it);
+					L->erase(it);
 					break;
 				}
+			It->second = std::move(L);
 		}
 	}
 
 	void KafkaDispatcher::Dispatch(const char *Topic, const std::string &Key,
 								   const std::shared_ptr<std::string> Payload) {
 		std::lock_guard G(Mutex_);
-		auto It = Notifiers_.find(Topic);
-		if (It != Notifiers_.end()) {
-			Queue_.enqueueNotification(new KafkaMessage(Topic, Key, Payload));
-		}
+		if (Notifiers_.find(Topic) == Notifiers_.end() || Workers_.empty())
+			return;
+		//	the same key always lands on the same worker, so per-device ordering is preserved
+		auto Index = std::hash<std::string>{}(Key) % Workers_.size();
+		Workers_[Index]->Enqueue(Topic, Key, Payload);
 	}
 
-	void KafkaDispatcher::run() {
-		Poco::Logger &Logger_ =
-			Poco::Logger::create("KAFKA-DISPATCHER", KafkaManager()->Logger().getChannel());
-		poco_information(Logger_, "Starting...");
-		Poco::AutoPtr<Poco::Notification> Note(Queue_.waitDequeueNotification());
-		Utils::SetThreadName("kafka:dispatch");
-		while (Note && Running_) {
-			auto Msg = dynamic_cast<KafkaMessage *>(Note.get());
-			if (Msg != nullptr) {
-				auto It = Notifiers_.find(Msg->Topic());
-				if (It != Notifiers_.end()) {
-					const auto &FL = It->second;
-					for (const auto &[CallbackFunc, _] : FL) {
-						CallbackFunc(Msg->Key(), Msg->Payload());
-					}
-				}
-			}
-			Note = Queue_.waitDequeueNotification();
+	void KafkaDispatcher::Deliver(const std::string &Topic, const std::string &Key,
+								  const std::string &Payload) {
+		std::shared_ptr<const Types::TopicNotifyFunctionList> FL;
+		{
+			std::lock_guard G(Mutex_);
+			auto It = Notifiers_.find(Topic);
+			if (It == Notifiers_.end())
+				return;
+			FL = It->second;
+		}
+		for (const auto &[CallbackFunc, _] : *FL) {
+			CallbackFunc(Key, Payload);
 		}
-		poco_information(Logger_, "Stopped...");
 	}
 
 	void KafkaDispatcher::Topics(std::vector<std::string> &T) {
+		std::lock_guard G(Mutex_);
 		T.clear();
 		for (const auto &[TopicName, _] : Notifiers_)
 			T.push_back(TopicName);
 	}
 
+	void KafkaDispatcher::Stats(Poco::JSON::Object &Answer) {
+		std::lock_guard G(Mutex_);
+		std::map<std::string, KafkaDispatcherWorker::TopicStats> Totals;
+		Poco::JSON::Array WorkerDepths;
+		for (auto &Worker : Workers_) {
+			std::map<std::string, KafkaDispatcherWorker::TopicStats> WorkerStats;
+			Worker->Stats(WorkerStats);
+			uint64_t Depth = 0;
+			for (const auto &[Topic, S] : WorkerStats) {
+				Depth += S.Depth;
+				auto &Total = Totals[Topic];
+				Total.Depth += S.Depth;
+				Total.HighWater = std::max(Total.HighWater, S.HighWater);
+				Total.Dispatched += S.Dispatched;
+				Total.Stalled += S.Stalled;
+			}
+			WorkerDepths.add(Depth);
+		}
+		Poco::JSON::Array TopicArray;
+		for (const auto &[Topic, S] : Totals) {
+			Poco::JSON::Object Entry;
+			Entry.set("topic", Topic);
+			Entry.set("depth", S.Depth);
+			Entry.set("highWater", S.HighWater);
+			Entry.set("dispatched", S.Dispatched);
+			Entry.set("stalled", S.Stalled);
+			TopicArray.add(Entry);
+		}
+		Answer.set("workers", Workers_.size());
+		Answer.set("workerDepths", WorkerDepths);
+		Answer.set("topics", TopicArray);
+	}
+
 	int KafkaManager::Start() {
 		if (!KafkaEnabled_)
 			return 0;
@@ -366,6 +507,14 @@ namespace OpenWifi {
 
 	void KafkaManager::Topics(std::vector<std::string> &T) { Dispatcher_.Topics(T); }
 
+	void KafkaManager::Stats(Poco::JSON::Object &Answer) {
+		if (KafkaEnabled_) {
+			Poco::JSON::Object DispatcherStats;
+			Dispatcher_.Stats(DispatcherStats);
+			Answer.set("dispatcher", DispatcherStats);
+		}
+	}
+
 	void KafkaManager::PartitionAssignment(const cppkafka::TopicPartitionList &partitions) {
 		poco_information(
 			Logger(), fmt::format("Partition assigned: {}...", partitions.front().get_partition()));
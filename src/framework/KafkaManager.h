@@ -4,6 +4,10 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+
+#include "Poco/JSON/Object.h"
 #include "Poco/Notification.h"
 #include "Poco/NotificationQueue.h"
 
@@ -57,23 +61,62 @@ namespace OpenWifi {
 		mutable std::atomic_bool Running_ = false;
 	};
 
-	class KafkaDispatcher : public Poco::Runnable {
+	class KafkaDispatcher;
+
+	class KafkaDispatcherWorker : public Poco::Runnable {
+	  public:
+		struct Entry {
+			std::string Key;
+			std::shared_ptr<std::string> Payload;
+		};
+
+		struct TopicStats {
+			uint64_t Depth = 0;
+			uint64_t HighWater = 0;
+			uint64_t Dispatched = 0;
+			uint64_t Stalled = 0; //	times the consumer waited for room
+		};
+
+		void Start(KafkaDispatcher *Dispatcher, uint64_t Index, uint64_t MaxDepth);
+		void Stop();
+		void Enqueue(const std::string &Topic, const std::string &Key,
+					 const std::shared_ptr<std::string> &Payload);
+		void run() override;
+		void Stats(std::map<std::string, TopicStats> &S);
+
+	  private:
+		std::mutex Mutex_;
+		std::condition_variable Available_;
+		std::condition_variable Room_;
+		//	one queue per topic, serviced round-robin so a burst on one topic cannot starve the others
+		std::map<std::string, std::deque<Entry>> Queues_;
+		std::map<std::string, TopicStats> Stats_;
+		Poco::Thread Worker_;
+		KafkaDispatcher *Dispatcher_ = nullptr;
+		uint64_t Index_ = 0;
+		uint64_t Pending_ = 0;
+		uint64_t MaxDepth_ = 0; //	per topic, 0: unbounded
+		mutable std::atomic_bool Running_ = false;
+	};
+
+	class KafkaDispatcher {
 	  public:
 		void Start();
 		void Stop();
 		auto RegisterTopicWatcher(const std::string &Topic, Types::TopicNotifyFunction &F);
 		void UnregisterTopicWatcher(const std::string &Topic, int Id);
 		void Dispatch(const char *Topic, const std::string &Key, const std::shared_ptr<std::string> Payload);
-		void run() override;
+		void Deliver(const std::string &Topic, const std::string &Key, const std::string &Payload);
 		void Topics(std::vector<std::string> &T);
+		void Stats(Poco::JSON::Object &Answer);
 
 	  private:
 		std::recursive_mutex Mutex_;
-		Types::NotifyTable Notifiers_;
-		Poco::Thread Worker_;
-		mutable std::atomic_bool Running_ = false;
+		//	replaced, never modified, so delivering a message only copies a pointer
+		std::map<std::string, std::shared_ptr<const Types::TopicNotifyFunctionList>> Notifiers_;
 		uint64_t FunctionId_ = 1;
-		Poco::NotificationQueue Queue_;
+		std::vector<std::unique_ptr<KafkaDispatcherWorker>> Workers_;
+		mutable std::atomic_bool Running_ = false;
 	};
 
 	class KafkaManager : public SubSystemServer {
@@ -99,6 +142,7 @@ namespace OpenWifi {
 		uint64_t RegisterTopicWatcher(const std::string &Topic, Types::TopicNotifyFunction &F);
 		void UnregisterTopicWatcher(const std::string &Topic, uint64_t Id);
 		void Topics(std::vector<std::string> &T);
+		void Stats(Poco::JSON::Object &Answer) override;
 
 	  private:
 		bool KafkaEnabled_ = false;
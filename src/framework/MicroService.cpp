@@ -25,6 +25,7 @@
 #include "framework/RESTAPI_ExtServer.h"
 #include "framework/RESTAPI_GenericServerAccounting.h"
 #include "framework/RESTAPI_IntServer.h"
+#include "framework/RESTAPI_RateLimiter.h"
 #include "framework/UI_WebSocketClientServer.h"
 #include "framework/WebSocketLogger.h"
 #include "framework/utils.h"
@@ -393,11 +394,13 @@ namespace OpenWifi {
 
 		SubSystems_.push_back(KafkaManager());
 		SubSystems_.push_back(ALBHealthCheckServer());
-		SubSystems_.push_back(RESTAPI_ExtServer());
-		SubSystems_.push_back(RESTAPI_IntServer());
+		SubSystems_.push_back(RESTAPI_RateLimiter());
 #ifndef TIP_SECURITY_SERVICE
+		//	the token caches are sized in Start(), before the servers take requests
 		SubSystems_.push_back(AuthClient());
 #endif
+		SubSystems_.push_back(RESTAPI_ExtServer());
+		SubSystems_.push_back(RESTAPI_IntServer());
 		Poco::Net::initializeSSL();
 		Poco::Net::HTTPStreamFactory::registerFactory();
 		Poco::Net::HTTPSStreamFactory::registerFactory();
@@ -0,0 +1,170 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "Poco/JSON/Object.h"
+
+#include "framework/JSONWriter.h"
+#include "framework/RESTAPI_utils.h"
+
+namespace OpenWifi::RESTAPI_utils {
+
+	/*
+	 * Field tables: one constexpr list of (JSON name, member pointer) per struct drives
+	 * to_json(Poco::JSON::Object &), to_json(JSONWriter &) and from_json(), so the directions
+	 * cannot drift apart. The kind of each field comes from the member type and is resolved by the
+	 * usual field_to_json/field_from_json overloads at compile time. Embedded members (ObjectInfo
+	 * "info") share the JSON object of their owner.
+	 *
+	 * from_json walks the keys present in the incoming object once, matches them against the
+	 * precomputed hashes and converts the value it already holds, so absent fields cost nothing
+	 * and present ones are never looked up again.
+	 */
+	constexpr uint64_t FieldHash(std::string_view Name) {
+		uint64_t Hash = 14695981039346656037ULL;
+		for (auto c : Name) {
+			Hash ^= (unsigned char)c;
+			Hash *= 1099511628211ULL;
+		}
+		return Hash;
+	}
+
+	template <typename Class, typename Type> struct FieldDescriptor {
+		const char *Name;
+		Type Class::*Member;
+		uint64_t Hash;
+	};
+
+	template <typename Class, typename Type> struct EmbeddedDescriptor {
+		Type Class::*Member;
+	};
+
+	template <typename Class, typename Type>
+	constexpr auto Field(const char *Name, Type Class::*Member) {
+		return FieldDescriptor<Class, Type>{Name, Member, FieldHash(Name)};
+	}
+
+	template <typename Class, typename Type> constexpr auto Embedded(Type Class::*Member) {
+		return EmbeddedDescriptor<Class, Type>{Member};
+	}
+
+	template <typename Out, typename Class, typename Type>
+	inline void table_field_to_json(Out &O, const Class &C, const FieldDescriptor<Class, Type> &F) {
+		field_to_json(O, F.Name, C.*F.Member);
+	}
+
+	template <typename Out, typename Class, typename Type>
+	inline void table_field_to_json(Out &O, const Class &C,
+									const EmbeddedDescriptor<Class, Type> &F) {
+		(C.*F.Member).to_json(O);
+	}
+
+	//	Out is Poco::JSON::Object or JSONWriter
+	template <typename Out, typename Class, typename... Fields>
+	inline void fields_to_json(Out &O, const Class &C, const std::tuple<Fields...> &Table) {
+		std::apply([&](const auto &...F) { (table_field_to_json(O, C, F), ...); }, Table);
+	}
+
+	template <typename Type> struct IsVector : std::false_type {};
+	template <typename Type, typename Alloc>
+	struct IsVector<std::vector<Type, Alloc>> : std::true_type {};
+
+	//	the conversions of the field_from_json overloads, applied to a value already found
+	template <typename Type> inline void value_from_json(const Poco::Dynamic::Var &V, Type &Value) {
+		if constexpr (std::is_same_v<Type, std::string>) {
+			Value = V.toString();
+		} else if constexpr (std::is_same_v<Type, bool>) {
+			Value = (V.toString() == "true");
+		} else if constexpr (std::is_arithmetic_v<Type>) {
+			Value = (Type)V;
+		} else if constexpr (std::is_same_v<Type, Poco::Data::BLOB>) {
+			auto Result = Utils::base64decode(V.toString());
+			Value.assignRaw((const unsigned char *)&Result[0], Result.size());
+		} else if constexpr (IsVector<Type>::value) {
+			if (V.type() != typeid(Poco::JSON::Array::Ptr))
+				return;
+			const auto &A = V.extract<Poco::JSON::Array::Ptr>();
+			if constexpr (std::is_same_v<Type, Types::StringPairVec>) {
+				for (const auto &i : *A) {
+					std::string S1, S2;
+					auto Inner = i.extract<Poco::JSON::Object::Ptr>();
+					if (Inner->has("tag"))
+						S1 = Inner->get("tag").toString();
+					if (Inner->has("value"))
+						S2 = Inner->get("value").toString();
+					Value.emplace_back(S1, S2);
+				}
+			} else if constexpr (std::is_same_v<Type, Types::StringVec>) {
+				Value.clear();
+				for (const auto &i : *A)
+					Value.push_back(i.toString());
+			} else if constexpr (std::is_same_v<Type, Types::TagList>) {
+				Value.clear();
+				for (const auto &i : *A)
+					Value.push_back(i);
+			} else {
+				for (const auto &i : *A) {
+					typename Type::value_type NewItem;
+					NewItem.from_json(i.extract<Poco::JSON::Object::Ptr>());
+					Value.push_back(NewItem);
+				}
+			}
+		} else {
+			if (V.type() == typeid(Poco::JSON::Object::Ptr))
+				Value.from_json(V.extract<Poco::JSON::Object::Ptr>());
+		}
+	}
+
+	template <typename Class, typename Type>
+	inline bool table_field_from_json(const std::string &Key, const Poco::Dynamic::Var &Value,
+									  uint64_t Hash, Class &C,
+									  const FieldDescriptor<Class, Type> &F) {
+		if (F.Hash != Hash || Key != F.Name)
+			return false;
+		if (!Value.isEmpty())
+			value_from_json(Value, C.*F.Member);
+		return true;
+	}
+
+	template <typename Class, typename Type>
+	inline bool table_field_from_json(const std::string &, const Poco::Dynamic::Var &, uint64_t,
+									  Class &, const EmbeddedDescriptor<Class, Type> &) {
+		return false;
+	}
+
+	template <typename Class, typename Type>
+	inline void table_embedded_from_json(const Poco::JSON::Object::Ptr &, Class &,
+										 const FieldDescriptor<Class, Type> &) {}
+
+	template <typename Class, typename Type>
+	inline void table_embedded_from_json(const Poco::JSON::Object::Ptr &Obj, Class &C,
+										 const EmbeddedDescriptor<Class, Type> &F) {
+		(C.*F.Member).from_json(Obj);
+	}
+
+	template <typename Class, typename... Fields>
+	inline bool fields_from_json(const Poco::JSON::Object::Ptr &Obj, Class &C,
+								 const std::tuple<Fields...> &Table) {
+		if (Obj.isNull())
+			return false;
+		std::apply(
+			[&](const auto &...F) {
+				(table_embedded_from_json(Obj, C, F), ...);
+				for (const auto &[Key, Value] : *Obj) {
+					auto Hash = FieldHash(Key);
+					(void)(table_field_from_json(Key, Value, Hash, C, F) || ...);
+				}
+			},
+			Table);
+		return true;
+	}
+
+} // namespace OpenWifi::RESTAPI_utils
@@ -4,24 +4,32 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <map>
+#include <sstream>
 #include <string>
+#include <typeinfo>
 #include <vector>
 
 #include "Poco/DeflatingStream.h"
 #include "Poco/JSON/Object.h"
 #include "Poco/JSON/Parser.h"
+#include "Poco/JSON/Stringifier.h"
 #include "Poco/Logger.h"
 #include "Poco/Net/HTTPRequestHandler.h"
 #include "Poco/Net/HTTPResponse.h"
 #include "Poco/Net/HTTPServerResponse.h"
 #include "Poco/Net/OAuth20Credentials.h"
 #include "Poco/TemporaryFile.h"
+#include "Poco/URI.h"
 
 #include "RESTObjects/RESTAPI_SecurityObjects.h"
 #include "framework/AuthClient.h"
 #include "framework/RESTAPI_GenericServerAccounting.h"
 #include "framework/RESTAPI_RateLimiter.h"
+#include "framework/RESTAPI_ResponseCache.h"
+#include "framework/RESTAPI_RouteTrie.h"
 #include "framework/RESTAPI_utils.h"
 #include "framework/ow_constants.h"
 #include "framework/utils.h"
@@ -75,6 +83,13 @@ namespace OpenWifi {
 				//				std::string th_name = "restsvr_" + std::to_string(TransactionId_);
 				//				Utils::SetThreadName(th_name.c_str());
 
+				//	keyed by handler class, i.e. by route template, and checked before any parsing
+				if (RateLimited_ &&
+					RESTAPI_RateLimiter()->IsRateLimited(RequestIn, typeid(*this).hash_code(),
+														 MyRates_.Interval, MyRates_.MaxCalls)) {
+					return UnAuthorized(RESTAPI::Errors::RATE_LIMIT_EXCEEDED);
+				}
+
 				if (Request->getContentLength() > 0) {
 					if (Request->getContentType().find("application/json") != std::string::npos) {
 						ParsedBody_ = IncomingParser_.parse(Request->stream())
@@ -82,11 +97,6 @@ namespace OpenWifi {
 					}
 				}
 
-				if (RateLimited_ && RESTAPI_RateLimiter()->IsRateLimited(
-										RequestIn, MyRates_.Interval, MyRates_.MaxCalls)) {
-					return UnAuthorized(RESTAPI::Errors::RATE_LIMIT_EXCEEDED);
-				}
-
 				if (!ContinueProcessing())
 					return;
 
@@ -529,7 +539,8 @@ namespace OpenWifi {
 		inline void ReturnStatus(Poco::Net::HTTPResponse::HTTPStatus Status,
 								 bool CloseConnection = false) {
 			PrepareResponse(Status, CloseConnection);
-			if (Status == Poco::Net::HTTPResponse::HTTP_NO_CONTENT) {
+			if (Status == Poco::Net::HTTPResponse::HTTP_NO_CONTENT ||
+				Status == Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED) {
 				Response->setContentLength(0);
 				Response->erase("Content-Type");
 				Response->setChunkedTransferEncoding(false);
@@ -552,23 +563,82 @@ namespace OpenWifi {
 
 		inline bool IsAuthorized(bool &Expired, bool &Contacted, bool SubOnly = false);
 
+		[[nodiscard]] inline bool ClientAcceptsCompression() const {
+			if (Request == nullptr)
+				return false;
+			auto AcceptedEncoding = Request->find("Accept-Encoding");
+			return AcceptedEncoding != Request->end() &&
+				   (AcceptedEncoding->second.find("gzip") != std::string::npos ||
+					AcceptedEncoding->second.find("compress") != std::string::npos);
+		}
+
+		/*
+		 *	Conditional GET. The ETag is always attached to the answer; when it matches
+		 *	If-None-Match, a 304 has been sent and the caller must return without sending anything.
+		 *	Answers with extended info pull names from other tables, so they never get a validator.
+		 */
+		inline bool NotModified(const std::string &ETag) {
+			Response->set("ETag", ETag);
+			auto IfNoneMatch = Request->find("If-None-Match");
+			if (IfNoneMatch == Request->end() || !ETagMatches(IfNoneMatch->second, ETag))
+				return false;
+			ReturnStatus(Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED);
+			return true;
+		}
+
+		template <typename DB>
+		inline bool RecordNotModified(DB &D, const std::string &Id, uint64_t Modified) {
+			if (NeedAdditionalInfo())
+				return false;
+			return NotModified(MakeETag(D.Prefix(), Id, Modified, D.RecordVersion(Id)));
+		}
+
+		//	The request URI carries the paging and filters, so each distinct list gets its own tag.
+		//	The rows in the database make it follow the writes of every instance, the local counter
+		//	those made within the same second as the newest stamp.
+		template <typename DB> inline bool CollectionNotModified(DB &D) {
+			if (NeedAdditionalInfo())
+				return false;
+			std::vector<uint64_t> State;
+			if (!D.CollectionState(State))
+				return false;
+			std::string Persisted;
+			for (const auto Value : State)
+				Persisted += std::to_string(Value) + ":";
+			return NotModified(
+				MakeETag(D.Prefix(), Request->getURI(), Persisted, D.ChangeCounter()));
+		}
+
+		template <typename... Args> inline std::string MakeETag(Args &&...args) const {
+			//	gzip and identity are different representations, so they need different tags
+			auto Hash = Utils::ComputeHash(std::forward<Args>(args)...,
+										   ClientAcceptsCompression() ? "gzip" : "identity");
+			return "\"" + Hash.substr(0, 32) + "\"";
+		}
+
+		static inline bool ETagMatches(const std::string &IfNoneMatch, const std::string &ETag) {
+			Poco::StringTokenizer Candidates(IfNoneMatch, ",",
+											 Poco::StringTokenizer::TOK_TRIM |
+												 Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+			for (const auto &Candidate : Candidates) {
+				//	If-None-Match uses the weak comparison, so a W/ prefix is ignored
+				auto Tag = Candidate.compare(0, 2, "W/") == 0 ? Candidate.substr(2) : Candidate;
+				if (Tag == "*" || Tag == ETag)
+					return true;
+			}
+			return false;
+		}
+
 		inline void ReturnObject(Poco::JSON::Object &Object) {
 			PrepareResponse();
-			if (Request != nullptr) {
-				//   can we compress ???
-				auto AcceptedEncoding = Request->find("Accept-Encoding");
-				if (AcceptedEncoding != Request->end()) {
-					if (AcceptedEncoding->second.find("gzip") != std::string::npos ||
-						AcceptedEncoding->second.find("compress") != std::string::npos) {
-						Response->set("Content-Encoding", "gzip");
-						std::ostream &Answer = Response->send();
-						Poco::DeflatingOutputStream deflater(Answer,
-															 Poco::DeflatingStreamBuf::STREAM_GZIP);
-						Poco::JSON::Stringifier::stringify(Object, deflater);
-						deflater.close();
-						return;
-					}
-				}
+			//   can we compress ???
+			if (ClientAcceptsCompression()) {
+				Response->set("Content-Encoding", "gzip");
+				std::ostream &Answer = Response->send();
+				Poco::DeflatingOutputStream deflater(Answer, Poco::DeflatingStreamBuf::STREAM_GZIP);
+				Poco::JSON::Stringifier::stringify(Object, deflater);
+				deflater.close();
+				return;
 			}
 			std::ostream &Answer = Response->send();
 			Poco::JSON::Stringifier::stringify(Object, Answer);
@@ -576,26 +646,79 @@ namespace OpenWifi {
 
 		inline void ReturnRawJSON(const std::string &json_doc) {
 			PrepareResponse();
-			if (Request != nullptr) {
-				//   can we compress ???
-				auto AcceptedEncoding = Request->find("Accept-Encoding");
-				if (AcceptedEncoding != Request->end()) {
-					if (AcceptedEncoding->second.find("gzip") != std::string::npos ||
-						AcceptedEncoding->second.find("compress") != std::string::npos) {
-						Response->set("Content-Encoding", "gzip");
-						std::ostream &Answer = Response->send();
-						Poco::DeflatingOutputStream deflater(Answer,
-															 Poco::DeflatingStreamBuf::STREAM_GZIP);
-						deflater << json_doc;
-						deflater.close();
-						return;
-					}
-				}
+			//   can we compress ???
+			if (ClientAcceptsCompression()) {
+				Response->set("Content-Encoding", "gzip");
+				std::ostream &Answer = Response->send();
+				Poco::DeflatingOutputStream deflater(Answer, Poco::DeflatingStreamBuf::STREAM_GZIP);
+				deflater << json_doc;
+				deflater.close();
+				return;
 			}
 			std::ostream &Answer = Response->send();
 			Answer << json_doc;
 		}
 
+		/*
+		 *	Writes {"<Name>":[...]} element by element, so a list answer never exists as a whole
+		 *	Poco::JSON tree. Only the element being added is held in memory.
+		 */
+		class JSONListStream {
+		  public:
+			JSONListStream(std::ostream &OS, const char *Name) : OS_(OS) {
+				OS_ << "{";
+				Poco::JSON::Stringifier::formatString(Name, OS_);
+				OS_ << ":[";
+			}
+
+			inline void Add(const Poco::JSON::Object &O) {
+				Separator();
+				Poco::JSON::Stringifier::stringify(O, OS_);
+			}
+
+			inline void Add(const std::string &S) {
+				Separator();
+				Poco::JSON::Stringifier::formatString(S, OS_);
+			}
+
+			//	JSON text that is already serialized, e.g. by a JSONWriter
+			inline void AddRaw(const std::string &JSON) {
+				Separator();
+				OS_ << JSON;
+			}
+
+			inline void Close() { OS_ << "]}"; }
+
+		  private:
+			std::ostream &OS_;
+			bool First_ = true;
+
+			inline void Separator() {
+				if (!First_)
+					OS_ << ",";
+				First_ = false;
+			}
+		};
+
+		//	Produce is called with a JSONListStream and adds the elements of the list.
+		template <typename Producer> void ReturnJSONList(const char *Name, Producer &&Produce) {
+			PrepareResponse();
+			if (ClientAcceptsCompression()) {
+				Response->set("Content-Encoding", "gzip");
+				std::ostream &Answer = Response->send();
+				Poco::DeflatingOutputStream deflater(Answer, Poco::DeflatingStreamBuf::STREAM_GZIP);
+				JSONListStream List(deflater, Name);
+				Produce(List);
+				List.Close();
+				deflater.close();
+				return;
+			}
+			std::ostream &Answer = Response->send();
+			JSONListStream List(Answer, Name);
+			Produce(List);
+			List.Close();
+		}
+
 		inline void ReturnCountOnly(uint64_t Count) {
 			Poco::JSON::Object Answer;
 			Answer.set("count", Count);
@@ -656,6 +779,43 @@ namespace OpenWifi {
 			return RESTAPIHandler::Get(RESTAPI::Protocol::WHEN, Obj);
 		}
 
+		/*
+		 *	Answers from RESTAPI_ResponseCache when an entry built at the same Generation exists,
+		 *	otherwise fills the answer with Producer(Poco::JSON::Object &) and stores it. Generation
+		 *	must be read before the answer is computed, so a concurrent change makes it stale.
+		 */
+		template <typename Producer>
+		inline void ReturnCachedObject(const std::string &Route, uint64_t Generation,
+									   Producer &&P) {
+			auto Key = ResponseCacheKey();
+			std::string Body;
+			if (RESTAPI_ResponseCache()->Get(Route, Key, Generation, Body))
+				return ReturnRawJSON(Body);
+			Poco::JSON::Object Answer;
+			P(Answer);
+			std::ostringstream OS;
+			Poco::JSON::Stringifier::stringify(Answer, OS);
+			Body = OS.str();
+			RESTAPI_ResponseCache()->Put(Route, Key, Generation, Body);
+			ReturnRawJSON(Body);
+		}
+
+		//	user + path + query parameters in a stable order
+		[[nodiscard]] inline std::string ResponseCacheKey() const {
+			auto Parameters = Parameters_;
+			std::sort(Parameters.begin(), Parameters.end());
+			std::string Key = UserInfo_.userinfo.id + "|" + Poco::URI(Request->getURI()).getPath();
+			char Separator = '?';
+			for (const auto &[Name, Value] : Parameters) {
+				Key += Separator;
+				Key += Name;
+				Key += '=';
+				Key += Value;
+				Separator = '&';
+			}
+			return Key;
+		}
+
 		template <typename T> void ReturnObject(const char *Name, const std::vector<T> &Objects) {
 			Poco::JSON::Object Answer;
 			RESTAPI_utils::field_to_json(Answer, Name, Objects);
@@ -830,23 +990,57 @@ namespace OpenWifi {
 	}
 	constexpr auto test_has_PathName_method(...) -> std::false_type { return std::false_type{}; }
 
-	template <typename T, typename... Args>
-	RESTAPIHandler *RESTAPI_Router(const std::string &RequestedPath,
-								   RESTAPIHandler::BindingMap &Bindings, Poco::Logger &Logger,
-								   RESTAPI_GenericServerAccounting &Server,
-								   uint64_t TransactionId) {
-		static_assert(test_has_PathName_method((T *)nullptr),
+	template <typename T>
+	RESTAPIHandler *RESTAPI_MakeHandler(RESTAPIHandler::BindingMap &Bindings, Poco::Logger &Logger,
+										RESTAPI_GenericServerAccounting &Server,
+										uint64_t TransactionId, bool Internal) {
+		return new T(Bindings, Logger, Server, TransactionId, Internal);
+	}
+
+	//	One instance per handler list: the paths are compiled into a trie the first time the list
+	//	is routed, each route maps to the factory of the handler that declared it.
+	template <typename... Args> class RESTAPI_CompiledRouter {
+	  public:
+		static_assert((test_has_PathName_method((Args *)nullptr) && ...),
 					  "Class must have a static PathName() method.");
-		if (RESTAPIHandler::ParseBindings(RequestedPath, T::PathName(), Bindings)) {
-			return new T(Bindings, Logger, Server, TransactionId, false);
+
+		static const RESTAPI_CompiledRouter &instance() {
+			static const RESTAPI_CompiledRouter instance_;
+			return instance_;
 		}
 
-		if constexpr (sizeof...(Args) == 0) {
+		RESTAPIHandler *Route(const std::string &RequestedPath,
+							  RESTAPIHandler::BindingMap &Bindings, Poco::Logger &Logger,
+							  RESTAPI_GenericServerAccounting &Server, uint64_t TransactionId,
+							  bool Internal) const {
+			std::size_t Route;
+			if (Trie_.Find(RequestedPath, Route, Bindings)) {
+				return Factories_[Route](Bindings, Logger, Server, TransactionId, Internal);
+			}
 			return new RESTAPI_UnknownRequestHandler(Bindings, Logger, Server, TransactionId,
-													 false);
-		} else {
-			return RESTAPI_Router<Args...>(RequestedPath, Bindings, Logger, Server, TransactionId);
+													 Internal);
 		}
+
+	  private:
+		using Factory = RESTAPIHandler *(*)(RESTAPIHandler::BindingMap &, Poco::Logger &,
+											RESTAPI_GenericServerAccounting &, uint64_t, bool);
+
+		RESTAPI_RouteTrie Trie_;
+		std::array<Factory, sizeof...(Args)> Factories_{&RESTAPI_MakeHandler<Args>...};
+
+		RESTAPI_CompiledRouter() {
+			std::size_t Route = 0;
+			(Trie_.Add(Args::PathName(), Route++), ...);
+		}
+	};
+
+	template <typename T, typename... Args>
+	RESTAPIHandler *RESTAPI_Router(const std::string &RequestedPath,
+								   RESTAPIHandler::BindingMap &Bindings, Poco::Logger &Logger,
+								   RESTAPI_GenericServerAccounting &Server,
+								   uint64_t TransactionId) {
+		return RESTAPI_CompiledRouter<T, Args...>::instance().Route(RequestedPath, Bindings, Logger,
+																	Server, TransactionId, false);
 	}
 
 	template <typename T, typename... Args>
@@ -854,18 +1048,8 @@ namespace OpenWifi {
 									 RESTAPIHandler::BindingMap &Bindings, Poco::Logger &Logger,
 									 RESTAPI_GenericServerAccounting &Server,
 									 uint64_t TransactionId) {
-		static_assert(test_has_PathName_method((T *)nullptr),
-					  "Class must have a static PathName() method.");
-		if (RESTAPIHandler::ParseBindings(RequestedPath, T::PathName(), Bindings)) {
-			return new T(Bindings, Logger, Server, TransactionId, true);
-		}
-
-		if constexpr (sizeof...(Args) == 0) {
-			return new RESTAPI_UnknownRequestHandler(Bindings, Logger, Server, TransactionId, true);
-		} else {
-			return RESTAPI_Router_I<Args...>(RequestedPath, Bindings, Logger, Server,
-											 TransactionId);
-		}
+		return RESTAPI_CompiledRouter<T, Args...>::instance().Route(RequestedPath, Bindings, Logger,
+																	Server, TransactionId, true);
 	}
 
 } // namespace OpenWifi
@@ -4,64 +4,142 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "framework/MicroServiceFuncs.h"
 #include "framework/SubSystemServer.h"
 
-#include "Poco/ExpireLRUCache.h"
 #include "Poco/Net/HTTPServerRequest.h"
-#include "Poco/URI.h"
 
 #include "fmt/format.h"
 
 namespace OpenWifi {
 
+	/*
+	 * Token buckets for (client address, handler) pairs, kept in a fixed table of atomic slots.
+	 * Each bucket is a single "theoretical arrival time" (GCRA): a call is accepted when it does
+	 * not push that time more than one Period ahead of now, which allows bursts of MaxCalls and
+	 * then MaxCalls per Period. A key probes a small group of slots; an idle slot (its bucket is
+	 * full again) can be taken over by another key, so no cleanup is ever needed. When a whole
+	 * group is busy the call is let through untracked rather than limiting the wrong client.
+	 */
 	class RESTAPI_RateLimiter : public SubSystemServer {
 	  public:
-		struct ClientCacheEntry {
-			int64_t Start = 0;
-			int Count = 0;
-		};
+		static constexpr std::size_t GroupSize = 4;
 
 		static auto instance() {
 			static auto instance_ = new RESTAPI_RateLimiter;
 			return instance_;
 		}
 
-		inline int Start() final { return 0; };
+		inline int Start() final {
+			//	rounded up to a power of two so a slot group is a mask away
+			std::size_t Requested = MicroServiceConfigGetInt("rate.limiter.slots", 262144);
+			SlotCount_ = GroupSize;
+			while (SlotCount_ < Requested)
+				SlotCount_ <<= 1;
+			Slots_ = std::make_unique<Slot[]>(SlotCount_);
+			return 0;
+		};
 		inline void Stop() final{};
 
-		inline bool IsRateLimited(const Poco::Net::HTTPServerRequest &R, int64_t Period,
-								  int64_t MaxCalls) {
-			Poco::URI uri(R.getURI());
-			auto H = str_hash(uri.getPath() + R.clientAddress().host().toString());
-			auto E = Cache_.get(H);
-			auto Now = std::chrono::duration_cast<std::chrono::milliseconds>(
-						   std::chrono::system_clock::now().time_since_epoch())
+		inline bool IsRateLimited(const Poco::Net::HTTPServerRequest &R, std::size_t Route,
+								  int64_t Period, int64_t MaxCalls) {
+			if (Slots_ == nullptr || Period <= 0 || MaxCalls <= 0)
+				return false;
+			Checked_.fetch_add(1, std::memory_order_relaxed);
+
+			const auto &Host = R.clientAddress().host();
+			auto Key = Hash(Host.addr(), Host.length(), Route) | 1; //	0 marks a free slot
+			auto Now = std::chrono::duration_cast<std::chrono::microseconds>(
+						   std::chrono::steady_clock::now().time_since_epoch())
 						   .count();
-			if (E.isNull()) {
-				Cache_.add(H, ClientCacheEntry{.Start = Now, .Count = 1});
+			auto Increment = (uint64_t)(Period * 1000 / MaxCalls);
+			auto Tolerance = (uint64_t)(Period * 1000) - Increment;
+
+			//	the key's own slot first, wherever it is in the group, so that a limited client
+			//	cannot get a fresh bucket by landing on a slot that went idle before its own
+			auto First = (Key * 0x9E3779B97F4A7C15ULL) & (SlotCount_ - 1) & ~(GroupSize - 1);
+			Slot *Owned = nullptr;
+			for (std::size_t i = 0; Owned == nullptr && i < GroupSize; ++i) {
+				if (Slots_[First + i].Key.load(std::memory_order_acquire) == Key)
+					Owned = &Slots_[First + i];
+			}
+			for (std::size_t i = 0; Owned == nullptr && i < GroupSize; ++i) {
+				auto &S = Slots_[First + i];
+				auto Current = S.Key.load(std::memory_order_acquire);
+				if (Current != 0 && S.TAT.load(std::memory_order_relaxed) > (uint64_t)Now)
+					continue;
+				if (S.Key.compare_exchange_strong(Current, Key, std::memory_order_acq_rel) ||
+					Current == Key)
+					Owned = &S;
+			}
+			if (Owned == nullptr) {
+				Untracked_.fetch_add(1, std::memory_order_relaxed);
 				return false;
 			}
-			if ((Now - E->Start) < Period) {
-				E->Count++;
-				Cache_.update(H, E);
-				if (E->Count > MaxCalls) {
-					poco_warning(Logger(), fmt::format("RATE-LIMIT-EXCEEDED: from '{}'",
-													   R.clientAddress().toString()));
-					return true;
-				}
+			if (Admit(*Owned, (uint64_t)Now, Increment, Tolerance))
 				return false;
+			Limited_.fetch_add(1, std::memory_order_relaxed);
+			poco_warning(Logger(), fmt::format("RATE-LIMIT-EXCEEDED: from '{}'",
+											   R.clientAddress().toString()));
+			return true;
+		}
+
+		inline void Clear() {
+			for (std::size_t i = 0; Slots_ != nullptr && i < SlotCount_; ++i) {
+				Slots_[i].Key.store(0, std::memory_order_relaxed);
+				Slots_[i].TAT.store(0, std::memory_order_relaxed);
 			}
-			E->Start = Now;
-			E->Count = 1;
-			Cache_.update(H, E);
-			return false;
 		}
 
-		inline void Clear() { Cache_.clear(); }
+		inline void Stats(Poco::JSON::Object &Answer) final {
+			Answer.set("slots", SlotCount_);
+			Answer.set("checked", Checked_.load());
+			Answer.set("limited", Limited_.load());
+			Answer.set("untracked", Untracked_.load());
+		}
 
 	  private:
-		Poco::ExpireLRUCache<uint64_t, ClientCacheEntry> Cache_{2048};
-		std::hash<std::string> str_hash;
+		struct Slot {
+			std::atomic_uint64_t Key{0};
+			std::atomic_uint64_t TAT{0};
+		};
+
+		std::unique_ptr<Slot[]> Slots_;
+		std::size_t SlotCount_ = 0;
+		std::atomic_uint64_t Checked_{0};
+		std::atomic_uint64_t Limited_{0};
+		std::atomic_uint64_t Untracked_{0};
+
+		static inline bool Admit(Slot &S, uint64_t Now, uint64_t Increment, uint64_t Tolerance) {
+			auto Previous = S.TAT.load(std::memory_order_relaxed);
+			while (true) {
+				auto TAT = std::max(Previous, Now);
+				if (TAT - Now > Tolerance)
+					return false;
+				if (S.TAT.compare_exchange_weak(Previous, TAT + Increment,
+												std::memory_order_relaxed))
+					return true;
+			}
+		}
+
+		//	FNV-1a over the raw address bytes and the route, no temporary strings
+		static inline uint64_t Hash(const void *Data, std::size_t Size, std::size_t Route) {
+			uint64_t H = 14695981039346656037ULL;
+			auto Bytes = static_cast<const unsigned char *>(Data);
+			for (std::size_t i = 0; i < Size; ++i) {
+				H ^= Bytes[i];
+				H *= 1099511628211ULL;
+			}
+			H ^= Route;
+			H *= 1099511628211ULL;
+			return H;
+		}
 
 		RESTAPI_RateLimiter() noexcept
 			: SubSystemServer("RateLimiter", "RATE-LIMITER", "rate.limiter") {}
@@ -69,4 +147,4 @@ namespace OpenWifi {
 
 	inline auto RESTAPI_RateLimiter() { return RESTAPI_RateLimiter::instance(); }
 
-} // namespace OpenWifi
\ No newline at end of file
+} // namespace OpenWifi
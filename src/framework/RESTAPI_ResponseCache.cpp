@@ -0,0 +1,118 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#include "RESTAPI_ResponseCache.h"
+
+#include "framework/KafkaManager.h"
+#include "framework/KafkaTopics.h"
+#include "framework/MicroServiceFuncs.h"
+#include "framework/utils.h"
+
+namespace OpenWifi {
+
+	int RESTAPI_ResponseCache::Start() {
+		poco_information(Logger(), "Starting...");
+		Enabled_ = MicroServiceConfigGetBool("restapi.cache.enabled", true);
+		DefaultTTL_ = MicroServiceConfigGetInt("restapi.cache.ttl", 60);
+		DefaultSize_ = MicroServiceConfigGetInt("restapi.cache.size", 256);
+
+		//	our own changes already move the table counters, only other instances need a flush
+		OwnSystemPrefix_ =
+			R"lit({ "system" : { "id" : )lit" + std::to_string(MicroServiceID()) + " ,";
+		if (Enabled_) {
+			Types::TopicNotifyFunction F = [this](const std::string &Key,
+												  const std::string &Payload) {
+				this->ProvisioningChange(Key, Payload);
+			};
+			WatcherId_ = KafkaManager()->RegisterTopicWatcher(KafkaTopics::PROVISIONING_CHANGE, F);
+		}
+		return 0;
+	}
+
+	void RESTAPI_ResponseCache::Stop() {
+		poco_information(Logger(), "Stopping...");
+		if (Enabled_)
+			KafkaManager()->UnregisterTopicWatcher(KafkaTopics::PROVISIONING_CHANGE, WatcherId_);
+		Clear();
+		poco_information(Logger(), "Stopped...");
+	}
+
+	RESTAPI_ResponseCache::RouteCache &RESTAPI_ResponseCache::GetRoute(const std::string &Route) {
+		auto Hint = Routes_.find(Route);
+		if (Hint != Routes_.end())
+			return Hint->second;
+		auto &R = Routes_[Route];
+		R.TTL = MicroServiceConfigGetInt("restapi.cache." + Route + ".ttl", DefaultTTL_);
+		auto Size = MicroServiceConfigGetInt("restapi.cache." + Route + ".size", DefaultSize_);
+		R.Entries = std::make_unique<Poco::LRUCache<std::string, Entry>>(Size == 0 ? 1 : Size);
+		return R;
+	}
+
+	bool RESTAPI_ResponseCache::Get(const std::string &Route, const std::string &Key,
+									uint64_t Generation, std::string &Body) {
+		if (!Enabled_)
+			return false;
+		std::lock_guard G(Mutex_);
+		auto &R = GetRoute(Route);
+		if (R.TTL == 0)
+			return false;
+		auto E = R.Entries->get(Key);
+		if (E.isNull()) {
+			R.Misses++;
+			return false;
+		}
+		if (E->Generation != Generation || E->Expires < Utils::Now()) {
+			R.Entries->remove(Key);
+			R.Stale++;
+			R.Misses++;
+			return false;
+		}
+		R.Hits++;
+		Body = E->Body;
+		return true;
+	}
+
+	void RESTAPI_ResponseCache::Put(const std::string &Route, const std::string &Key,
+									uint64_t Generation, const std::string &Body) {
+		if (!Enabled_)
+			return;
+		std::lock_guard G(Mutex_);
+		auto &R = GetRoute(Route);
+		if (R.TTL == 0)
+			return;
+		R.Entries->update(Key, Entry{Generation, Utils::Now() + R.TTL, Body});
+	}
+
+	void RESTAPI_ResponseCache::Clear() {
+		std::lock_guard G(Mutex_);
+		for (auto &[_, R] : Routes_)
+			R.Entries->clear();
+		Flushes_++;
+	}
+
+	void RESTAPI_ResponseCache::ProvisioningChange([[maybe_unused]] const std::string &Key,
+												   const std::string &Payload) {
+		if (Payload.compare(0, OwnSystemPrefix_.size(), OwnSystemPrefix_) == 0)
+			return;
+		Clear();
+	}
+
+	void RESTAPI_ResponseCache::Stats(Poco::JSON::Object &Answer) {
+		std::lock_guard G(Mutex_);
+		Answer.set("enabled", Enabled_);
+		Answer.set("flushes", Flushes_);
+		Poco::JSON::Object RoutesObj;
+		for (const auto &[Name, R] : Routes_) {
+			Poco::JSON::Object O;
+			O.set("ttl", R.TTL);
+			O.set("entries", R.Entries->size());
+			O.set("hits", R.Hits);
+			O.set("misses", R.Misses);
+			O.set("stale", R.Stale);
+			RoutesObj.set(Name, O);
+		}
+		Answer.set("routes", RoutesObj);
+	}
+
+} // namespace OpenWifi
@@ -0,0 +1,74 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "Poco/JSON/Object.h"
+#include "Poco/LRUCache.h"
+
+#include "framework/SubSystemServer.h"
+
+namespace OpenWifi {
+
+	/*
+	 * Rendered answers of expensive read endpoints. An entry is stored with the generation of the
+	 * data it was computed from (the sum of the change counters of the tables involved, read
+	 * before computing) and is only served while that generation is current and its TTL has not
+	 * expired. Changes made by other instances arrive as provisioning change events and flush the
+	 * cache. Each route has its own TTL and size, read from restapi.cache.<route>.ttl/.size.
+	 */
+	class RESTAPI_ResponseCache : public SubSystemServer {
+	  public:
+		static auto instance() {
+			static auto instance_ = new RESTAPI_ResponseCache;
+			return instance_;
+		}
+
+		int Start() override;
+		void Stop() override;
+		void Stats(Poco::JSON::Object &Answer) override;
+
+		bool Get(const std::string &Route, const std::string &Key, uint64_t Generation,
+				 std::string &Body);
+		void Put(const std::string &Route, const std::string &Key, uint64_t Generation,
+				 const std::string &Body);
+		void Clear();
+
+	  private:
+		struct Entry {
+			uint64_t Generation = 0;
+			uint64_t Expires = 0;
+			std::string Body;
+		};
+
+		struct RouteCache {
+			uint64_t TTL = 0;
+			std::unique_ptr<Poco::LRUCache<std::string, Entry>> Entries;
+			uint64_t Hits = 0;
+			uint64_t Misses = 0;
+			uint64_t Stale = 0;
+		};
+
+		bool Enabled_ = false;
+		uint64_t DefaultTTL_ = 0;
+		uint64_t DefaultSize_ = 0;
+		std::string OwnSystemPrefix_;
+		uint64_t WatcherId_ = 0;
+		uint64_t Flushes_ = 0;
+		std::map<std::string, RouteCache> Routes_;
+
+		RouteCache &GetRoute(const std::string &Route);
+		void ProvisioningChange(const std::string &Key, const std::string &Payload);
+
+		RESTAPI_ResponseCache() noexcept
+			: SubSystemServer("ResponseCache", "RESPONSE-CACHE", "restapi.cache") {}
+	};
+
+	inline auto RESTAPI_ResponseCache() { return RESTAPI_ResponseCache::instance(); }
+
+} // namespace OpenWifi
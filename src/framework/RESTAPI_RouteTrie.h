@@ -0,0 +1,129 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#pragma once
+
+#include <array>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Poco/String.h"
+
+namespace OpenWifi {
+
+	/*
+	 * Segment trie built once from the PathName() lists of the REST handlers. Literal segments
+	 * are looked up by name, "{param}" segments share a single wildcard child per node. A lookup
+	 * splits the request path in place and walks the trie once; when several endpoints match,
+	 * the one registered first wins, which is the order the old linear router used.
+	 */
+	class RESTAPI_RouteTrie {
+	  public:
+		static constexpr std::size_t MaxSegments = 32;
+
+		inline void Add(const std::list<std::string> &EndPoints, std::size_t Route) {
+			for (const auto &EndPoint : EndPoints)
+				Add(EndPoint, Route);
+		}
+
+		inline bool Add(const std::string &EndPoint, std::size_t Route) {
+			auto Current = &Root_;
+			std::vector<Capture> Captures;
+			std::size_t Segment = 0;
+			for (std::size_t Begin = 0;; ++Segment) {
+				if (Segment == MaxSegments)
+					return false;
+				auto End = EndPoint.find('/', Begin);
+				auto Item = EndPoint.substr(Begin, End == std::string::npos ? End : End - Begin);
+				if (!Item.empty() && Item.front() == '{' && Item.back() == '}') {
+					Captures.push_back(
+						Capture{Segment, Poco::toLower(Item.substr(1, Item.size() - 2))});
+					if (!Current->Param)
+						Current->Param = std::make_unique<Node>();
+					Current = Current->Param.get();
+				} else {
+					auto &Child = Current->Literals[Item];
+					if (!Child)
+						Child = std::make_unique<Node>();
+					Current = Child.get();
+				}
+				if (End == std::string::npos)
+					break;
+				Begin = End + 1;
+			}
+			if (!Current->Leaf) {
+				Current->Leaf = std::make_unique<Terminal>(
+					Terminal{Route, NextOrder_++, std::move(Captures)});
+			}
+			return true;
+		}
+
+		inline bool Find(const std::string &Path, std::size_t &Route,
+						 std::map<std::string, std::string> &Bindings) const {
+			Bindings.clear();
+			std::array<std::string_view, MaxSegments> Segments;
+			std::size_t Count = 0;
+			std::string_view Rest(Path);
+			while (true) {
+				if (Count == MaxSegments)
+					return false;
+				auto End = Rest.find('/');
+				Segments[Count++] = Rest.substr(0, End);
+				if (End == std::string_view::npos)
+					break;
+				Rest.remove_prefix(End + 1);
+			}
+
+			const Terminal *Best = nullptr;
+			Match(&Root_, Segments, Count, 0, Best);
+			if (Best == nullptr)
+				return false;
+			for (const auto &C : Best->Captures)
+				Bindings[C.Name] = std::string(Segments[C.Segment]);
+			Route = Best->Route;
+			return true;
+		}
+
+	  private:
+		struct Capture {
+			std::size_t Segment;
+			std::string Name;
+		};
+
+		struct Terminal {
+			std::size_t Route;
+			std::size_t Order;
+			std::vector<Capture> Captures;
+		};
+
+		struct Node {
+			std::map<std::string, std::unique_ptr<Node>, std::less<>> Literals;
+			std::unique_ptr<Node> Param;
+			std::unique_ptr<Terminal> Leaf;
+		};
+
+		Node Root_;
+		std::size_t NextOrder_ = 0;
+
+		static inline void Match(const Node *Current,
+								 const std::array<std::string_view, MaxSegments> &Segments,
+								 std::size_t Count, std::size_t Index, const Terminal *&Best) {
+			if (Index == Count) {
+				if (Current->Leaf && (Best == nullptr || Current->Leaf->Order < Best->Order))
+					Best = Current->Leaf.get();
+				return;
+			}
+			auto Literal = Current->Literals.find(Segments[Index]);
+			if (Literal != Current->Literals.end())
+				Match(Literal->second.get(), Segments, Count, Index + 1, Best);
+			if (Current->Param)
+				Match(Current->Param.get(), Segments, Count, Index + 1, Best);
+		}
+	};
+
+} // namespace OpenWifi
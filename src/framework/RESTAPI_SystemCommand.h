@@ -124,7 +124,14 @@ namespace OpenWifi {
 					Result.set(RESTAPI::Protocol::LIST, LevelNamesArray);
 					return ReturnObject(Result);
 				} else if (Command == RESTAPI::Protocol::STATS) {
-
+					Poco::JSON::Object Result;
+					for (const auto &SubSystem : MicroServiceGetFullSubSystems()) {
+						Poco::JSON::Object SubSystemStats;
+						SubSystem->Stats(SubSystemStats);
+						if (SubSystemStats.size() > 0)
+							Result.set(SubSystem->Name(), SubSystemStats);
+					}
+					return ReturnObject(Result);
 				} else if (Command == RESTAPI::Protocol::RELOAD) {
 					if (Obj->has(RESTAPI::Protocol::SUBSYSTEMS) &&
 						Obj->isArray(RESTAPI::Protocol::SUBSYSTEMS)) {
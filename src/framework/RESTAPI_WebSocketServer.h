@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "Poco/Net/HTTPServerRequestImpl.h"
 #include "Poco/Net/WebSocket.h"
 #include "framework/RESTAPI_Handler.h"
 
@@ -26,9 +27,13 @@ namespace OpenWifi {
 				if (Request->find("Upgrade") != Request->end() &&
 					Poco::icompare((*Request)["Upgrade"], "websocket") == 0) {
 					try {
+						//	the connection itself, which the websocket takes over
+						Poco::Net::StreamSocket Socket =
+							static_cast<Poco::Net::HTTPServerRequestImpl &>(*Request).socket();
 						Poco::Net::WebSocket WS(*Request, *Response);
 						auto Id = MicroServiceCreateUUID();
-						UI_WebSocketClientServer()->NewClient(WS, Id, UserInfo_.userinfo.email,
+						UI_WebSocketClientServer()->NewClient(WS, Socket, Id,
+															  UserInfo_.userinfo.email,
 															  TransactionId_);
 					} catch (...) {
 						std::cout << "Cannot create websocket client..." << std::endl;
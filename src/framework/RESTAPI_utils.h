@@ -5,12 +5,14 @@
 #pragma once
 
 #include <string>
+#include <type_traits>
 
 #include "Poco/Data/LOB.h"
 #include "Poco/JSON/Object.h"
 #include "Poco/JSON/Parser.h"
 #include "Poco/Net/HTTPServerRequest.h"
 
+#include "framework/JSONWriter.h"
 #include "framework/OpenWifiTypes.h"
 #include "framework/utils.h"
 
@@ -164,6 +166,79 @@ namespace OpenWifi::RESTAPI_utils {
 		Obj.set(Field, Answer);
 	}
 
+	//	Same fields, written directly as text (see JSONWriter)
+	inline void field_to_json(JSONWriter &W, const char *Field, bool V) {
+		W.Key(Field);
+		W.Bool(V);
+	}
+
+	inline void field_to_json(JSONWriter &W, const char *Field, uint64_t V) {
+		W.Key(Field);
+		W.Integer(V);
+	}
+
+	inline void field_to_json(JSONWriter &W, const char *Field, int64_t V) {
+		W.Key(Field);
+		W.Integer(V);
+	}
+
+	inline void field_to_json(JSONWriter &W, const char *Field, double V) {
+		W.Key(Field);
+		W.Double(V);
+	}
+
+	inline void field_to_json(JSONWriter &W, const char *Field, const std::string &S) {
+		W.Key(Field);
+		W.String(S);
+	}
+
+	inline void field_to_json(JSONWriter &W, const char *Field, const Types::StringVec &V) {
+		W.Key(Field);
+		W.BeginArray();
+		for (const auto &i : V) {
+			W.Element();
+			W.String(i);
+		}
+		W.EndArray();
+	}
+
+	inline void field_to_json(JSONWriter &W, const char *Field, const Types::TagList &V) {
+		W.Key(Field);
+		W.BeginArray();
+		for (const auto &i : V) {
+			W.Element();
+			W.Integer(i);
+		}
+		W.EndArray();
+	}
+
+	template <class T>
+	void field_to_json(JSONWriter &W, const char *Field, const std::vector<T> &Value) {
+		W.Key(Field);
+		W.BeginArray();
+		for (const auto &i : Value) {
+			W.Element();
+			W.BeginObject();
+			i.to_json(W);
+			W.EndObject();
+		}
+		W.EndArray();
+	}
+
+	template <class T> void field_to_json(JSONWriter &W, const char *Field, const T &Value) {
+		W.Key(Field);
+		W.BeginObject();
+		Value.to_json(W);
+		W.EndObject();
+	}
+
+	//	True when T has a to_json(JSONWriter &) member, i.e. can skip the Poco::JSON::Object step
+	template <typename T, typename = void> struct has_json_writer : std::false_type {};
+	template <typename T>
+	struct has_json_writer<
+		T, std::void_t<decltype(std::declval<const T &>().to_json(std::declval<JSONWriter &>()))>>
+		: std::true_type {};
+
 	///////////////////////////
 	///////////////////////////
 	///////////////////////////
@@ -7,6 +7,7 @@
 #include <mutex>
 #include <string>
 
+#include "Poco/JSON/Object.h"
 #include "Poco/Net/Context.h"
 #include "Poco/Net/PrivateKeyPassphraseHandler.h"
 #include "Poco/Net/SecureServerSocket.h"
@@ -98,6 +99,7 @@ namespace OpenWifi {
 
 		virtual int Start() = 0;
 		virtual void Stop() = 0;
+		virtual void Stats([[maybe_unused]] Poco::JSON::Object &Answer) {}
 
 		struct LoggerWrapper {
 			Poco::Logger &L_;
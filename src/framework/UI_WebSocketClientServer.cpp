@@ -2,12 +2,14 @@
 // Created by stephane bourque on 2022-10-25.
 //
 
+#include <algorithm>
 #include <mutex>
 
 #include "Poco/JSON/JSONException.h"
 #include "Poco/JSON/Parser.h"
 #include "Poco/Logger.h"
 #include "Poco/NObserver.h"
+#include "Poco/NumberFormatter.h"
 
 #include "framework/AuthClient.h"
 #include "framework/MicroServiceFuncs.h"
@@ -24,11 +26,13 @@
 
 namespace OpenWifi {
 
-	void UI_WebSocketClientServer::NewClient(Poco::Net::WebSocket &WS, const std::string &Id,
-											 const std::string &UserName, std::uint64_t TID) {
+	void UI_WebSocketClientServer::NewClient(Poco::Net::WebSocket &WS,
+											 const Poco::Net::StreamSocket &Socket,
+											 const std::string &Id, const std::string &UserName,
+											 std::uint64_t TID) {
 
 		std::lock_guard G(LocalMutex_);
-		auto Client = std::make_unique<UI_WebSocketClientInfo>(WS, Id, UserName);
+		auto Client = std::make_unique<UI_WebSocketClientInfo>(WS, Socket, Id, UserName);
 		auto ClientSocket = Client->WS_->impl()->sockfd();
 		TID_ = TID;
 		Client->WS_->setNoDelay(true);
@@ -74,8 +78,13 @@ namespace OpenWifi {
 	}
 
 	void UI_WebSocketClientServer::EndConnection(ClientList::iterator Client) {
+		//	may be reached twice (eviction, then a socket error): the iterator must be queued once
 		if (Client->second->SocketRegistered_) {
 			Client->second->SocketRegistered_ = false;
+			SetWritable(*Client->second, false);
+			Client->second->Queue_.clear();
+			Client->second->Out_.clear();
+			Client->second->OutOffset_ = Client->second->Pending_ = 0;
 			Reactor_.removeEventHandler(
 				*Client->second->WS_,
 				Poco::NObserver<UI_WebSocketClientServer, Poco::Net::ReadableNotification>(
@@ -88,14 +97,17 @@ namespace OpenWifi {
 				*Client->second->WS_,
 				Poco::NObserver<UI_WebSocketClientServer, Poco::Net::ErrorNotification>(
 					*this, &UI_WebSocketClientServer::OnSocketError));
+			ToBeRemoved_.push_back(Client);
+			UpdateListening();
 		}
-		ToBeRemoved_.push_back(Client);
 	}
 
 	int UI_WebSocketClientServer::Start() {
 		poco_information(Logger(), "Starting...");
 		GoogleApiKey_ = MicroServiceConfigGetString("google.apikey", "");
 		GeoCodeEnabled_ = !GoogleApiKey_.empty();
+		MaxPending_ = std::max<std::size_t>(
+			MicroServiceConfigGetInt("websocketclients.queue.bytes", MaxPending_), 1);
 		ReactorThread_.start(Reactor_);
 		ReactorThread_.setName("ws:ui-reactor");
 		CleanerThread_.start(*this);
@@ -116,25 +128,30 @@ namespace OpenWifi {
 		}
 	};
 
-	bool UI_WebSocketClientServer::IsFiltered(std::uint64_t id,
-											  const OpenWifi::UI_WebSocketClientInfo &Client) {
-		return std::find(Client.Filter_.begin(), Client.Filter_.end(), id) != end(Client.Filter_);
+	//	called with LocalMutex_ held, whenever a session authenticates, changes its filter or ends
+	void UI_WebSocketClientServer::UpdateListening() {
+		UI_NotificationFilter Listening;
+		bool Anyone = false;
+		for (const auto &[_, Client] : Clients_) {
+			if (Client->Authenticated_ && Client->SocketRegistered_) {
+				Listening |= ~Client->Filter_;
+				Anyone = true;
+			}
+		}
+		Listening_.store(Listening.to_ullong(), std::memory_order_relaxed);
+		AnyoneListening_.store(Anyone, std::memory_order_relaxed);
 	}
 
 	bool UI_WebSocketClientServer::SendToUser(const std::string &UserName, std::uint64_t id,
 											  const std::string &Payload) {
+		auto Index = TypeIndex(id);
 		std::lock_guard G(LocalMutex_);
 
-		for (const auto &Client : Clients_) {
-			if (Client.second->UserName_ == UserName) {
-				try {
-					if (!IsFiltered(id, *Client.second) && Client.second->Authenticated_) {
-						return Client.second->WS_->sendFrame(
-								   Payload.c_str(), (int)Payload.size()) == (int)Payload.size();
-					} else {
-						return false;
-					}
-				} catch (...) {
+		for (auto Client = Clients_.begin(); Client != Clients_.end(); ++Client) {
+			if (Client->second->UserName_ == UserName) {
+				if (!IsFiltered(Index, *Client->second) && Client->second->Authenticated_) {
+					return Enqueue(Client, std::make_shared<const std::string>(Payload));
+				} else {
 					return false;
 				}
 			}
@@ -142,18 +159,163 @@ namespace OpenWifi {
 		return false;
 	}
 
-	void UI_WebSocketClientServer::SendToAll(std::uint64_t id, const std::string &Payload) {
+	void UI_WebSocketClientServer::SendToAll(std::uint64_t id, std::string Payload) {
+		//	one copy of the frame, shared by every queue
+		auto Frame = std::make_shared<const std::string>(std::move(Payload));
+		auto Index = TypeIndex(id);
 		std::lock_guard G(LocalMutex_);
 
-		for (const auto &Client : Clients_) {
+		for (auto Client = Clients_.begin(); Client != Clients_.end(); ++Client) {
+			if (!IsFiltered(Index, *Client->second) && Client->second->Authenticated_)
+				Enqueue(Client, Frame);
+		}
+	}
+
+	//	A server frame is not masked: the flags byte, the payload length, then the payload.
+	static void EncodeFrame(const std::string &Payload, int Flags, std::string &Out) {
+		auto Size = Payload.size();
+		Out.clear();
+		Out.reserve(Size + 10);
+		Out += (char)(Flags & 0xff);
+		if (Size < 126) {
+			Out += (char)Size;
+		} else if (Size <= 0xffff) {
+			Out += (char)126;
+			Out += (char)(Size >> 8);
+			Out += (char)(Size & 0xff);
+		} else {
+			Out += (char)127;
+			for (int i = 7; i >= 0; --i)
+				Out += (char)((Size >> (8 * i)) & 0xff);
+		}
+		Out += Payload;
+	}
+
+	bool UI_WebSocketClientServer::Enqueue(ClientList::iterator Client,
+										   const UI_WebSocketClientInfo::Frame &Payload,
+										   int Flags) {
+		auto &C = *Client->second;
+		if (!C.SocketRegistered_ || C.Closing_)
+			return false;
+		//	more than the cap waiting to be written: the client is not reading
+		if (C.Pending_ > 0 && C.Pending_ + Payload->size() > MaxPending_) {
+			poco_warning(Logger(), fmt::format("EVICT({}): {} UI Client is not reading, {} bytes "
+											   "pending.",
+											   C.Id_, C.UserName_, C.Pending_));
+			Dropped_ += C.Queue_.size() + 1;
+			Evicted_++;
+			EndConnection(Client);
+			return false;
+		}
+		C.Queue_.push_back(UI_WebSocketClientInfo::Outbound{Payload, Flags});
+		C.Pending_ += Payload->size();
+		Queued_++;
+		SetWritable(C, true);
+		return true;
+	}
+
+	//	the last frame of a session: nothing is read or queued after it, and the connection is
+	//	ended once it is written
+	void UI_WebSocketClientServer::CloseAfter(ClientList::iterator Client, std::string Payload) {
+		auto &C = *Client->second;
+		if (!Enqueue(Client, std::make_shared<const std::string>(std::move(Payload))))
+			return EndConnection(Client);
+		C.Closing_ = true;
+		Reactor_.removeEventHandler(
+			*C.WS_, Poco::NObserver<UI_WebSocketClientServer, Poco::Net::ReadableNotification>(
+						*this, &UI_WebSocketClientServer::OnSocketReadable));
+	}
+
+	//	Writes frames without blocking the reactor. Each frame is encoded into the client's buffer
+	//	and written to the connection; a partial write keeps its offset and the rest goes out on the
+	//	next writable event. The buffer is not touched until it is fully written, as TLS requires
+	//	of a retried write. A would-block is not an error; anything thrown is, and ends the session.
+	void UI_WebSocketClientServer::Flush(ClientList::iterator Client) {
+		constexpr std::size_t MaxFramesPerEvent = 32;
+		auto &C = *Client->second;
+		std::size_t Count = 0;
+		while (Count < MaxFramesPerEvent) {
+			if (C.OutOffset_ == C.Out_.size()) {
+				if (C.Queue_.empty())
+					break;
+				const auto &Next = C.Queue_.front();
+				EncodeFrame(*Next.Payload, Next.Flags, C.Out_);
+				C.Pending_ = C.Pending_ - Next.Payload->size() + C.Out_.size();
+				C.OutOffset_ = 0;
+				C.Queue_.pop_front();
+			}
+			int n = 0;
 			try {
-				if (!IsFiltered(id, *Client.second) && Client.second->Authenticated_)
-					Client.second->WS_->sendFrame(Payload.c_str(), (int)Payload.size());
-			} catch (...) {
+				n = C.Socket_.sendBytes(C.Out_.data() + C.OutOffset_,
+										(int)(C.Out_.size() - C.OutOffset_));
+			} catch (const Poco::TimeoutException &) {
 			}
+			if (n <= 0)
+				break;
+			C.OutOffset_ += n;
+			C.Pending_ -= n;
+			if (C.OutOffset_ < C.Out_.size())
+				break;
+			C.Out_.clear();
+			C.OutOffset_ = 0;
+			Count++;
+		}
+		Sent_ += Count;
+		if (C.Queue_.empty() && C.Out_.empty()) {
+			SetWritable(C, false);
+			if (C.Closing_)
+				EndConnection(Client);
 		}
 	}
 
+	void UI_WebSocketClientServer::SetWritable(UI_WebSocketClientInfo &Client, bool Writable) {
+		if (Client.WritableRegistered_ == Writable)
+			return;
+		Poco::NObserver<UI_WebSocketClientServer, Poco::Net::WritableNotification> Observer(
+			*this, &UI_WebSocketClientServer::OnSocketWritable);
+		if (Writable)
+			Reactor_.addEventHandler(*Client.WS_, Observer);
+		else
+			Reactor_.removeEventHandler(*Client.WS_, Observer);
+		Client.WritableRegistered_ = Writable;
+	}
+
+	void UI_WebSocketClientServer::OnSocketWritable(
+		const Poco::AutoPtr<Poco::Net::WritableNotification> &pNf) {
+		std::lock_guard G(LocalMutex_);
+		auto Client = Clients_.find(pNf->socket().impl()->sockfd());
+		if (Client == end(Clients_))
+			return;
+		try {
+			Flush(Client);
+		} catch (const Poco::Exception &E) {
+			poco_debug(Logger(), fmt::format("CLOSE({}): {} UI Client write failed: {}",
+											  Client->second->Id_, Client->second->UserName_,
+											  E.displayText()));
+			EndConnection(Client);
+		} catch (...) {
+			EndConnection(Client);
+		}
+	}
+
+	void UI_WebSocketClientServer::Stats(Poco::JSON::Object &Answer) {
+		std::lock_guard G(LocalMutex_);
+		std::size_t Pending = 0, PendingBytes = 0;
+		for (const auto &[_, Client] : Clients_) {
+			Pending += Client->Queue_.size();
+			PendingBytes += Client->Pending_;
+		}
+		Answer.set("clients", Clients_.size());
+		Answer.set("pending", Pending);
+		Answer.set("pendingBytes", PendingBytes);
+		Answer.set("queued", Queued_);
+		Answer.set("sent", Sent_);
+		Answer.set("dropped", Dropped_);
+		Answer.set("evicted", Evicted_);
+		Answer.set("notificationTypes", TypeCount_.load());
+		Answer.set("listening", Poco::NumberFormatter::formatHex(Listening_.load(), 16));
+	}
+
 	UI_WebSocketClientServer::ClientList::iterator UI_WebSocketClientServer::FindWSClient(
 		[[maybe_unused]] std::lock_guard<std::recursive_mutex> &G, int ClientSocket) {
 		return Clients_.find(ClientSocket);
@@ -180,9 +342,25 @@ namespace OpenWifi {
 
 	void UI_WebSocketClientServer::RegisterNotifications(
 		const OpenWifi::UI_WebSocketClientServer::NotificationTypeIdVec &Notifications) {
+		std::lock_guard G(LocalMutex_);
 		std::copy(Notifications.begin(), Notifications.end(),
 				  std::back_inserter(NotificationTypes_));
 		SortNotifications();
+
+		//	indexes are given in registration order and never change, so filters stay valid
+		for (const auto &Notification : Notifications) {
+			if (TypeIndex(Notification.id) != UI_MaxNotificationTypes)
+				continue;
+			auto Count = TypeCount_.load(std::memory_order_relaxed);
+			if (Count == UI_MaxNotificationTypes) {
+				poco_warning(Logger(), fmt::format("Notification type {} cannot be filtered: more "
+												   "than {} types registered.",
+												   Notification.id, UI_MaxNotificationTypes));
+				continue;
+			}
+			TypeIds_[Count].store(Notification.id, std::memory_order_relaxed);
+			TypeCount_.store(Count + 1, std::memory_order_release);
+		}
 	}
 
 	void UI_WebSocketClientServer::OnSocketError(
@@ -221,9 +399,10 @@ namespace OpenWifi {
 
 			switch (Op) {
 			case Poco::Net::WebSocket::FRAME_OP_PING: {
-				Client->second->WS_->sendFrame("", 0,
-											   (int)Poco::Net::WebSocket::FRAME_OP_PONG |
-												   (int)Poco::Net::WebSocket::FRAME_FLAG_FIN);
+				static const auto Pong = std::make_shared<const std::string>();
+				Enqueue(Client, Pong,
+						(int)Poco::Net::WebSocket::FRAME_OP_PONG |
+							(int)Poco::Net::WebSocket::FRAME_FLAG_FIN);
 			} break;
 			case Poco::Net::WebSocket::FRAME_OP_PONG: {
 			} break;
@@ -260,15 +439,15 @@ namespace OpenWifi {
 						WelcomeMessage.set("success", "Welcome! Bienvenue! Bienvenidos!");
 						std::ostringstream OS;
 						WelcomeMessage.stringify(OS);
-						Client->second->WS_->sendFrame(OS.str().c_str(), (int)OS.str().size());
+						Enqueue(Client, std::make_shared<const std::string>(OS.str()));
 						Client->second->UserName_ = Client->second->UserInfo_.userinfo.email;
+						UpdateListening();
 					} else {
 						Poco::JSON::Object WelcomeMessage;
 						WelcomeMessage.set("error", "Invalid token. Closing connection.");
 						std::ostringstream OS;
 						WelcomeMessage.stringify(OS);
-						Client->second->WS_->sendFrame(OS.str().c_str(), (int)OS.str().size());
-						return EndConnection(Client);
+						return CloseAfter(Client, OS.str());
 					}
 				} else {
 					Poco::JSON::Parser P;
@@ -276,11 +455,14 @@ namespace OpenWifi {
 
 					if (Obj->has(DropMessagesCommand) && Obj->isArray(DropMessagesCommand)) {
 						auto Filters = Obj->getArray(DropMessagesCommand);
-						Client->second->Filter_.clear();
+						Client->second->Filter_.reset();
 						for (const auto &Filter : *Filters) {
-							Client->second->Filter_.emplace_back((std::uint64_t)Filter);
+							//	types nobody registered are never sent, nothing to drop
+							auto Index = TypeIndex((std::uint64_t)Filter);
+							if (Index != UI_MaxNotificationTypes)
+								Client->second->Filter_.set(Index);
 						}
-						std::sort(begin(Client->second->Filter_), end(Client->second->Filter_));
+						UpdateListening();
 						return;
 					}
 
@@ -290,15 +472,11 @@ namespace OpenWifi {
 						Processor_->Processor(Obj, Answer, CloseConnection,
 											  Client->second->UserInfo_.userinfo);
 					}
-					if (!Answer.empty())
-						Client->second->WS_->sendFrame(Answer.c_str(), (int)Answer.size());
-					else {
-						Client->second->WS_->sendFrame("{}", 2);
-					}
-
-					if (CloseConnection) {
-						return EndConnection(Client);
-					}
+					if (Answer.empty())
+						Answer = "{}";
+					if (CloseConnection)
+						return CloseAfter(Client, std::move(Answer));
+					Enqueue(Client, std::make_shared<const std::string>(std::move(Answer)));
 				}
 			} break;
 			default: {
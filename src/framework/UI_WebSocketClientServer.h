@@ -4,12 +4,18 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <deque>
 #include <map>
+#include <memory>
 #include <string>
 
 #include "Poco/JSON/Object.h"
 #include "Poco/Net/SocketNotification.h"
 #include "Poco/Net/SocketReactor.h"
+#include "Poco/Net/StreamSocket.h"
 #include "Poco/Net/WebSocket.h"
 #include "Poco/Runnable.h"
 
@@ -27,17 +33,41 @@ namespace OpenWifi {
 	  private:
 	};
 
+	//	one bit per registered notification type, by the dense index given at registration
+	constexpr std::size_t UI_MaxNotificationTypes = 64;
+	using UI_NotificationFilter = std::bitset<UI_MaxNotificationTypes>;
+
 	struct UI_WebSocketClientInfo {
+		using Frame = std::shared_ptr<const std::string>;
+		struct Outbound {
+			Frame Payload;
+			int Flags = Poco::Net::WebSocket::FRAME_TEXT;
+		};
+
 		std::unique_ptr<Poco::Net::WebSocket> WS_ = nullptr;
+		//	the connection under the websocket, TLS included: frames are written to it directly so
+		//	that a partial write can be resumed
+		Poco::Net::StreamSocket Socket_;
 		std::string Id_;
 		std::string UserName_;
 		bool Authenticated_ = false;
 		bool SocketRegistered_ = false;
-		std::vector<std::uint64_t> Filter_;
+		UI_NotificationFilter Filter_; //	set bits are dropped
 		SecurityObjects::UserInfoAndPolicy UserInfo_;
-
-		UI_WebSocketClientInfo(Poco::Net::WebSocket &WS, const std::string &Id,
-							   const std::string &username) {
+		//	outbound frames, written by the reactor thread when the socket is writable
+		std::deque<Outbound> Queue_;
+		//	the frame being written, header included, and how much of it is already written
+		std::string Out_;
+		std::size_t OutOffset_ = 0;
+		//	bytes queued or not yet written
+		std::size_t Pending_ = 0;
+		bool WritableRegistered_ = false;
+		//	closed once everything queued is written
+		bool Closing_ = false;
+
+		UI_WebSocketClientInfo(Poco::Net::WebSocket &WS, const Poco::Net::StreamSocket &Socket,
+							   const std::string &Id, const std::string &username)
+			: Socket_(Socket) {
 			WS_ = std::make_unique<Poco::Net::WebSocket>(WS);
 			Id_ = Id;
 			UserName_ = username;
@@ -58,8 +88,8 @@ namespace OpenWifi {
 		void Stop() override;
 		void run() override;
 		Poco::Net::SocketReactor &Reactor() { return Reactor_; }
-		void NewClient(Poco::Net::WebSocket &WS, const std::string &Id, const std::string &UserName,
-					   std::uint64_t TID);
+		void NewClient(Poco::Net::WebSocket &WS, const Poco::Net::StreamSocket &Socket,
+					   const std::string &Id, const std::string &UserName, std::uint64_t TID);
 		void SetProcessor(UI_WebSocketClientProcessor *F);
 		[[nodiscard]] inline bool GeoCodeEnabled() const { return GeoCodeEnabled_; }
 		[[nodiscard]] inline std::string GoogleApiKey() const { return GoogleApiKey_; }
@@ -67,6 +97,8 @@ namespace OpenWifi {
 		template <typename T>
 		bool SendUserNotification(const std::string &userName,
 								  const WebSocketNotification<T> &Notification) {
+			if (!IsListening(Notification.type_id))
+				return false;
 
 			Poco::JSON::Object Payload;
 			Notification.to_json(Payload);
@@ -78,7 +110,11 @@ namespace OpenWifi {
 			return SendToUser(userName, Notification.type_id, OO.str());
 		}
 
+		//	serialized once for all sessions, and not at all when no session takes this type
 		template <typename T> void SendNotification(const WebSocketNotification<T> &Notification) {
+			if (!IsListening(Notification.type_id))
+				return;
+
 			Poco::JSON::Object Payload;
 			Notification.to_json(Payload);
 			Poco::JSON::Object Msg;
@@ -90,7 +126,8 @@ namespace OpenWifi {
 
 		[[nodiscard]] bool SendToUser(const std::string &userName, std::uint64_t id,
 									  const std::string &Payload);
-		void SendToAll(std::uint64_t id, const std::string &Payload);
+		void SendToAll(std::uint64_t id, std::string Payload);
+		void Stats(Poco::JSON::Object &Answer) override;
 
 		struct NotificationEntry {
 			std::uint64_t id = 0;
@@ -101,7 +138,28 @@ namespace OpenWifi {
 		using NotificationTypeIdVec = std::vector<NotificationEntry>;
 
 		void RegisterNotifications(const NotificationTypeIdVec &Notifications);
-		bool IsFiltered(std::uint64_t id, const UI_WebSocketClientInfo &Client);
+
+		//	Lock free: true when at least one authenticated session does not drop this type
+		[[nodiscard]] inline bool IsListening(std::uint64_t id) const {
+			auto Index = TypeIndex(id);
+			if (Index == UI_MaxNotificationTypes)
+				return AnyoneListening_;
+			return (Listening_.load(std::memory_order_relaxed) >> Index) & 1;
+		}
+
+		//	Dense index of a registered type id, UI_MaxNotificationTypes when not registered
+		[[nodiscard]] inline std::size_t TypeIndex(std::uint64_t id) const {
+			auto Count = TypeCount_.load(std::memory_order_acquire);
+			for (std::size_t i = 0; i < Count; ++i)
+				if (TypeIds_[i].load(std::memory_order_relaxed) == id)
+					return i;
+			return UI_MaxNotificationTypes;
+		}
+
+		[[nodiscard]] static inline bool IsFiltered(std::size_t Index,
+												   const UI_WebSocketClientInfo &Client) {
+			return Index < UI_MaxNotificationTypes && Client.Filter_.test(Index);
+		}
 
 	  private:
 		volatile bool Running_ = false;
@@ -118,11 +176,29 @@ namespace OpenWifi {
 		Poco::JSON::Object NotificationTypesJSON_;
 		std::vector<ClientList::iterator> ToBeRemoved_;
 		std::uint64_t TID_ = 0;
+		std::array<std::atomic_uint64_t, UI_MaxNotificationTypes> TypeIds_{};
+		std::atomic_size_t TypeCount_{0};
+		std::atomic_uint64_t Listening_{0};
+		std::atomic_bool AnyoneListening_{false};
+		std::size_t MaxPending_ = 4 * 1024 * 1024;
+		std::uint64_t Queued_ = 0;
+		std::uint64_t Sent_ = 0;
+		std::uint64_t Dropped_ = 0;
+		std::uint64_t Evicted_ = 0;
 
 		UI_WebSocketClientServer() noexcept;
 		void EndConnection(ClientList::iterator Client);
 
+		//	LocalMutex_ must be held
+		bool Enqueue(ClientList::iterator Client, const UI_WebSocketClientInfo::Frame &Payload,
+					 int Flags = Poco::Net::WebSocket::FRAME_TEXT);
+		void CloseAfter(ClientList::iterator Client, std::string Payload);
+		void Flush(ClientList::iterator Client);
+		void SetWritable(UI_WebSocketClientInfo &Client, bool Writable);
+		void UpdateListening();
+
 		void OnSocketReadable(const Poco::AutoPtr<Poco::Net::ReadableNotification> &pNf);
+		void OnSocketWritable(const Poco::AutoPtr<Poco::Net::WritableNotification> &pNf);
 		void OnSocketShutdown(const Poco::AutoPtr<Poco::Net::ShutdownNotification> &pNf);
 		void OnSocketError(const Poco::AutoPtr<Poco::Net::ErrorNotification> &pNf);
 
@@ -4,24 +4,69 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Poco/Event.h"
+#include "Poco/Runnable.h"
+#include "Poco/Thread.h"
+
+#include "framework/MicroServiceFuncs.h"
 #include "framework/SubSystemServer.h"
 #include "framework/UI_WebSocketClientNotifications.h"
 #include "framework/UI_WebSocketClientServer.h"
 
 namespace OpenWifi {
 
-	class WebSocketLogger : public Poco::Channel {
+	/*
+	 * Log messages are not sent from the thread that logs them: they are pushed in a bounded
+	 * lock-free ring and a background thread ships them in batches, one websocket frame per batch,
+	 * every logging.websocket.flush ms or as soon as a batch is full. When the ring is more than
+	 * half full, a source logging more than logging.websocket.source.rate messages per second only
+	 * has one message in SampleEvery kept, warnings and worse excepted. What does not fit is
+	 * dropped and the count is reported in the next frame.
+	 */
+	class WebSocketLogger : public Poco::Channel, public Poco::Runnable {
 	  public:
-		WebSocketLogger() {}
+		static constexpr std::uint64_t LogNotificationType = 1;
+		static constexpr std::size_t SourceBuckets = 256;
+		static constexpr std::uint64_t SampleEvery = 16;
 
-		~WebSocketLogger() {}
+		WebSocketLogger() {
+			//	rounded up to a power of two so a position is a mask away from its cell
+			std::size_t Requested = MicroServiceConfigGetInt("logging.websocket.buffer", 4096);
+			while (Capacity_ < Requested)
+				Capacity_ <<= 1;
+			BatchSize_ = std::max<std::size_t>(
+				MicroServiceConfigGetInt("logging.websocket.batch", 64), 1);
+			FlushInterval_ = std::max<long>(
+				MicroServiceConfigGetInt("logging.websocket.flush", 250), 10);
+			SourceRate_ = MicroServiceConfigGetInt("logging.websocket.source.rate", 50);
+			Ring_ = std::make_unique<Cell[]>(Capacity_);
+			for (std::size_t i = 0; i < Capacity_; ++i)
+				Ring_[i].Sequence.store(i, std::memory_order_relaxed);
+			Running_ = true;
+			Worker_.start(*this);
+			Worker_.setName("ws:logger");
+		}
+
+		~WebSocketLogger() { close(); }
 
 		std::string getProperty([[maybe_unused]] const std::string &p) const {
 			std::cout << "WS getProperty" << std::endl;
 			return "";
 		}
 
-		void close() final {}
+		void close() final {
+			if (Running_.exchange(false)) {
+				Wake_.set();
+				Worker_.join();
+			}
+		}
 
 		void open() final {}
 
@@ -80,21 +125,48 @@ namespace OpenWifi {
 			}
 		};
 
-		typedef WebSocketNotification<NotificationLogMessage>
-			WebSocketClientNotificationLogMessage_t;
+		struct NotificationLogMessages {
+			std::vector<NotificationLogMessage> messages;
+			std::uint64_t dropped = 0;
+
+			inline void to_json(Poco::JSON::Object &Obj) const {
+				RESTAPI_utils::field_to_json(Obj, "messages", messages);
+				RESTAPI_utils::field_to_json(Obj, "dropped", dropped);
+			}
+		};
+
+		typedef WebSocketNotification<NotificationLogMessages>
+			WebSocketClientNotificationLogMessages_t;
 
+		//	Called on the logging thread: never blocks, never serializes
 		void log(const Poco::Message &m) final {
-			if (UI_WebSocketClientServer()->IsAnyoneConnected()) {
-				WebSocketClientNotificationLogMessage_t Msg;
-				Msg.content.msg = m.getText();
-				Msg.content.level = WebSocketLogger::to_string(m.getPriority());
-				Msg.content.timestamp = m.getTime().epochTime();
-				Msg.content.source = m.getSource();
-				Msg.content.thread_name = m.getThread();
-				Msg.content.thread_id = m.getTid();
-				Msg.type_id = 1;
-				UI_WebSocketClientServer()->SendNotification(Msg);
+			if (!Running_ || !UI_WebSocketClientServer()->IsListening(LogNotificationType))
+				return;
+			if (!Admit(m)) {
+				Lost_.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			NotificationLogMessage E;
+			E.msg = m.getText();
+			E.level = WebSocketLogger::to_string(m.getPriority());
+			E.timestamp = m.getTime().epochTime();
+			E.source = m.getSource();
+			E.thread_name = m.getThread();
+			E.thread_id = m.getTid();
+			if (!Push(E)) {
+				Lost_.fetch_add(1, std::memory_order_relaxed);
+				return;
 			}
+			if (Depth() >= BatchSize_)
+				Wake_.set();
+		}
+
+		void run() final {
+			while (Running_) {
+				Wake_.tryWait(FlushInterval_);
+				Drain();
+			}
+			Drain();
 		}
 
 		void setProperty([[maybe_unused]] const std::string &name,
@@ -103,7 +175,100 @@ namespace OpenWifi {
 		}
 
 	  private:
-		std::recursive_mutex Mutex_;
+		struct Cell {
+			std::atomic_size_t Sequence{0};
+			NotificationLogMessage Message;
+		};
+
+		struct SourceBucket {
+			std::atomic_uint64_t Second{0};
+			std::atomic_uint64_t Count{0};
+		};
+
+		std::unique_ptr<Cell[]> Ring_;
+		std::size_t Capacity_ = 2;
+		std::atomic_size_t Head_{0};
+		std::atomic_size_t Tail_{0};
+		std::size_t BatchSize_ = 64;
+		long FlushInterval_ = 250;
+		std::uint64_t SourceRate_ = 50;
+		std::array<SourceBucket, SourceBuckets> Sources_{};
+		std::atomic_uint64_t Lost_{0};
+		std::atomic_bool Running_{false};
+		Poco::Event Wake_;
+		Poco::Thread Worker_;
+
+		[[nodiscard]] inline std::size_t Depth() const {
+			return Head_.load(std::memory_order_relaxed) - Tail_.load(std::memory_order_relaxed);
+		}
+
+		//	per source sampling, only once the ring is under pressure
+		inline bool Admit(const Poco::Message &m) {
+			if (SourceRate_ == 0 || m.getPriority() <= Poco::Message::PRIO_WARNING)
+				return true;
+			auto &B = Sources_[std::hash<std::string>{}(m.getSource()) % SourceBuckets];
+			auto Now = (std::uint64_t)m.getTime().epochTime();
+			auto Second = B.Second.load(std::memory_order_relaxed);
+			if (Second != Now && B.Second.compare_exchange_strong(Second, Now,
+																   std::memory_order_relaxed))
+				B.Count.store(0, std::memory_order_relaxed);
+			auto Count = B.Count.fetch_add(1, std::memory_order_relaxed) + 1;
+			if (Count <= SourceRate_ || Depth() < Capacity_ / 2)
+				return true;
+			return (Count % SampleEvery) == 0;
+		}
+
+		//	bounded multi-producer ring: a cell is free for position P when its sequence is P
+		inline bool Push(NotificationLogMessage &E) {
+			auto Pos = Head_.load(std::memory_order_relaxed);
+			while (true) {
+				auto &C = Ring_[Pos & (Capacity_ - 1)];
+				auto Sequence = C.Sequence.load(std::memory_order_acquire);
+				auto Diff = (std::intptr_t)Sequence - (std::intptr_t)Pos;
+				if (Diff == 0) {
+					if (Head_.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed)) {
+						C.Message = std::move(E);
+						C.Sequence.store(Pos + 1, std::memory_order_release);
+						return true;
+					}
+				} else if (Diff < 0) {
+					return false;
+				} else {
+					Pos = Head_.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		//	single consumer: only the worker thread pops
+		inline bool Pop(NotificationLogMessage &E) {
+			auto Pos = Tail_.load(std::memory_order_relaxed);
+			auto &C = Ring_[Pos & (Capacity_ - 1)];
+			if (C.Sequence.load(std::memory_order_acquire) != Pos + 1)
+				return false;
+			E = std::move(C.Message);
+			C.Sequence.store(Pos + Capacity_, std::memory_order_release);
+			Tail_.store(Pos + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		inline void Drain() {
+			while (true) {
+				WebSocketClientNotificationLogMessages_t Msg;
+				Msg.type_id = LogNotificationType;
+				NotificationLogMessage E;
+				while (Msg.content.messages.size() < BatchSize_ && Pop(E))
+					Msg.content.messages.push_back(std::move(E));
+				Msg.content.dropped = Lost_.exchange(0, std::memory_order_relaxed);
+				if (Msg.content.messages.empty() && Msg.content.dropped == 0)
+					return;
+				try {
+					UI_WebSocketClientServer()->SendNotification(Msg);
+				} catch (...) {
+				}
+				if (Msg.content.messages.size() < BatchSize_)
+					return;
+			}
+		}
 	};
 
 	//	inline auto WebSocketLogger() { return WebSocketLogger::instance(); }
@@ -8,12 +8,20 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include "Poco/Data/RecordSet.h"
@@ -203,6 +211,104 @@ namespace ORM {
 		uint64_t Timeout_ = 0;
 	};
 
+	/*
+	 * A unit of work. While one is open on a thread, every table using its pool runs on the same
+	 * session and inside the same transaction, so a request touching several tables takes one
+	 * session and one commit instead of one of each per statement. A unit opened inside another
+	 * on the same pool joins it. Any failing statement on its pool aborts the unit: Commit() then
+	 * rolls everything back and returns false, as does destroying a unit that was not committed.
+	 * Work passed to OnCommit (caches, in-memory indexes) only runs once the changes made on that
+	 * pool are durable, and is dropped on a rollback.
+	 */
+	class UnitOfWork {
+	  public:
+		explicit UnitOfWork(Poco::Data::SessionPool &Pool)
+			: Pool_(Pool), Outer_(Current_), Joined_(Find(Pool)) {
+			if (Joined_ == nullptr) {
+				Session_ = std::make_unique<Poco::Data::Session>(Pool.get());
+				Session_->begin();
+			}
+			Current_ = this;
+		}
+
+		UnitOfWork(const UnitOfWork &) = delete;
+		UnitOfWork &operator=(const UnitOfWork &) = delete;
+
+		~UnitOfWork() {
+			Current_ = Outer_;
+			if (Joined_ == nullptr && !Done_)
+				Rollback();
+		}
+
+		bool Commit() {
+			if (Joined_ != nullptr)
+				return !Joined_->Failed_;
+			if (Done_)
+				return false;
+			if (Failed_)
+				return Rollback();
+			try {
+				Session_->commit();
+				Done_ = true;
+			} catch (const Poco::Exception &) {
+				Failed_ = true;
+				return Rollback();
+			}
+			for (auto &F : Committed_)
+				F();
+			Committed_.clear();
+			return true;
+		}
+
+		//	the session of the unit open on this thread for Pool, or a new one
+		static Poco::Data::Session SessionFor(Poco::Data::SessionPool &Pool) {
+			auto U = Find(Pool);
+			return U == nullptr ? Pool.get() : *U->Session_;
+		}
+
+		static void OnCommit(Poco::Data::SessionPool &Pool, std::function<void()> F) {
+			auto U = Find(Pool);
+			if (U == nullptr)
+				F();
+			else
+				U->Committed_.push_back(std::move(F));
+		}
+
+		static void Abort(Poco::Data::SessionPool &Pool) {
+			if (auto U = Find(Pool); U != nullptr)
+				U->Failed_ = true;
+		}
+
+	  private:
+		Poco::Data::SessionPool &Pool_;
+		UnitOfWork *Outer_ = nullptr;
+		UnitOfWork *Joined_ = nullptr;
+		std::unique_ptr<Poco::Data::Session> Session_;
+		std::vector<std::function<void()>> Committed_;
+		bool Failed_ = false;
+		bool Done_ = false;
+		inline static thread_local UnitOfWork *Current_ = nullptr;
+
+		static UnitOfWork *Find(Poco::Data::SessionPool &Pool) {
+			for (auto U = Current_; U != nullptr; U = U->Outer_) {
+				if (&U->Pool_ == &Pool)
+					return U->Joined_ ? U->Joined_ : U;
+			}
+			return nullptr;
+		}
+
+		bool Rollback() {
+			Done_ = true;
+			Committed_.clear();
+			try {
+				if (Session_->isTransaction())
+					Session_->rollback();
+			} catch (const Poco::Exception &) {
+			}
+			return false;
+		}
+	};
+
 	template <typename RecordTuple, typename RecordType> class DB {
 	  public:
 		typedef const char *field_name_t;
@@ -346,7 +452,7 @@ namespace ORM {
 			switch (Type_) {
 			case OpenWifi::DBType::mysql: {
 				try {
-					Poco::Data::Session Session = Pool_.get();
+					Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 					std::string Statement = IndexCreation_.empty()
 												? "create table if not exists " + TableName_ +
 													  " ( " + CreateFields_ + " )"
@@ -356,13 +462,13 @@ namespace ORM {
 					Session << Statement, Poco::Data::Keywords::now;
 				} catch (const Poco::Exception &E) {
 					Logger_.error("Failure to create MySQL DB resources.");
-					Logger_.log(E);
+					Failed(E);
 				}
 			} break;
 
 			case OpenWifi::DBType::sqlite: {
 				try {
-					Poco::Data::Session Session = Pool_.get();
+					Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 					std::string Statement =
 						"create table if not exists " + TableName_ + " ( " + CreateFields_ + " )";
 					Session << Statement, Poco::Data::Keywords::now;
@@ -371,13 +477,13 @@ namespace ORM {
 					}
 				} catch (const Poco::Exception &E) {
 					Logger_.error("Failure to create SQLITE DB resources.");
-					Logger_.log(E);
+					Failed(E);
 				}
 			} break;
 
 			case OpenWifi::DBType::pgsql: {
 				try {
-					Poco::Data::Session Session = Pool_.get();
+					Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 					std::string Statement =
 						"create table if not exists " + TableName_ + " ( " + CreateFields_ + " )";
 					Session << Statement, Poco::Data::Keywords::now;
@@ -386,7 +492,7 @@ namespace ORM {
 					}
 				} catch (const Poco::Exception &E) {
 					Logger_.error("Failure to create POSTGRESQL DB resources.");
-					Logger_.log(E);
+					Failed(E);
 				}
 			} break;
 			}
@@ -417,9 +523,24 @@ namespace ORM {
 
 		inline const std::string &Prefix() { return Prefix_; };
 
+		/*
+		 * Change tracking for HTTP validators. Every write through this class bumps the table
+		 * counter; writes keyed by "id" also stamp that record, anything else (other keys, where
+		 * clauses, scripts) moves the table epoch so every record version changes. The counter is
+		 * seeded from the clock, so values from before a restart are never reused. It only sees the
+		 * writes of this instance: list validators also use CollectionState.
+		 */
+		[[nodiscard]] inline uint64_t ChangeCounter() const { return ChangeCounter_; }
+
+		[[nodiscard]] inline uint64_t RecordVersion(const std::string &Id) const {
+			std::lock_guard G(VersionsMutex_);
+			auto Hint = Versions_.find(Id);
+			return Hint == Versions_.end() ? Epoch_ : std::max(Hint->second, Epoch_);
+		}
+
 		bool CreateRecord(const RecordType &R) {
 			try {
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 				Poco::Data::Statement Insert(Session);
 
 				RecordTuple RT;
@@ -428,13 +549,15 @@ namespace ORM {
 								 " ) values " + SelectList_;
 				Insert << ConvertParams(St), Poco::Data::Keywords::use(RT);
 				Insert.execute();
+				++ChangeCounter_;
 
 				if (Cache_)
-					Cache_->Create(R);
+					UnitOfWork::OnCommit(Pool_, [this, R]() { Cache_->Create(R); });
+				Created(R);
 				return true;
 
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
 			}
 			return false;
 		}
@@ -449,7 +572,7 @@ namespace ORM {
 						return true;
 				}
 
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 				Poco::Data::Statement Select(Session);
 				RecordTuple RT;
 
@@ -464,19 +587,20 @@ namespace ORM {
 
 				if (Select.execute() == 1) {
 					Convert(RT, R);
+					Complete(&R, 1);
 					if (Cache_)
-						Cache_->UpdateCache(R);
+						UnitOfWork::OnCommit(Pool_, [this, R]() { Cache_->UpdateCache(R); });
 					return true;
 				}
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
 			}
 			return false;
 		}
 
 		bool GetRecord(RecordType &T, const std::string &WhereClause) {
 			try {
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 				Poco::Data::Statement Select(Session);
 				RecordTuple RT;
 
@@ -488,12 +612,13 @@ namespace ORM {
 
 				if (Select.execute() == 1) {
 					Convert(RT, T);
+					Complete(&T, 1);
 					if (Cache_)
-						Cache_->UpdateCache(T);
+						UnitOfWork::OnCommit(Pool_, [this, T]() { Cache_->UpdateCache(T); });
 					return true;
 				}
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
 			}
 			return false;
 		}
@@ -506,7 +631,7 @@ namespace ORM {
 
 				assert(ValidFieldName(FieldName));
 
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 				Poco::Data::Statement Select(Session);
 				RecordTuple RT;
 
@@ -521,21 +646,21 @@ namespace ORM {
 				}
 				return true;
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
 			}
 			return false;
 		}
 
 		template <typename T> bool Join(const std::string &statement, std::vector<T> &records) {
 			try {
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 				Poco::Data::Statement Select(Session);
 
 				Select << statement, Poco::Data::Keywords::into(records);
 				Select.execute();
 				return true;
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
 			}
 			return false;
 		}
@@ -545,9 +670,10 @@ namespace ORM {
 		typedef RecordType RecordName;
 
 		bool GetRecords(uint64_t Offset, uint64_t HowMany, RecordVec &Records,
-						const std::string &Where = "", const std::string &OrderBy = "") {
+						const std::string &Where = "", const std::string &OrderBy = "",
+						bool WithRelations = true) {
 			try {
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 				Poco::Data::Statement Select(Session);
 				RecordList RL;
 				std::string St = "select " + SelectFields_ + " from " + TableName_ +
@@ -558,16 +684,131 @@ namespace ORM {
 				Select.execute();
 
 				if (Select.rowsExtracted() > 0) {
+					auto First = Records.size();
 					for (auto &i : RL) {
 						RecordType R;
 						Convert(i, R);
 						Records.template emplace_back(R);
 					}
+					if (WithRelations)
+						Complete(Records.data() + First, Records.size() - First);
 					return true;
 				}
 				return false;
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
+			}
+			return false;
+		}
+
+		bool GetRecordsIn(field_name_t FieldName, const std::vector<std::string> &Values,
+						  RecordVec &Records) {
+			assert(ValidFieldName(FieldName));
+			if (Values.empty())
+				return false;
+			std::string Where{FieldName};
+			Where += " in (";
+			bool first = true;
+			for (const auto &Value : Values) {
+				if (!first)
+					Where += ",";
+				first = false;
+				Where += "'" + Escape(Value) + "'";
+			}
+			Where += ")";
+			return GetRecords(0, Values.size(), Records, Where);
+		}
+
+		bool CreateRecords(const RecordVec &Records) {
+			if (Records.empty())
+				return true;
+			try {
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
+				//	inside a unit of work the statements join its transaction
+				bool Own = !Session.isTransaction();
+				try {
+					if (Own)
+						Session.begin();
+					RecordList RL;
+					RL.reserve(Records.size());
+					for (const auto &R : Records) {
+						RecordTuple RT;
+						Convert(R, RT);
+						RL.emplace_back(std::move(RT));
+					}
+					Poco::Data::Statement Insert(Session);
+					std::string St = "insert into  " + TableName_ + " ( " + SelectFields_ +
+									 " ) values " + SelectList_;
+					Insert << ConvertParams(St), Poco::Data::Keywords::use(RL);
+					Insert.execute();
+					if (Own)
+						Session.commit();
+				} catch (...) {
+					if (Own && Session.isTransaction())
+						Session.rollback();
+					throw;
+				}
+				++ChangeCounter_;
+				if (Cache_) {
+					UnitOfWork::OnCommit(Pool_, [this, Records]() {
+						for (const auto &R : Records)
+							Cache_->Create(R);
+					});
+				}
+				for (const auto &R : Records)
+					Created(R);
+				return true;
+			} catch (const Poco::Exception &E) {
+				Failed(E);
+			}
+			return false;
+		}
+
+		template <typename T>
+		bool UpdateRecords(field_name_t FieldName,
+						   const std::vector<std::pair<T, RecordType>> &Updates) {
+			if (Updates.empty())
+				return true;
+			try {
+				assert(ValidFieldName(FieldName));
+
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
+				std::string St = ConvertParams("update " + TableName_ + " set " + UpdateFields_ +
+											   " where " + FieldName + "=?");
+				//	inside a unit of work the statements join its transaction
+				bool Own = !Session.isTransaction();
+				try {
+					if (Own)
+						Session.begin();
+					for (const auto &[Value, R] : Updates) {
+						Poco::Data::Statement Update(Session);
+						RecordTuple RT;
+						Convert(R, RT);
+						auto tValue{Value};
+						Update << St, Poco::Data::Keywords::use(RT),
+							Poco::Data::Keywords::use(tValue);
+						Update.execute();
+					}
+					if (Own)
+						Session.commit();
+				} catch (...) {
+					if (Own && Session.isTransaction())
+						Session.rollback();
+					throw;
+				}
+				for (const auto &Update : Updates)
+					RecordChanged(FieldName, Update.first);
+				if (Cache_) {
+					UnitOfWork::OnCommit(Pool_, [this, Updates]() {
+						for (const auto &Update : Updates)
+							Cache_->UpdateCache(Update.second);
+					});
+				}
+				for (const auto &Update : Updates)
+					Updated(Update.second);
+				return true;
+			} catch (const Poco::Exception &E) {
+				Failed(E);
 			}
 			return false;
 		}
@@ -577,7 +818,7 @@ namespace ORM {
 			try {
 				assert(ValidFieldName(FieldName));
 
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 				Poco::Data::Statement Update(Session);
 
 				RecordTuple RT;
@@ -591,26 +832,30 @@ namespace ORM {
 				Update << ConvertParams(St), Poco::Data::Keywords::use(RT),
 					Poco::Data::Keywords::use(tValue);
 				Update.execute();
+				RecordChanged(FieldName, Value);
 				if (Cache_)
-					Cache_->UpdateCache(R);
+					UnitOfWork::OnCommit(Pool_, [this, R]() { Cache_->UpdateCache(R); });
+				Updated(R);
 				return true;
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
 			}
 			return false;
 		}
 
 		bool RunStatement(const std::string &St) {
 			try {
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 				Poco::Data::Statement Command(Session);
 
 				Command << St;
 				Command.execute();
+				TableChanged();
+				TableRewritten();
 
 				return true;
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
 			}
 			return false;
 		}
@@ -623,7 +868,7 @@ namespace ORM {
 				}
 				return CreateRecord(R);
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
 			}
 			return false;
 		}
@@ -633,7 +878,7 @@ namespace ORM {
 								   std::string &Description) {
 			try {
 				assert(ValidFieldName(FieldName));
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 				Poco::Data::Statement Select(Session);
 				RecordTuple RT;
 
@@ -652,7 +897,7 @@ namespace ORM {
 				}
 				return false;
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
 			}
 			return false;
 		}
@@ -661,7 +906,7 @@ namespace ORM {
 			try {
 				assert(ValidFieldName(FieldName));
 
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 				Poco::Data::Statement Delete(Session);
 
 				std::string St = "delete from " + TableName_ + " where " + FieldName + "=?";
@@ -669,11 +914,23 @@ namespace ORM {
 
 				Delete << ConvertParams(St), Poco::Data::Keywords::use(tValue);
 				Delete.execute();
-				if (Cache_)
-					Cache_->Delete(FieldName, Value);
+				RecordDeleted(FieldName, Value);
+				if (Cache_) {
+					UnitOfWork::OnCommit(Pool_, [this, Field = std::string{FieldName},
+												 Key = std::string{Value}]() {
+						Cache_->Delete(Field, Key);
+					});
+				}
+				if constexpr (std::is_convertible_v<const T &, std::string>) {
+					if (std::strcmp(FieldName, "id") == 0) {
+						Removed(Value);
+						return true;
+					}
+				}
+				TableRewritten();
 				return true;
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
 			}
 			return false;
 		}
@@ -681,15 +938,17 @@ namespace ORM {
 		bool DeleteRecords(const std::string &WhereClause) {
 			try {
 				assert(!WhereClause.empty());
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 				Poco::Data::Statement Delete(Session);
 
 				std::string St = "delete from " + TableName_ + " where " + WhereClause;
 				Delete << St;
 				Delete.execute();
+				TableChanged();
+				TableRewritten();
 				return true;
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
 			}
 			return false;
 		}
@@ -703,21 +962,23 @@ namespace ORM {
 					return true;
 				return false;
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
 			}
 			return false;
 		}
 
+		//	Records come without the lists kept outside the table unless WithRelations is set:
+		//	scans rarely need them and filling them is a query per batch.
 		bool Iterate(std::function<bool(const RecordType &R)> F,
-					 const std::string &WhereClause = "") {
+					 const std::string &WhereClause = "", uint64_t Batch = 50,
+					 bool WithRelations = false) {
 			try {
 
 				uint64_t Offset = 0;
-				uint64_t Batch = 50;
 				bool Done = false;
 				while (!Done) {
 					std::vector<RecordType> Records;
-					if (GetRecords(Offset, Batch, Records, WhereClause)) {
+					if (GetRecords(Offset, Batch, Records, WhereClause, "", WithRelations)) {
 						for (const auto &i : Records) {
 							if (!F(i))
 								return true;
@@ -731,7 +992,23 @@ namespace ORM {
 				}
 				return true;
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
+			}
+			return false;
+		}
+
+		//	one column of every row, without converting whole records
+		bool GetFieldValues(field_name_t FieldName, std::vector<std::string> &Values) {
+			try {
+				assert(ValidFieldName(FieldName));
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
+				Poco::Data::Statement Select(Session);
+				Select << "select " + std::string{FieldName} + " from " + TableName_,
+					Poco::Data::Keywords::into(Values);
+				Select.execute();
+				return true;
+			} catch (const Poco::Exception &E) {
+				Failed(E);
 			}
 			return false;
 		}
@@ -767,7 +1044,7 @@ namespace ORM {
 			try {
 				uint64_t Cnt = 0;
 
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 				Poco::Data::Statement Select(Session);
 
 				std::string st{"SELECT COUNT(*) FROM " + TableName_ + " " +
@@ -779,7 +1056,7 @@ namespace ORM {
 				return Cnt;
 
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
 			}
 			return 0;
 		}
@@ -790,6 +1067,12 @@ namespace ORM {
 			try {
 				assert(ValidFieldName(FieldName));
 
+				if constexpr (std::is_same_v<X, std::vector<std::string> RecordType::*>) {
+					bool Changed = false;
+					if (ManipulateRelation(T, FieldName, ParentUUID, ChildUUID, Add, Changed))
+						return Changed;
+				}
+
 				RecordType R;
 				if (GetRecord(FieldName, ParentUUID, R)) {
 					auto it = std::find((R.*T).begin(), (R.*T).end(), ChildUUID);
@@ -808,14 +1091,14 @@ namespace ORM {
 					return true;
 				}
 			} catch (const Poco::Exception &E) {
-				Logger_.log(E);
+				Failed(E);
 			}
 			return false;
 		}
 
 		bool RunScript(const std::vector<std::string> &Statements, bool IgnoreExceptions = true) {
 			try {
-				Poco::Data::Session Session = Pool_.get();
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
 				Poco::Data::Statement Command(Session);
 
 				for (const auto &i : Statements) {
@@ -832,6 +1115,33 @@ namespace ORM {
 					}
 					Command.reset(Session);
 				}
+				TableChanged();
+				return true;
+			} catch (const Poco::Exception &E) {
+				Failed(E);
+			}
+			return false;
+		}
+
+		/*
+		 * What the rows of the table look like in the database, shared by every instance: the
+		 * number of rows and the newest modification stamp. Tables that keep lists elsewhere add
+		 * the state of those. Validators for lists are built from this, so that a write made by
+		 * another instance changes them too.
+		 */
+		virtual bool CollectionState(std::vector<uint64_t> &State) {
+			try {
+				uint64_t Rows = 0, Newest = 0;
+				Poco::Data::Session Session = UnitOfWork::SessionFor(Pool_);
+				Poco::Data::Statement Select(Session);
+				std::string St{"SELECT COUNT(*), " +
+							   std::string{ValidFieldName("modified") ? "COALESCE(MAX(modified),0)"
+																	  : "0"} +
+							   " FROM " + TableName_};
+				Select << St, Poco::Data::Keywords::into(Rows), Poco::Data::Keywords::into(Newest);
+				Select.execute();
+				State.push_back(Rows);
+				State.push_back(Newest);
 				return true;
 			} catch (const Poco::Exception &E) {
 				Logger_.log(E);
@@ -839,8 +1149,37 @@ namespace ORM {
 			return false;
 		}
 
+		//	a change made outside of this class that shows in the record, e.g. in its member lists
+		inline void ExternalChange(const std::string &Id) { RecordChanged("id", Id); }
+
 		virtual uint32_t Version() { return 0; }
 
+		/*
+		 * Tables that keep some of their lists in a relation table instead of the record override
+		 * these. ManipulateRelation returns false for the lists stored in the record; Complete
+		 * fills the lists of records just read.
+		 */
+		virtual bool ManipulateRelation([[maybe_unused]] std::vector<std::string> RecordType::*List,
+										[[maybe_unused]] field_name_t FieldName,
+										[[maybe_unused]] const std::string &ParentUUID,
+										[[maybe_unused]] const std::string &ChildUUID,
+										[[maybe_unused]] bool Add, [[maybe_unused]] bool &Changed) {
+			return false;
+		}
+		virtual void Complete([[maybe_unused]] RecordType *Records,
+							  [[maybe_unused]] std::size_t Count) {}
+
+		/*
+		 * Called by every write path once its statement succeeded, within the caller's unit of
+		 * work if there is one, so that tables keep their relations and indexes in step whichever
+		 * method did the write. Removed gets the id of a deleted record; TableRewritten follows
+		 * deletions and statements whose records are not known.
+		 */
+		virtual void Created([[maybe_unused]] const RecordType &R) {}
+		virtual void Updated([[maybe_unused]] const RecordType &R) {}
+		virtual void Removed([[maybe_unused]] const std::string &Id) {}
+		virtual void TableRewritten() {}
+
 		virtual bool Upgrade(uint32_t from, uint32_t &to) {
 			to = from;
 			return true;
@@ -961,6 +1300,21 @@ namespace ORM {
 										  true);
 		}
 
+		//	many children of the same parent: one read and at most one write
+		inline bool AddInUse(field_name_t FieldName, const std::string &ParentUUID,
+							 const std::string &Prefix,
+							 const std::vector<std::string> &ChildUUIDs) {
+			RecordType R;
+			if (!GetRecord(FieldName, ParentUUID, R))
+				return false;
+			auto Before = R.inUse.size();
+			for (const auto &Child : ChildUUIDs)
+				R.inUse.push_back(Prefix + ":" + Child);
+			std::sort(R.inUse.begin(), R.inUse.end());
+			R.inUse.erase(std::unique(R.inUse.begin(), R.inUse.end()), R.inUse.end());
+			return R.inUse.size() == Before || UpdateRecord(FieldName, ParentUUID, R);
+		}
+
 		inline bool DeleteInUse(field_name_t FieldName, const std::string &ParentUUID,
 								const std::string &Prefix, const std::string &ChildUUID) {
 			std::string FakeUUID{Prefix + ":" + ChildUUID};
@@ -1008,8 +1362,11 @@ namespace ORM {
 		Poco::Logger &Logger() { return Logger_; }
 
 		inline bool DeleteRecordsFromCache(const char *FieldName, const std::string &Value) {
-			if (Cache_)
-				Cache_->Delete(FieldName, Value);
+			if (Cache_) {
+				UnitOfWork::OnCommit(Pool_, [this, Field = std::string{FieldName}, Value]() {
+					Cache_->Delete(Field, Value);
+				});
+			}
 			return true;
 		}
 
@@ -1026,7 +1383,53 @@ namespace ORM {
 		std::string Prefix_;
 		DBCache<RecordType> *Cache_ = nullptr;
 
+		inline void Failed(const Poco::Exception &E) {
+			UnitOfWork::Abort(Pool_);
+			Logger_.log(E);
+		}
+
+		inline void TableChanged() {
+			std::lock_guard G(VersionsMutex_);
+			Epoch_ = ++ChangeCounter_;
+		}
+
+		template <typename T> inline void RecordChanged(field_name_t FieldName, const T &Value) {
+			if constexpr (std::is_convertible_v<const T &, std::string>) {
+				if (std::strcmp(FieldName, "id") == 0) {
+					std::lock_guard G(VersionsMutex_);
+					//	Past the limit every stamp is folded into a new epoch: versions only
+					//	move forward, so this costs revalidations, never a stale answer.
+					if (Versions_.size() >= MaxVersions) {
+						Versions_.clear();
+						Epoch_ = ++ChangeCounter_;
+					}
+					Versions_[Value] = ++ChangeCounter_;
+					return;
+				}
+			}
+			TableChanged();
+		}
+
+		//	A deleted record keeps no stamp. The epoch moves instead, so a record later created
+		//	with the same id can never match a version handed out before the delete.
+		template <typename T> inline void RecordDeleted(field_name_t FieldName, const T &Value) {
+			std::lock_guard G(VersionsMutex_);
+			if constexpr (std::is_convertible_v<const T &, std::string>) {
+				if (std::strcmp(FieldName, "id") == 0)
+					Versions_.erase(Value);
+			}
+			Epoch_ = ++ChangeCounter_;
+		}
+
 	  private:
+		static constexpr std::size_t MaxVersions = 100000;
+		std::atomic_uint64_t ChangeCounter_{
+			(uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::system_clock::now().time_since_epoch())
+				.count()};
+		uint64_t Epoch_ = ChangeCounter_;
+		mutable std::mutex VersionsMutex_;
+		std::unordered_map<std::string, uint64_t> Versions_;
 		std::string CreateFields_;
 		std::string SelectFields_;
 		std::string SelectList_;
@@ -54,12 +54,9 @@ namespace OpenWifi {
 									 Poco::Logger &L)
 		: DB(T, "configurations", ConfigurationDB_Fields, ConfigurationDB_Indexes, P, L, "cfg") {}
 
-	static bool AddIfAffected(const std::string &UUID, const std::vector<std::string> &DeviceTypes,
+	static bool AddIfAffected(const ProvObjects::InventoryTag &T,
+							  const std::vector<std::string> &DeviceTypes,
 							  std::set<std::string> &Devices) {
-		ProvObjects::InventoryTag T;
-		if (!StorageService()->InventoryDB().GetRecord("id", UUID, T))
-			return false;
-
 		for (const auto &i : DeviceTypes) {
 			if (i == "*" || i == T.deviceType) {
 				Devices.insert(T.serialNumber);
@@ -69,33 +66,14 @@ namespace OpenWifi {
 		return false;
 	}
 
-	static bool AddDevicesFromVenue(const std::string &UUID,
-									const std::vector<std::string> &DeviceTypes,
-									std::set<std::string> &Devices) {
-		ProvObjects::Venue V;
-		if (!StorageService()->VenueDB().GetRecord("id", UUID, V))
-			return false;
-		for (const auto &j : V.devices) {
-			AddIfAffected(j, DeviceTypes, Devices);
-		}
-		for (const auto &j : V.children)
-			AddDevicesFromVenue(j, DeviceTypes, Devices);
-		return true;
-	}
-
-	static bool AddDevicesFromEntity(const std::string &UUID,
-									 const std::vector<std::string> &DeviceTypes,
-									 std::set<std::string> &Devices) {
-		ProvObjects::Entity E;
-		if (!StorageService()->EntityDB().GetRecord("id", UUID, E))
+	//	every device in the subtree of an entity or a venue, in one query
+	static bool AddDevicesUnder(const std::string &UUID, const std::vector<std::string> &DeviceTypes,
+								std::set<std::string> &Devices) {
+		InventoryDB::RecordVec Records;
+		if (!StorageService()->InventoryDB().GetDevicesUnder(UUID, Records))
 			return false;
-		for (const auto &j : E.devices) {
-			AddIfAffected(j, DeviceTypes, Devices);
-		}
-		for (const auto &j : E.children)
-			AddDevicesFromEntity(j, DeviceTypes, Devices);
-		for (const auto &j : E.venues)
-			AddDevicesFromVenue(j, DeviceTypes, Devices);
+		for (const auto &T : Records)
+			AddIfAffected(T, DeviceTypes, Devices);
 		return true;
 	}
 
@@ -117,10 +95,8 @@ namespace OpenWifi {
 			auto Tokens = Poco::StringTokenizer(i, ":");
 			if (Tokens.count() != 2)
 				continue;
-			if (Tokens[0] == "ent") {
-				AddDevicesFromEntity(Tokens[1], DeviceTypes, SerialNumbers);
-			} else if (Tokens[0] == "ven") {
-				AddDevicesFromVenue(Tokens[1], DeviceTypes, SerialNumbers);
+			if (Tokens[0] == "ent" || Tokens[0] == "ven") {
+				AddDevicesUnder(Tokens[1], DeviceTypes, SerialNumbers);
 			} else if (Tokens[0] == "inv") {
 				ProvObjects::InventoryTag T;
 				if (!StorageService()->InventoryDB().GetRecord("id", Tokens[1], T))
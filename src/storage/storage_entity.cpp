@@ -9,7 +9,6 @@
 #include "storage_entity.h"
 #include "RESTObjects/RESTAPI_SecurityObjects.h"
 #include "StorageService.h"
-#include "framework/CIDR.h"
 #include "framework/MicroServiceFuncs.h"
 #include "framework/OpenWifiTypes.h"
 #include "framework/RESTAPI_utils.h"
@@ -48,6 +47,19 @@ namespace OpenWifi {
 	EntityDB::EntityDB(OpenWifi::DBType T, Poco::Data::SessionPool &P, Poco::Logger &L)
 		: DB(T, "entities", EntityDB_Fields, EntityDB_Indexes, P, L, "ent") {}
 
+	//	lists kept in the memberships table rather than in the record
+	static const MemberLists<ProvObjects::Entity> EntityLists{
+		{"children", &ProvObjects::Entity::children},
+		{"contacts", &ProvObjects::Entity::contacts},
+		{"locations", &ProvObjects::Entity::locations},
+		{"venues", &ProvObjects::Entity::venues},
+		{"devices", &ProvObjects::Entity::devices},
+		{"variables", &ProvObjects::Entity::variables},
+		{"managementPolicies", &ProvObjects::Entity::managementPolicies},
+		{"managementRoles", &ProvObjects::Entity::managementRoles},
+		{"maps", &ProvObjects::Entity::maps},
+		{"configurations", &ProvObjects::Entity::configurations}};
+
 	bool EntityDB::Upgrade([[maybe_unused]] uint32_t from, uint32_t &to) {
 		to = Version();
 		std::vector<std::string> Script{
@@ -65,69 +77,105 @@ namespace OpenWifi {
 			} catch (...) {
 			}
 		}
+
+		std::vector<std::string> Columns;
+		for (const auto &List : EntityLists)
+			Columns.push_back(List.first);
+		StorageService()->MembershipDB().Migrate(TableName_, Columns);
+		return true;
+	}
+
+	bool EntityDB::ManipulateRelation(Types::UUIDvec_t ProvObjects::Entity::*List,
+									  field_name_t FieldName, const std::string &ParentUUID,
+									  const std::string &ChildUUID, bool Add, bool &Changed) {
+		auto Kind = MembershipDB::Kind(EntityLists, List);
+		if (Kind == nullptr)
+			return false;
+		std::string Owner;
+		Changed = MembershipDB::ResolveOwner(*this, FieldName, ParentUUID, Add, Owner) &&
+				  StorageService()->MembershipDB().Update(Owner, *Kind, ChildUUID, Add);
+		if (Changed)
+			RecordChanged("id", Owner);
+		return true;
+	}
+
+	void EntityDB::Complete(ProvObjects::Entity *Records, std::size_t Count) {
+		StorageService()->MembershipDB().Fill(EntityLists, Records, Count);
+	}
+
+	//	the lists shown with the records live in the memberships table
+	bool EntityDB::CollectionState(std::vector<uint64_t> &State) {
+		return DB::CollectionState(State) &&
+			   StorageService()->MembershipDB().CollectionState(State);
+	}
+
+	bool EntityDB::AddMembers(Types::UUIDvec_t ProvObjects::Entity::*List,
+							  const std::map<std::string, Types::UUIDvec_t> &Members) {
+		if (!StorageService()->MembershipDB().AddToList(EntityLists, List, Members))
+			return false;
+		for (const auto &[Owner, _] : Members)
+			RecordChanged("id", Owner);
 		return true;
 	}
 
+	void EntityDB::AddLists(const ProvObjects::Entity &R) {
+		StorageService()->MembershipDB().AddLists(EntityLists, R);
+	}
+
+	void EntityDB::RemoveLists(const std::string &Id) {
+		StorageService()->MembershipDB().RemoveOwner(Id);
+	}
+
+	bool EntityDB::GetHierarchyRecords(std::vector<EntityHierarchyRecord> &Records,
+									   const std::string &Id) {
+		try {
+			Poco::Data::Session Session = Pool_.get();
+			Poco::Data::Statement Select(Session);
+			std::string St = "select id, name, parent, deviceRules from " + TableName_;
+			if (Id.empty()) {
+				Select << St, Poco::Data::Keywords::into(Records);
+			} else {
+				auto tId{Id};
+				Select << ConvertParams(St + " where id=?"), Poco::Data::Keywords::into(Records),
+					Poco::Data::Keywords::use(tId);
+			}
+			Select.execute();
+			return true;
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
+
+	void EntityDB::LoadSourceIPs() {
+		std::map<std::string, Types::StringVec> Sources;
+		Iterate([&Sources](const ProvObjects::Entity &E) -> bool {
+			if (!E.sourceIP.empty())
+				Sources[E.info.id] = E.sourceIP;
+			return true;
+		});
+		SourceIPs_.Load(std::move(Sources));
+	}
+
 	bool EntityDB::GetByIP(const std::string &IP, std::string &uuid) {
 		try {
-			std::string UUID;
-			std::function<bool(const ProvObjects::Entity &E)> Function =
-				[&UUID, IP](const ProvObjects::Entity &E) -> bool {
-				if (E.sourceIP.empty())
-					return true;
-				if (CIDR::IpInRanges(IP, E.sourceIP)) {
-					UUID = E.info.id;
-					return false;
-				}
-				return true;
-			};
-			Iterate(Function);
-			uuid = UUID;
+			//	the index is kept current by our own writes; the periodic reload picks up other instances
+			if (!SourceIPs_.Loaded() || (Utils::Now() - SourceIPs_.LoadedAt()) > 300)
+				LoadSourceIPs();
+			return SourceIPs_.Find(IP, uuid);
 		} catch (const Poco::Exception &E) {
 			Logger().log(E);
 		}
 		return false;
 	}
 
+	//	both come from the hierarchy index: no table access
 	void EntityDB::AddVenues(Poco::JSON::Object &Tree, const std::string &Node) {
-		ProvObjects::Venue E;
-		// std::cout << "Adding venue:" << Node << std::endl;
-		if (StorageService()->VenueDB().GetRecord("id", Node, E)) {
-			Poco::JSON::Array Venues;
-			for (const auto &i : E.children) {
-				Poco::JSON::Object Venue;
-				AddVenues(Venue, i);
-				Venues.add(Venue);
-			}
-			Tree.set("type", "venue");
-			Tree.set("name", E.info.name);
-			Tree.set("uuid", E.info.id);
-			Tree.set("children", Venues);
-		}
+		HierarchyIndex()->BuildTree(Node, Tree);
 	}
 
 	void EntityDB::BuildTree(Poco::JSON::Object &Tree, const std::string &Node) {
-		ProvObjects::Entity E;
-		// std::cout << "Adding node:" << Node << std::endl;
-		if (StorageService()->EntityDB().GetRecord("id", Node, E)) {
-			Poco::JSON::Array Children;
-			for (const auto &i : E.children) {
-				Poco::JSON::Object Child;
-				BuildTree(Child, i);
-				Children.add(Child);
-			}
-			Poco::JSON::Array Venues;
-			for (const auto &i : E.venues) {
-				Poco::JSON::Object Venue;
-				AddVenues(Venue, i);
-				Venues.add(Venue);
-			}
-			Tree.set("type", "entity");
-			Tree.set("name", E.info.name);
-			Tree.set("uuid", E.info.id);
-			Tree.set("children", Children);
-			Tree.set("venues", Venues);
-		}
+		HierarchyIndex()->BuildTree(Node, Tree);
 	}
 
 	void EntityDB::ImportVenues(const Poco::JSON::Object::Ptr &O, const std::string &Parent) {
@@ -193,16 +241,8 @@ namespace OpenWifi {
 	}
 
 	bool EntityDB::EvaluateDeviceRules(const std::string &id, ProvObjects::DeviceRules &Rules) {
-		ProvObjects::Entity E;
-		if (GetRecord("id", id, E)) {
-			if (!Storage::ApplyRules(E.deviceRules, Rules))
-				return true;
-
-			if (!E.parent.empty()) {
-				return EvaluateDeviceRules(E.parent, Rules);
-			}
-		}
-		Storage::ApplyConfigRules(Rules);
+		if (HierarchyIndex()->ApplyRules(id, Rules))
+			Storage::ApplyConfigRules(Rules);
 		return true;
 	}
 
@@ -237,6 +277,9 @@ void ORM::DB<OpenWifi::EntityDBRecordType, OpenWifi::ProvObjects::Entity>::Conve
 	Out.configurations = OpenWifi::RESTAPI_utils::to_object_array(In.get<21>());
 }
 
+//	the member lists are kept in the memberships table, see MembershipDB
+static const std::string NoMembers{"[]"};
+
 template <>
 void ORM::DB<OpenWifi::EntityDBRecordType, OpenWifi::ProvObjects::Entity>::Convert(
 	const OpenWifi::ProvObjects::Entity &In, OpenWifi::EntityDBRecordType &Out) {
@@ -247,19 +290,19 @@ void ORM::DB<OpenWifi::EntityDBRecordType, OpenWifi::ProvObjects::Entity>::Conve
 	Out.set<4>(In.info.created);
 	Out.set<5>(In.info.modified);
 	Out.set<6>(In.parent);
-	Out.set<7>(OpenWifi::RESTAPI_utils::to_string(In.children));
-	Out.set<8>(OpenWifi::RESTAPI_utils::to_string(In.contacts));
-	Out.set<9>(OpenWifi::RESTAPI_utils::to_string(In.locations));
+	Out.set<7>(NoMembers); // children
+	Out.set<8>(NoMembers); // contacts
+	Out.set<9>(NoMembers); // locations
 	Out.set<10>(In.managementPolicy);
-	Out.set<11>(OpenWifi::RESTAPI_utils::to_string(In.venues));
+	Out.set<11>(NoMembers); // venues
 	Out.set<12>(OpenWifi::RESTAPI_utils::to_string(In.deviceConfiguration));
-	Out.set<13>(OpenWifi::RESTAPI_utils::to_string(In.devices));
+	Out.set<13>(NoMembers); // devices
 	Out.set<14>(OpenWifi::RESTAPI_utils::to_string(In.deviceRules));
 	Out.set<15>(OpenWifi::RESTAPI_utils::to_string(In.info.tags));
 	Out.set<16>(OpenWifi::RESTAPI_utils::to_string(In.sourceIP));
-	Out.set<17>(OpenWifi::RESTAPI_utils::to_string(In.variables));
-	Out.set<18>(OpenWifi::RESTAPI_utils::to_string(In.managementPolicies));
-	Out.set<19>(OpenWifi::RESTAPI_utils::to_string(In.managementRoles));
-	Out.set<20>(OpenWifi::RESTAPI_utils::to_string(In.maps));
-	Out.set<21>(OpenWifi::RESTAPI_utils::to_string(In.configurations));
+	Out.set<17>(NoMembers); // variables
+	Out.set<18>(NoMembers); // managementPolicies
+	Out.set<19>(NoMembers); // managementRoles
+	Out.set<20>(NoMembers); // maps
+	Out.set<21>(NoMembers); // configurations
 }
@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include "HierarchyIndex.h"
+#include "IPRangeIndex.h"
 #include "RESTObjects/RESTAPI_ProvObjects.h"
 #include "framework/orm.h"
 
@@ -20,6 +22,9 @@ namespace OpenWifi {
 						std::string>
 		EntityDBRecordType;
 
+	//	id, name, parent, deviceRules
+	typedef Poco::Tuple<std::string, std::string, std::string, std::string> EntityHierarchyRecord;
+
 	class EntityDB : public ORM::DB<EntityDBRecordType, ProvObjects::Entity> {
 	  public:
 		EntityDB(OpenWifi::DBType T, Poco::Data::SessionPool &P, Poco::Logger &L);
@@ -33,9 +38,56 @@ namespace OpenWifi {
 		bool CreateShortCut(ProvObjects::Entity &E);
 		bool GetByIP(const std::string &IP, std::string &uuid);
 		bool Upgrade(uint32_t from, uint32_t &to) override;
+		//	the member lists live in the memberships table
+		bool ManipulateRelation(Types::UUIDvec_t ProvObjects::Entity::*List, field_name_t FieldName,
+								const std::string &ParentUUID, const std::string &ChildUUID,
+								bool Add, bool &Changed) override;
+		void Complete(ProvObjects::Entity *Records, std::size_t Count) override;
+		bool CollectionState(std::vector<uint64_t> &State) override;
+		//	members for many records at once, with a single insert
+		bool AddMembers(Types::UUIDvec_t ProvObjects::Entity::*List,
+						const std::map<std::string, Types::UUIDvec_t> &Members);
 		bool EvaluateDeviceRules(const std::string &id, ProvObjects::DeviceRules &Rules);
+		//	the columns of every record, or of Id only, that the hierarchy index needs
+		bool GetHierarchyRecords(std::vector<EntityHierarchyRecord> &Records,
+								 const std::string &Id = "");
 
 	  private:
 		inline static const std::string RootUUID_{"0000-0000-0000"};
+		IPRangeIndex SourceIPs_;
+
+		void LoadSourceIPs();
+		void AddLists(const ProvObjects::Entity &R);
+		void RemoveLists(const std::string &Id);
+
+	  protected:
+		//	every write keeps the member lists in step at once, and the sourceIP and hierarchy
+		//	indexes once it is durable
+		void Created(const ProvObjects::Entity &R) override {
+			AddLists(R);
+			Updated(R);
+		}
+
+		void Updated(const ProvObjects::Entity &R) override {
+			ORM::UnitOfWork::OnCommit(Pool_, [this, R]() {
+				SourceIPs_.Set(R.info.id, R.sourceIP);
+				HierarchyIndex()->SetEntity(R);
+			});
+		}
+
+		void Removed(const std::string &Id) override {
+			RemoveLists(Id);
+			ORM::UnitOfWork::OnCommit(Pool_, [this, Id]() {
+				SourceIPs_.Remove(Id);
+				HierarchyIndex()->Remove(Id);
+			});
+		}
+
+		void TableRewritten() override {
+			ORM::UnitOfWork::OnCommit(Pool_, [this]() {
+				SourceIPs_.Invalidate();
+				HierarchyIndex()->Invalidate();
+			});
+		}
 	};
 } // namespace OpenWifi
@@ -6,6 +6,8 @@
 //	Arilia Wireless Inc.
 //
 
+#include <limits>
+
 #include "storage_inventory.h"
 #include "RESTObjects/RESTAPI_SecurityObjects.h"
 #include "SerialNumberCache.h"
@@ -50,7 +52,11 @@ namespace OpenWifi {
 		{std::string("inventory_name_index"),
 		 ORM::IndexEntryVec{{std::string("name"), ORM::Indextype::ASC}}},
 		{std::string("inventory_serial_index"),
-		 ORM::IndexEntryVec{{std::string("serialNumber"), ORM::Indextype::ASC}}}};
+		 ORM::IndexEntryVec{{std::string("serialNumber"), ORM::Indextype::ASC}}},
+		{std::string("inventory_venue_index"),
+		 ORM::IndexEntryVec{{std::string("venue"), ORM::Indextype::ASC}}},
+		{std::string("inventory_entity_index"),
+		 ORM::IndexEntryVec{{std::string("entity"), ORM::Indextype::ASC}}}};
 
 	bool InventoryDB::Upgrade([[maybe_unused]] uint32_t from, uint32_t &to) {
 		to = Version();
@@ -74,6 +80,18 @@ namespace OpenWifi {
 
 #define __DBG__ std::cout << __FILE__ << ": " << __LINE__ << std::endl;
 
+	std::string DeviceConnectionInfo::IP() const {
+		auto Tokens = Poco::StringTokenizer(ConnectionInfo, "@:");
+		if (Tokens.count() == 3) {
+			return Tokens[1];
+		}
+		return "";
+	}
+
+	uint64_t DeviceConnectionInfo::Fingerprint() const {
+		return SerialNumberCache::ConnectionFingerprint(DeviceType, Locale, IP());
+	}
+
 	InventoryDB::InventoryDB(OpenWifi::DBType T, Poco::Data::SessionPool &P, Poco::Logger &L)
 		: DB(T, "inventory", InventoryDB_Fields, InventoryDB_Indexes, P, L, "inv") {}
 
@@ -83,106 +101,177 @@ namespace OpenWifi {
 										   const std::string &Locale) {
 
 		ProvObjects::InventoryTag ExistingDevice;
-		auto SerialNumber = Poco::toLower(SerialNumberRaw);
-		if (!GetRecord("serialNumber", SerialNumber, ExistingDevice)) {
-            ProvObjects::InventoryTag NewDevice;
-			uint64_t Now = Utils::Now();
-
-			auto Tokens = Poco::StringTokenizer(ConnectionInfo, "@:");
-			std::string IP;
-			if (Tokens.count() == 3) {
-				IP = Tokens[1];
-			}
-			NewDevice.info.id = MicroServiceCreateUUID();
-			NewDevice.info.name = SerialNumber;
-			NewDevice.info.created = NewDevice.info.modified = Now;
-			NewDevice.info.notes.push_back(SecurityObjects::NoteInfo{
-				.created = Now, .createdBy = "*system", .note = "Auto discovered"});
-			NewDevice.serialNumber = SerialNumber;
-			NewDevice.deviceType = DeviceType;
-			NewDevice.locale = Locale;
-			nlohmann::json StateDoc;
-			StateDoc["method"] = "auto-discovery";
-			StateDoc["date"] = Utils::Now();
-			NewDevice.state = to_string(StateDoc);
-			NewDevice.devClass = "any";
-			if (!IP.empty()) {
-				StorageService()->VenueDB().GetByIP(IP, NewDevice.venue);
-				if (NewDevice.venue.empty()) {
-					StorageService()->EntityDB().GetByIP(IP, NewDevice.entity);
-				}
+		DeviceConnectionInfo Connection{Poco::toLower(SerialNumberRaw), ConnectionInfo, DeviceType,
+										Locale};
+		if (!GetRecord("serialNumber", Connection.SerialNumber, ExistingDevice)) {
+			if (AddDiscoveredDevice(Connection)) {
+				SerialNumberCache()->SetFingerprint(Connection.SerialNumber,
+													Connection.Fingerprint());
+				return true;
 			}
+			return false;
+		}
 
-			if (CreateRecord(NewDevice)) {
-				SerialNumberCache()->AddSerialNumber(SerialNumber, DeviceType);
-				std::string FullUUID;
-				if (!NewDevice.entity.empty()) {
-					StorageService()->EntityDB().AddDevice("id", NewDevice.entity,
-														   NewDevice.info.id);
-					FullUUID = StorageService()->EntityDB().Prefix() + ":" + NewDevice.entity;
-				} else if (!NewDevice.venue.empty()) {
-					StorageService()->VenueDB().AddDevice("id", NewDevice.venue, NewDevice.info.id);
-					FullUUID = StorageService()->VenueDB().Prefix() + ":" + NewDevice.venue;
-				}
+		if (RefreshFromConnection(ExistingDevice, Connection)) {
+			if (!DB::UpdateRecord("id", ExistingDevice.info.id, ExistingDevice))
+				return false;
+		}
+		SerialNumberCache()->SetFingerprint(Connection.SerialNumber, Connection.Fingerprint());
+		return false;
+	}
 
-				if (!FullUUID.empty()) {
-					if (SDK::GW::Device::SetVenue(nullptr, NewDevice.serialNumber, FullUUID)) {
-						Logger().information(Poco::format("%s: GW set entity/venue property.",
-														  NewDevice.serialNumber));
-					} else {
-						Logger().information(Poco::format(
-							"%s: could not set GW entity/venue property.", NewDevice.serialNumber));
-					}
-				}
-				Logger().information(Poco::format("Adding %s to inventory.", SerialNumber));
-				return true;
-			} else {
-				Logger().information(Poco::format("Could not add %s to inventory.", SerialNumber));
+	uint64_t InventoryDB::CreateFromConnections(const DeviceConnectionInfoVec &Connections) {
+		if (Connections.empty())
+			return 0;
+
+		std::map<std::string, const DeviceConnectionInfo *> BySerialNumber;
+		std::vector<std::string> SerialNumbers;
+		for (const auto &Connection : Connections) {
+			auto SerialNumber = Poco::toLower(Connection.SerialNumber);
+			BySerialNumber[SerialNumber] = &Connection;
+			SerialNumbers.push_back(SerialNumber);
+		}
+
+		//	one lookup for the whole batch instead of one per message
+		RecordVec ExistingDevices;
+		GetRecordsIn("serialNumber", SerialNumbers, ExistingDevices);
+
+		std::vector<std::pair<std::string, ProvObjects::InventoryTag>> Updates;
+		std::vector<std::pair<std::string, uint64_t>> Fingerprints;
+		for (auto &ExistingDevice : ExistingDevices) {
+			auto Hint = BySerialNumber.find(ExistingDevice.serialNumber);
+			if (Hint == BySerialNumber.end())
+				continue;
+			if (RefreshFromConnection(ExistingDevice, *Hint->second)) {
+				Updates.emplace_back(ExistingDevice.info.id, ExistingDevice);
 			}
-		} else {
-			//  Device already exists, do we need to modify anything?
-			bool modified = false;
-			if (ExistingDevice.deviceType != DeviceType) {
-				ExistingDevice.deviceType = DeviceType;
-				modified = true;
+			Fingerprints.emplace_back(Hint->first, Hint->second->Fingerprint());
+			BySerialNumber.erase(Hint);
+		}
+
+		//	remember what the inventory now holds so that identical pings can skip the database
+		if (UpdateRecords("id", Updates)) {
+			for (const auto &[SerialNumber, Fingerprint] : Fingerprints)
+				SerialNumberCache()->SetFingerprint(SerialNumber, Fingerprint);
+		}
+
+		//	whatever is left is not in the inventory yet
+		uint64_t Created = 0;
+		for (const auto &[SerialNumber, Connection] : BySerialNumber) {
+			DeviceConnectionInfo NewConnection{*Connection};
+			NewConnection.SerialNumber = SerialNumber;
+			if (AddDiscoveredDevice(NewConnection)) {
+				SerialNumberCache()->SetFingerprint(SerialNumber, NewConnection.Fingerprint());
+				Created++;
 			}
+		}
+		return Created;
+	}
 
-			//  if this device is being claimed, not it is claimed.
-			if (!ExistingDevice.state.empty()) {
-				auto State = nlohmann::json::parse(ExistingDevice.state);
-				if (State["method"] == "claiming") {
-					uint64_t Date = State["date"];
-					uint64_t Now = Utils::Now();
-
-					if ((Now - Date) < (24 * 60 * 60)) {
-						State["method"] = "claimed";
-						State["date"] = Utils::Now();
-						ExistingDevice.state = to_string(State);
-						modified = true;
-					} else {
-						ExistingDevice.state = "";
-						modified = true;
-					}
-				}
-			} else {
-				ExistingDevice.devClass = "any";
-				modified = true;
+	bool InventoryDB::AddDiscoveredDevice(const DeviceConnectionInfo &Connection) {
+		ProvObjects::InventoryTag NewDevice;
+		uint64_t Now = Utils::Now();
+
+		auto IP = Connection.IP();
+		NewDevice.info.id = MicroServiceCreateUUID();
+		NewDevice.info.name = Connection.SerialNumber;
+		NewDevice.info.created = NewDevice.info.modified = Now;
+		NewDevice.info.notes.push_back(SecurityObjects::NoteInfo{
+			.created = Now, .createdBy = "*system", .note = "Auto discovered"});
+		NewDevice.serialNumber = Connection.SerialNumber;
+		NewDevice.deviceType = Connection.DeviceType;
+		NewDevice.locale = Connection.Locale;
+		nlohmann::json StateDoc;
+		StateDoc["method"] = "auto-discovery";
+		StateDoc["date"] = Utils::Now();
+		NewDevice.state = to_string(StateDoc);
+		NewDevice.devClass = "any";
+		if (!IP.empty()) {
+			StorageService()->VenueDB().GetByIP(IP, NewDevice.venue);
+			if (NewDevice.venue.empty()) {
+				StorageService()->EntityDB().GetByIP(IP, NewDevice.entity);
 			}
+		}
 
-			if (Locale != ExistingDevice.locale) {
-				ExistingDevice.locale = Locale;
-				modified = true;
+		if (CreateRecord(NewDevice)) {
+			SerialNumberCache()->AddSerialNumber(NewDevice.serialNumber, NewDevice.deviceType);
+			std::string FullUUID;
+			if (!NewDevice.entity.empty()) {
+				StorageService()->EntityDB().AddDevice("id", NewDevice.entity, NewDevice.info.id);
+				FullUUID = StorageService()->EntityDB().Prefix() + ":" + NewDevice.entity;
+			} else if (!NewDevice.venue.empty()) {
+				StorageService()->VenueDB().AddDevice("id", NewDevice.venue, NewDevice.info.id);
+				FullUUID = StorageService()->VenueDB().Prefix() + ":" + NewDevice.venue;
 			}
 
-			if (modified) {
-				ExistingDevice.info.modified = Utils::Now();
-				StorageService()->InventoryDB().UpdateRecord("id", ExistingDevice.info.id,
-															 ExistingDevice);
+			if (!FullUUID.empty()) {
+				if (SDK::GW::Device::SetVenue(nullptr, NewDevice.serialNumber, FullUUID)) {
+					Logger().information(Poco::format("%s: GW set entity/venue property.",
+													  NewDevice.serialNumber));
+				} else {
+					Logger().information(Poco::format(
+						"%s: could not set GW entity/venue property.", NewDevice.serialNumber));
+				}
 			}
+			Logger().information(Poco::format("Adding %s to inventory.", NewDevice.serialNumber));
+			return true;
 		}
+		Logger().information(
+			Poco::format("Could not add %s to inventory.", NewDevice.serialNumber));
 		return false;
 	}
 
+	bool InventoryDB::RefreshFromConnection(ProvObjects::InventoryTag &ExistingDevice,
+											const DeviceConnectionInfo &Connection) {
+		//  Device already exists, do we need to modify anything?
+		bool modified = false;
+		if (ExistingDevice.deviceType != Connection.DeviceType) {
+			ExistingDevice.deviceType = Connection.DeviceType;
+			modified = true;
+		}
+
+		//  if this device is being claimed, not it is claimed.
+		if (!ExistingDevice.state.empty()) {
+			//	the state is not validated on POST: a malformed one is left alone, so it cannot
+			//	fail the whole auto-discovery batch the device arrives in
+			auto State = nlohmann::json::parse(ExistingDevice.state, nullptr, false);
+			auto Method = State.is_object() ? State.find("method") : State.end();
+			if (State.is_discarded() || !State.is_object()) {
+				Logger().warning(Poco::format("%s: ignoring malformed inventory state.",
+											  ExistingDevice.serialNumber));
+			} else if (Method != State.end() && *Method == "claiming") {
+				auto Claimed = State.find("date");
+				uint64_t Date = (Claimed != State.end() && Claimed->is_number_unsigned())
+									? Claimed->get<uint64_t>()
+									: 0;
+				uint64_t Now = Utils::Now();
+
+				if ((Now - Date) < (24 * 60 * 60)) {
+					State["method"] = "claimed";
+					State["date"] = Utils::Now();
+					ExistingDevice.state = to_string(State);
+					modified = true;
+				} else {
+					ExistingDevice.state = "";
+					modified = true;
+				}
+			}
+		} else if (ExistingDevice.devClass != "any") {
+			ExistingDevice.devClass = "any";
+			modified = true;
+		}
+
+		if (Connection.Locale != ExistingDevice.locale) {
+			ExistingDevice.locale = Connection.Locale;
+			modified = true;
+		}
+
+		if (modified) {
+			ExistingDevice.info.modified = Utils::Now();
+		}
+		return modified;
+	}
+
 	bool InventoryDB::EvaluateDeviceIDRules(const std::string &id,
 											ProvObjects::DeviceRules &Rules) {
 		ProvObjects::InventoryTag T;
@@ -191,12 +280,23 @@ namespace OpenWifi {
 		return false;
 	}
 
+	//	From the device rules and hierarchy indexes. A device missing from the index (a serial
+	//	number that is not hexadecimal, or one written by another instance since the last reload)
+	//	is read from the table and added to the index.
 	bool InventoryDB::EvaluateDeviceSerialNumberRules(const std::string &serialNumber,
 													  ProvObjects::DeviceRules &Rules) {
+		if (DeviceRulesIndex()->Evaluate(serialNumber, Rules))
+			return true;
 		ProvObjects::InventoryTag T;
-		if (GetRecord("serialNumber", serialNumber, T))
-			return EvaluateDeviceRules(T, Rules);
-		return false;
+		if (!GetRecord("serialNumber", serialNumber, T))
+			return false;
+		DeviceRulesIndex()->Set(T);
+		Rules = T.deviceRules;
+		const auto &Owner = T.venue.empty() ? T.entity : T.venue;
+		if (!Owner.empty())
+			HierarchyIndex()->ApplyRules(Owner, Rules);
+		Storage::ApplyConfigRules(Rules);
+		return true;
 	}
 
 	bool InventoryDB::EvaluateDeviceRules(const ProvObjects::InventoryTag &T,
@@ -205,7 +305,7 @@ namespace OpenWifi {
 		if (!T.venue.empty())
 			return StorageService()->VenueDB().EvaluateDeviceRules(T.venue, Rules);
 		if (!T.entity.empty())
-			return StorageService()->EntityDB().EvaluateDeviceRules(T.venue, Rules);
+			return StorageService()->EntityDB().EvaluateDeviceRules(T.entity, Rules);
 		return Storage::ApplyConfigRules(Rules);
 	}
 
@@ -217,21 +317,48 @@ namespace OpenWifi {
 		Iterate(F);
 	}
 
-	bool InventoryDB::GetRRMDeviceList(Types::UUIDvec_t &DeviceList) {
-		// get a local copy of the cache - this could be expensive.
-		auto C = SerialNumberCache()->GetCacheCopy();
-
-		for (const auto &i : C) {
-			ProvObjects::InventoryTag Tag;
-			ProvObjects::DeviceRules Rules;
-			std::string SerialNumber = Utils::IntToSerialNumber(i);
-			if (EvaluateDeviceSerialNumberRules(SerialNumber, Rules)) {
-				if (Rules.rrm != "no" && Rules.rrm != "inherit")
-					DeviceList.push_back(SerialNumber);
-			}
+	bool InventoryDB::GetDevicesUnder(const std::string &Id, RecordVec &Devices, bool Recursive) {
+		Types::UUIDvec_t Entities, Venues;
+		if (!Recursive) {
+			Entities.push_back(Id);
+			Venues.push_back(Id);
+		} else if (!HierarchyIndex()->Descendants(Id, Entities, Venues)) {
+			return false;
 		}
+
+		std::string Where;
+		auto AddMembers = [&Where](const char *Field, const Types::UUIDvec_t &Ids) {
+			if (Ids.empty())
+				return;
+			Where += (Where.empty() ? std::string{Field} : std::string{" or "} + Field) + " in (";
+			for (std::size_t i = 0; i < Ids.size(); ++i)
+				Where += (i == 0 ? "'" : ",'") + ORM::Escape(Ids[i]) + "'";
+			Where += ")";
+		};
+		AddMembers("venue", Venues);
+		AddMembers("entity", Entities);
+		return GetRecords(0, std::numeric_limits<int64_t>::max(), Devices, Where);
+	}
+
+	bool InventoryDB::GetRRMDeviceList(Types::UUIDvec_t &DeviceList) {
+		DeviceRulesIndex()->RRMDevices(DeviceList);
 		return true;
 	}
+
+	//	only the columns the device rules index needs, in one statement
+	bool InventoryDB::GetDeviceRulesRecords(std::vector<DeviceRulesRecord> &Records) {
+		try {
+			Poco::Data::Session Session = Pool_.get();
+			Poco::Data::Statement Select(Session);
+			Select << "select serialNumber, venue, entity, deviceRules from " + TableName_,
+				Poco::Data::Keywords::into(Records);
+			Select.execute();
+			return true;
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
+		}
+		return false;
+	}
 } // namespace OpenWifi
 
 template <>
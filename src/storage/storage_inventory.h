@@ -8,7 +8,9 @@
 
 #pragma once
 
+#include "DeviceRulesIndex.h"
 #include "RESTObjects/RESTAPI_ProvObjects.h"
+#include "SerialNumberCache.h"
 #include "framework/orm.h"
 
 namespace OpenWifi {
@@ -19,6 +21,20 @@ namespace OpenWifi {
 						std::string, std::string, bool>
 		InventoryDBRecordType;
 
+	//	serialNumber, venue, entity, deviceRules
+	typedef Poco::Tuple<std::string, std::string, std::string, std::string> DeviceRulesRecord;
+
+	struct DeviceConnectionInfo {
+		std::string SerialNumber;
+		std::string ConnectionInfo;
+		std::string DeviceType;
+		std::string Locale;
+
+		[[nodiscard]] std::string IP() const;
+		[[nodiscard]] uint64_t Fingerprint() const;
+	};
+	typedef std::vector<DeviceConnectionInfo> DeviceConnectionInfoVec;
+
 	class InventoryDB : public ORM::DB<InventoryDBRecordType, ProvObjects::InventoryTag> {
 	  public:
 		InventoryDB(OpenWifi::DBType T, Poco::Data::SessionPool &P, Poco::Logger &L);
@@ -26,20 +42,101 @@ namespace OpenWifi {
 		bool CreateFromConnection(const std::string &SerialNumber,
 								  const std::string &ConnectionInfo, const std::string &DeviceType,
 								  const std::string &Locale);
+		uint64_t CreateFromConnections(const DeviceConnectionInfoVec &Connections);
 
 		void InitializeSerialCache();
+		//	devices of an entity or a venue and, when Recursive, of everything below it
+		bool GetDevicesUnder(const std::string &Id, RecordVec &Devices, bool Recursive = true);
 		bool GetRRMDeviceList(Types::UUIDvec_t &DeviceList);
+		bool GetDeviceRulesRecords(std::vector<DeviceRulesRecord> &Records);
 
 		bool EvaluateDeviceIDRules(const std::string &id, ProvObjects::DeviceRules &Rules);
 		bool EvaluateDeviceSerialNumberRules(const std::string &serialNumber,
 											 ProvObjects::DeviceRules &Rules);
 
+		//	writes go through here so the device rules index stays in sync with the table
+		bool CreateRecord(const ProvObjects::InventoryTag &R) {
+			if (!DB::CreateRecord(R))
+				return false;
+			Indexed(R);
+			return true;
+		}
+
+		bool CreateRecords(const RecordVec &Records) {
+			if (!DB::CreateRecords(Records))
+				return false;
+			for (const auto &R : Records)
+				Indexed(R);
+			return true;
+		}
+
+		//	any write outside of auto-discovery invalidates the connection fingerprint of the device
+		template <typename T>
+		bool UpdateRecord(field_name_t FieldName, const T &Value,
+						  const ProvObjects::InventoryTag &R) {
+			SerialNumberCache()->ClearFingerprint(R.serialNumber);
+			if (!DB::UpdateRecord(FieldName, Value, R))
+				return false;
+			Indexed(R);
+			return true;
+		}
+
+		//	batched writes come from auto-discovery and the consistency check, which manage the
+		//	fingerprints themselves
+		template <typename T>
+		bool UpdateRecords(field_name_t FieldName,
+						   const std::vector<std::pair<T, ProvObjects::InventoryTag>> &Updates) {
+			if (!DB::UpdateRecords(FieldName, Updates))
+				return false;
+			for (const auto &Update : Updates)
+				Indexed(Update.second);
+			return true;
+		}
+
+		template <typename T> bool DeleteRecord(field_name_t FieldName, const T &Value) {
+			if constexpr (std::is_convertible_v<T, std::string>) {
+				std::string Field{FieldName};
+				if (Field == "serialNumber") {
+					SerialNumberCache()->ClearFingerprint(Value);
+					if (!DB::DeleteRecord(FieldName, Value))
+						return false;
+					Unindexed(Value);
+					return true;
+				}
+				ProvObjects::InventoryTag Existing;
+				if (Field == "id" && GetRecord(FieldName, Value, Existing)) {
+					SerialNumberCache()->ClearFingerprint(Existing.serialNumber);
+					if (!DB::DeleteRecord(FieldName, Value))
+						return false;
+					Unindexed(Existing.serialNumber);
+					return true;
+				}
+			}
+			SerialNumberCache()->ClearFingerprints();
+			if (!DB::DeleteRecord(FieldName, Value))
+				return false;
+			ORM::UnitOfWork::OnCommit(Pool_, []() { DeviceRulesIndex()->Invalidate(); });
+			return true;
+		}
+
 		inline uint32_t Version() override { return 1; }
 
 		bool Upgrade(uint32_t from, uint32_t &to) override;
 
 	  private:
+		bool AddDiscoveredDevice(const DeviceConnectionInfo &Connection);
+		bool RefreshFromConnection(ProvObjects::InventoryTag &ExistingDevice,
+								   const DeviceConnectionInfo &Connection);
 		bool EvaluateDeviceRules(const ProvObjects::InventoryTag &T,
 								 ProvObjects::DeviceRules &Rules);
+
+		//	the device rules index follows the table once the write is durable
+		void Indexed(const ProvObjects::InventoryTag &R) {
+			ORM::UnitOfWork::OnCommit(Pool_, [R]() { DeviceRulesIndex()->Set(R); });
+		}
+		void Unindexed(const std::string &SerialNumber) {
+			ORM::UnitOfWork::OnCommit(
+				Pool_, [SerialNumber]() { DeviceRulesIndex()->Remove(SerialNumber); });
+		}
 	};
 } // namespace OpenWifi
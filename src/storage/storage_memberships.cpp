@@ -0,0 +1,220 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#include "storage_memberships.h"
+#include "framework/RESTAPI_utils.h"
+
+#include "fmt/format.h"
+
+namespace OpenWifi {
+
+	//	owners per select when filling lists, and ids per delete
+	static constexpr std::size_t MembershipBatch = 500;
+
+	static ORM::FieldVec MembershipDB_Fields{ORM::Field{"id", 160, true},
+											 ORM::Field{"owner", 64},
+											 ORM::Field{"kind", 32},
+											 ORM::Field{"member", 64}};
+
+	static ORM::IndexVec MembershipDB_Indexes{
+		{std::string("membership_owner_index"),
+		 ORM::IndexEntryVec{{std::string("owner"), ORM::Indextype::ASC}}},
+		{std::string("membership_member_index"),
+		 ORM::IndexEntryVec{{std::string("member"), ORM::Indextype::ASC}}}};
+
+	MembershipDB::MembershipDB(OpenWifi::DBType T, Poco::Data::SessionPool &P, Poco::Logger &L)
+		: DB(T, "memberships", MembershipDB_Fields, MembershipDB_Indexes, P, L, "mbr") {}
+
+	//	an insert that leaves an existing row alone and reports no change
+	std::string MembershipDB::InsertIgnore() const {
+		switch (Type_) {
+		case OpenWifi::DBType::mysql:
+			return "insert ignore into " + TableName_ + " ( " + SelectFields() + " ) values " +
+				   SelectList();
+		case OpenWifi::DBType::pgsql:
+			return ConvertParams("insert into " + TableName_ + " ( " + SelectFields() +
+								 " ) values " + SelectList() + " on conflict do nothing");
+		default:
+			return "insert or ignore into " + TableName_ + " ( " + SelectFields() + " ) values " +
+				   SelectList();
+		}
+	}
+
+	static std::string InList(std::vector<std::string>::const_iterator First,
+							  std::vector<std::string>::const_iterator Last) {
+		std::string List;
+		for (auto i = First; i != Last; ++i) {
+			if (!List.empty())
+				List += ",";
+			List += "'" + ORM::Escape(*i) + "'";
+		}
+		return List;
+	}
+
+	bool MembershipDB::Update(const std::string &Owner, const std::string &Kind,
+							  const std::string &Member, bool Add) {
+		try {
+			Poco::Data::Session Session = ORM::UnitOfWork::SessionFor(Pool_);
+			Poco::Data::Statement Statement(Session);
+			auto Id = Key(Owner, Kind, Member);
+			std::size_t Changed;
+			if (Add) {
+				MembershipRecordType RT{Id, Owner, Kind, Member};
+				Statement << InsertIgnore(), Poco::Data::Keywords::use(RT);
+				Changed = Statement.execute();
+			} else {
+				Statement << ConvertParams("delete from " + TableName_ + " where id=?"),
+					Poco::Data::Keywords::use(Id);
+				Changed = Statement.execute();
+			}
+			if (Changed)
+				TableChanged();
+			return Changed > 0;
+		} catch (const Poco::Exception &E) {
+			Failed(E);
+		}
+		return false;
+	}
+
+	bool MembershipDB::AddMembers(const std::vector<Membership> &Members) {
+		if (Members.empty())
+			return true;
+		try {
+			Poco::Data::Session Session = ORM::UnitOfWork::SessionFor(Pool_);
+			auto St = InsertIgnore();
+			bool Own = !Session.isTransaction();
+			try {
+				if (Own)
+					Session.begin();
+				//	one statement bound to all the rows
+				std::vector<MembershipRecordType> Rows;
+				Rows.reserve(Members.size());
+				for (const auto &M : Members)
+					Rows.emplace_back(M.id, M.owner, M.kind, M.member);
+				Poco::Data::Statement Insert(Session);
+				Insert << St, Poco::Data::Keywords::use(Rows);
+				Insert.execute();
+				if (Own)
+					Session.commit();
+			} catch (...) {
+				if (Own && Session.isTransaction())
+					Session.rollback();
+				throw;
+			}
+			TableChanged();
+			return true;
+		} catch (const Poco::Exception &E) {
+			Failed(E);
+		}
+		return false;
+	}
+
+	bool MembershipDB::RemoveOwner(const std::string &Owner) {
+		return DeleteRecords(fmt::format("owner='{}'", ORM::Escape(Owner)));
+	}
+
+	bool MembershipDB::RemoveMembers(const std::vector<std::string> &Ids) {
+		for (std::size_t i = 0; i < Ids.size(); i += MembershipBatch) {
+			auto Last = Ids.begin() + std::min(Ids.size(), i + MembershipBatch);
+			if (!DeleteRecords("id in (" + InList(Ids.begin() + i, Last) + ")"))
+				return false;
+		}
+		return true;
+	}
+
+	bool MembershipDB::GetLists(const std::vector<std::string> &Owners, OwnerLists &Lists) {
+		try {
+			Poco::Data::Session Session = ORM::UnitOfWork::SessionFor(Pool_);
+			for (std::size_t i = 0; i < Owners.size(); i += MembershipBatch) {
+				auto Last = Owners.begin() + std::min(Owners.size(), i + MembershipBatch);
+				std::vector<std::string> Owner, Kind, Member;
+				Poco::Data::Statement Select(Session);
+				Select << "select owner, kind, member from " + TableName_ + " where owner in (" +
+							  InList(Owners.begin() + i, Last) + ") order by owner, kind, member",
+					Poco::Data::Keywords::into(Owner), Poco::Data::Keywords::into(Kind),
+					Poco::Data::Keywords::into(Member);
+				Select.execute();
+				for (std::size_t j = 0; j < Owner.size(); ++j)
+					Lists[Owner[j]][Kind[j]].push_back(std::move(Member[j]));
+			}
+			return true;
+		} catch (const Poco::Exception &E) {
+			Failed(E);
+		}
+		return false;
+	}
+
+	//	Runs at every start: the lists are inserted and their column emptied in one transaction,
+	//	so once a table is migrated this is a single select per column returning nothing.
+	bool MembershipDB::Migrate(const std::string &Table, const std::vector<std::string> &Columns) {
+		try {
+			Poco::Data::Session Session = ORM::UnitOfWork::SessionFor(Pool_);
+			auto St = InsertIgnore();
+			for (const auto &Column : Columns) {
+				std::vector<std::string> Ids, Lists;
+				Poco::Data::Statement Select(Session);
+				Select << fmt::format("select id, {0} from {1} where {0} is not null and {0}<>'' "
+									  "and {0}<>'[]'",
+									  Column, Table),
+					Poco::Data::Keywords::into(Ids), Poco::Data::Keywords::into(Lists);
+				Select.execute();
+				if (Ids.empty())
+					continue;
+
+				uint64_t Moved = 0;
+				bool Own = !Session.isTransaction();
+				try {
+					if (Own)
+						Session.begin();
+					for (std::size_t i = 0; i < Ids.size(); ++i) {
+						for (const auto &Member : RESTAPI_utils::to_object_array(Lists[i])) {
+							Poco::Data::Statement Insert(Session);
+							MembershipRecordType RT{Key(Ids[i], Column, Member), Ids[i], Column,
+													Member};
+							Insert << St, Poco::Data::Keywords::use(RT);
+							Insert.execute();
+							Moved++;
+						}
+						Poco::Data::Statement Clear(Session);
+						Clear << ConvertParams(fmt::format("update {} set {}='[]' where id=?", Table,
+														   Column)),
+							Poco::Data::Keywords::use(Ids[i]);
+						Clear.execute();
+					}
+					if (Own)
+						Session.commit();
+				} catch (...) {
+					if (Own && Session.isTransaction())
+						Session.rollback();
+					throw;
+				}
+				poco_information(Logger_, fmt::format("Moved {} {} members of {} {} to {}.", Moved,
+													  Column, Ids.size(), Table, TableName_));
+			}
+			return true;
+		} catch (const Poco::Exception &E) {
+			Failed(E);
+		}
+		return false;
+	}
+
+} // namespace OpenWifi
+
+template <>
+void ORM::DB<OpenWifi::MembershipRecordType, OpenWifi::Membership>::Convert(
+	const OpenWifi::MembershipRecordType &In, OpenWifi::Membership &Out) {
+	Out.id = In.get<0>();
+	Out.owner = In.get<1>();
+	Out.kind = In.get<2>();
+	Out.member = In.get<3>();
+}
+
+template <>
+void ORM::DB<OpenWifi::MembershipRecordType, OpenWifi::Membership>::Convert(
+	const OpenWifi::Membership &In, OpenWifi::MembershipRecordType &Out) {
+	Out.set<0>(In.id);
+	Out.set<1>(In.owner);
+	Out.set<2>(In.kind);
+	Out.set<3>(In.member);
+}
@@ -0,0 +1,139 @@
+//
+// Created by agent on 2026-10-18.
+//
+
+#pragma once
+
+#include <map>
+#include <utility>
+
+#include "framework/OpenWifiTypes.h"
+#include "framework/orm.h"
+
+namespace OpenWifi {
+
+	//	one member of one list of a venue or an entity
+	struct Membership {
+		std::string id; //	owner:kind:member, so adding a member twice is a no-op
+		std::string owner;
+		std::string kind;
+		std::string member;
+	};
+
+	typedef Poco::Tuple<std::string, std::string, std::string, std::string> MembershipRecordType;
+
+	//	the lists of a record type kept in the memberships table, with the name of each
+	template <typename Record>
+	using MemberLists = std::vector<std::pair<std::string, Types::UUIDvec_t Record::*>>;
+
+	/*
+	 * The device, child, contact, configuration, ... lists of venues and entities. Each member is a
+	 * row, so adding or removing one is a single insert or delete instead of rewriting the whole
+	 * record, and concurrent changes to the same list no longer overwrite each other. The venue
+	 * and entity tables fill their lists from here when records are read, so the objects and the
+	 * REST representation are unchanged.
+	 */
+	class MembershipDB : public ORM::DB<MembershipRecordType, Membership> {
+	  public:
+		typedef std::map<std::string, std::map<std::string, Types::UUIDvec_t>> OwnerLists;
+
+		MembershipDB(OpenWifi::DBType T, Poco::Data::SessionPool &P, Poco::Logger &L);
+		virtual ~MembershipDB(){};
+
+		//	true when the list changed
+		bool Update(const std::string &Owner, const std::string &Kind, const std::string &Member,
+					bool Add);
+		bool AddMembers(const std::vector<Membership> &Members);
+		bool RemoveOwner(const std::string &Owner);
+		bool RemoveMembers(const std::vector<std::string> &Ids);
+		//	every list of each owner, members sorted
+		bool GetLists(const std::vector<std::string> &Owners, OwnerLists &Lists);
+		//	moves the lists still held in the JSON columns of Table into the memberships table
+		bool Migrate(const std::string &Table, const std::vector<std::string> &Columns);
+
+		static std::string Key(const std::string &Owner, const std::string &Kind,
+							   const std::string &Member) {
+			return Owner + ":" + Kind + ":" + Member;
+		}
+
+		template <typename Record>
+		static const std::string *Kind(const MemberLists<Record> &Lists,
+									   Types::UUIDvec_t Record::*List) {
+			for (const auto &[Name, Member] : Lists) {
+				if (Member == List)
+					return &Name;
+			}
+			return nullptr;
+		}
+
+		//	the id of the record a list belongs to. Members are only added to records that exist.
+		template <typename Table>
+		static bool ResolveOwner(Table &DB, const char *FieldName, const std::string &Value,
+								 bool Add, std::string &Owner) {
+			if (std::string{FieldName} == "id") {
+				Owner = Value;
+				return !Add || DB.Exists("id", Value);
+			}
+			typename Table::RecordName R;
+			if (!DB.GetRecord(FieldName, Value, R))
+				return false;
+			Owner = R.info.id;
+			return true;
+		}
+
+		template <typename Record>
+		bool AddLists(const MemberLists<Record> &Lists, const Record &R) {
+			std::vector<Membership> Members;
+			for (const auto &[Name, List] : Lists) {
+				for (const auto &Member : R.*List)
+					Members.push_back(Membership{Key(R.info.id, Name, Member), R.info.id, Name,
+												 Member});
+			}
+			return AddMembers(Members);
+		}
+
+		//	members of one list of many owners, e.g. the devices of the venues of an import
+		template <typename Record>
+		bool AddToList(const MemberLists<Record> &Lists, Types::UUIDvec_t Record::*List,
+					   const std::map<std::string, Types::UUIDvec_t> &Members) {
+			auto Name = Kind(Lists, List);
+			if (Name == nullptr)
+				return false;
+			std::vector<Membership> Rows;
+			for (const auto &[Owner, Added] : Members) {
+				for (const auto &Member : Added)
+					Rows.push_back(Membership{Key(Owner, *Name, Member), Owner, *Name, Member});
+			}
+			return AddMembers(Rows);
+		}
+
+		template <typename Record>
+		void Fill(const MemberLists<Record> &Lists, Record *Records, std::size_t Count) {
+			if (Count == 0)
+				return;
+			std::vector<std::string> Owners;
+			Owners.reserve(Count);
+			for (std::size_t i = 0; i < Count; ++i)
+				Owners.push_back(Records[i].info.id);
+			OwnerLists Found;
+			if (!GetLists(Owners, Found))
+				return;
+			for (std::size_t i = 0; i < Count; ++i) {
+				auto Hint = Found.find(Records[i].info.id);
+				for (const auto &[Name, List] : Lists) {
+					auto &Members = Records[i].*List;
+					Members.clear();
+					if (Hint == Found.end())
+						continue;
+					auto Listed = Hint->second.find(Name);
+					if (Listed != Hint->second.end())
+						Members = std::move(Listed->second);
+				}
+			}
+		}
+
+	  private:
+		std::string InsertIgnore() const;
+	};
+
+} // namespace OpenWifi
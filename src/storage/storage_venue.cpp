@@ -10,9 +10,9 @@
 
 #include "RESTObjects/RESTAPI_SecurityObjects.h"
 #include "StorageService.h"
-#include "framework/CIDR.h"
 #include "framework/OpenWifiTypes.h"
 #include "framework/RESTAPI_utils.h"
+#include "framework/utils.h"
 #include "storage_venue.h"
 
 namespace OpenWifi {
@@ -51,6 +51,16 @@ namespace OpenWifi {
 	VenueDB::VenueDB(OpenWifi::DBType T, Poco::Data::SessionPool &P, Poco::Logger &L)
 		: DB(T, "venues", VenueDB_Fields, VenueDB_Indexes, P, L, "ven") {}
 
+	//	lists kept in the memberships table rather than in the record
+	static const MemberLists<ProvObjects::Venue> VenueLists{
+		{"children", &ProvObjects::Venue::children},
+		{"devices", &ProvObjects::Venue::devices},
+		{"variables", &ProvObjects::Venue::variables},
+		{"configurations", &ProvObjects::Venue::configurations},
+		{"maps", &ProvObjects::Venue::maps},
+		{"managementPolicies", &ProvObjects::Venue::managementPolicies},
+		{"managementRoles", &ProvObjects::Venue::managementRoles}};
+
 	bool VenueDB::Upgrade([[maybe_unused]] uint32_t from, uint32_t &to) {
 		to = Version();
 		std::vector<std::string> Script{
@@ -70,45 +80,102 @@ namespace OpenWifi {
 			} catch (...) {
 			}
 		}
+
+		std::vector<std::string> Columns;
+		for (const auto &List : VenueLists)
+			Columns.push_back(List.first);
+		StorageService()->MembershipDB().Migrate(TableName_, Columns);
 		return true;
 	}
 
-	bool VenueDB::GetByIP(const std::string &IP, std::string &uuid) {
+	bool VenueDB::ManipulateRelation(Types::UUIDvec_t ProvObjects::Venue::*List,
+									field_name_t FieldName, const std::string &ParentUUID,
+									const std::string &ChildUUID, bool Add, bool &Changed) {
+		auto Kind = MembershipDB::Kind(VenueLists, List);
+		if (Kind == nullptr)
+			return false;
+		std::string Owner;
+		Changed = MembershipDB::ResolveOwner(*this, FieldName, ParentUUID, Add, Owner) &&
+				  StorageService()->MembershipDB().Update(Owner, *Kind, ChildUUID, Add);
+		if (Changed)
+			RecordChanged("id", Owner);
+		return true;
+	}
+
+	void VenueDB::Complete(ProvObjects::Venue *Records, std::size_t Count) {
+		StorageService()->MembershipDB().Fill(VenueLists, Records, Count);
+	}
+
+	//	the lists shown with the records live in the memberships table
+	bool VenueDB::CollectionState(std::vector<uint64_t> &State) {
+		return DB::CollectionState(State) &&
+			   StorageService()->MembershipDB().CollectionState(State);
+	}
+
+	bool VenueDB::AddMembers(Types::UUIDvec_t ProvObjects::Venue::*List,
+							 const std::map<std::string, Types::UUIDvec_t> &Members) {
+		if (!StorageService()->MembershipDB().AddToList(VenueLists, List, Members))
+			return false;
+		for (const auto &[Owner, _] : Members)
+			RecordChanged("id", Owner);
+		return true;
+	}
+
+	void VenueDB::AddLists(const ProvObjects::Venue &R) {
+		StorageService()->MembershipDB().AddLists(VenueLists, R);
+	}
+
+	void VenueDB::RemoveLists(const std::string &Id) {
+		StorageService()->MembershipDB().RemoveOwner(Id);
+	}
+
+	bool VenueDB::GetHierarchyRecords(std::vector<VenueHierarchyRecord> &Records,
+									  const std::string &Id) {
 		try {
-			std::string UUID;
-			std::function<bool(const ProvObjects::Venue &E)> Function =
-				[&UUID, IP](const ProvObjects::Venue &E) -> bool {
-				if (E.sourceIP.empty())
-					return true;
-				if (CIDR::IpInRanges(IP, E.sourceIP)) {
-					UUID = E.info.id;
-					return false;
-				}
-				return true;
-			};
-			Iterate(Function);
-			uuid = UUID;
+			Poco::Data::Session Session = Pool_.get();
+			Poco::Data::Statement Select(Session);
+			std::string St = "select id, name, parent, entity, deviceRules from " + TableName_;
+			if (Id.empty()) {
+				Select << St, Poco::Data::Keywords::into(Records);
+			} else {
+				auto tId{Id};
+				Select << ConvertParams(St + " where id=?"), Poco::Data::Keywords::into(Records),
+					Poco::Data::Keywords::use(tId);
+			}
+			Select.execute();
+			return true;
 		} catch (const Poco::Exception &E) {
 			Logger().log(E);
 		}
 		return false;
 	}
 
-	bool VenueDB::EvaluateDeviceRules(const std::string &id, ProvObjects::DeviceRules &Rules) {
-		ProvObjects::Venue V;
-		if (GetRecord("id", id, V)) {
-			if (!Storage::ApplyRules(V.deviceRules, Rules))
-				return true;
-
-			if (!V.parent.empty()) {
-				return EvaluateDeviceRules(V.parent, Rules);
-			}
+	void VenueDB::LoadSourceIPs() {
+		std::map<std::string, Types::StringVec> Sources;
+		Iterate([&Sources](const ProvObjects::Venue &E) -> bool {
+			if (!E.sourceIP.empty())
+				Sources[E.info.id] = E.sourceIP;
+			return true;
+		});
+		SourceIPs_.Load(std::move(Sources));
+	}
 
-			if (!V.entity.empty()) {
-				return StorageService()->EntityDB().EvaluateDeviceRules(V.entity, Rules);
-			}
+	bool VenueDB::GetByIP(const std::string &IP, std::string &uuid) {
+		try {
+			//	the index is kept current by our own writes; the periodic reload picks up other instances
+			if (!SourceIPs_.Loaded() || (Utils::Now() - SourceIPs_.LoadedAt()) > 300)
+				LoadSourceIPs();
+			return SourceIPs_.Find(IP, uuid);
+		} catch (const Poco::Exception &E) {
+			Logger().log(E);
 		}
-		Storage::ApplyConfigRules(Rules);
+		return false;
+	}
+
+	//	parent venues, then the entity chain, all from the hierarchy index
+	bool VenueDB::EvaluateDeviceRules(const std::string &id, ProvObjects::DeviceRules &Rules) {
+		if (HierarchyIndex()->ApplyRules(id, Rules))
+			Storage::ApplyConfigRules(Rules);
 		return true;
 	}
 
@@ -172,6 +239,9 @@ void ORM::DB<OpenWifi::VenueDBRecordType, OpenWifi::ProvObjects::Venue>::Convert
 	Out.boards = OpenWifi::RESTAPI_utils::to_object_array(In.get<24>());
 }
 
+//	the member lists are kept in the memberships table, see MembershipDB
+static const std::string NoMembers{"[]"};
+
 template <>
 void ORM::DB<OpenWifi::VenueDBRecordType, OpenWifi::ProvObjects::Venue>::Convert(
 	const OpenWifi::ProvObjects::Venue &In, OpenWifi::VenueDBRecordType &Out) {
@@ -183,8 +253,8 @@ void ORM::DB<OpenWifi::VenueDBRecordType, OpenWifi::ProvObjects::Venue>::Convert
 	Out.set<5>(In.info.modified);
 	Out.set<6>(In.entity);
 	Out.set<7>(In.parent);
-	Out.set<8>(OpenWifi::RESTAPI_utils::to_string(In.children));
-	Out.set<9>(OpenWifi::RESTAPI_utils::to_string(In.devices));
+	Out.set<8>(NoMembers); // children
+	Out.set<9>(NoMembers); // devices
 	Out.set<10>(In.managementPolicy);
 	Out.set<11>(OpenWifi::RESTAPI_utils::to_string(In.topology));
 	Out.set<12>(In.design);
@@ -194,10 +264,10 @@ void ORM::DB<OpenWifi::VenueDBRecordType, OpenWifi::ProvObjects::Venue>::Convert
 	Out.set<16>(OpenWifi::RESTAPI_utils::to_string(In.info.tags));
 	Out.set<17>(OpenWifi::RESTAPI_utils::to_string(In.deviceConfiguration));
 	Out.set<18>(OpenWifi::RESTAPI_utils::to_string(In.sourceIP));
-	Out.set<19>(OpenWifi::RESTAPI_utils::to_string(In.variables));
-	Out.set<20>(OpenWifi::RESTAPI_utils::to_string(In.configurations));
-	Out.set<21>(OpenWifi::RESTAPI_utils::to_string(In.maps));
-	Out.set<22>(OpenWifi::RESTAPI_utils::to_string(In.managementPolicies));
-	Out.set<23>(OpenWifi::RESTAPI_utils::to_string(In.managementRoles));
+	Out.set<19>(NoMembers); // variables
+	Out.set<20>(NoMembers); // configurations
+	Out.set<21>(NoMembers); // maps
+	Out.set<22>(NoMembers); // managementPolicies
+	Out.set<23>(NoMembers); // managementRoles
 	Out.set<24>(OpenWifi::RESTAPI_utils::to_string(In.boards));
 }
@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include "HierarchyIndex.h"
+#include "IPRangeIndex.h"
 #include "RESTObjects/RESTAPI_ProvObjects.h"
 #include "framework/orm.h"
 
@@ -19,15 +21,66 @@ namespace OpenWifi {
 						std::string, std::string, std::string, std::string>
 		VenueDBRecordType;
 
+	//	id, name, parent, entity, deviceRules
+	typedef Poco::Tuple<std::string, std::string, std::string, std::string, std::string>
+		VenueHierarchyRecord;
+
 	class VenueDB : public ORM::DB<VenueDBRecordType, ProvObjects::Venue> {
 	  public:
 		VenueDB(OpenWifi::DBType T, Poco::Data::SessionPool &P, Poco::Logger &L);
 		virtual ~VenueDB(){};
 		bool GetByIP(const std::string &IP, std::string &uuid);
 		bool Upgrade(uint32_t from, uint32_t &to) override;
+		//	the member lists live in the memberships table
+		bool ManipulateRelation(Types::UUIDvec_t ProvObjects::Venue::*List, field_name_t FieldName,
+								const std::string &ParentUUID, const std::string &ChildUUID,
+								bool Add, bool &Changed) override;
+		void Complete(ProvObjects::Venue *Records, std::size_t Count) override;
+		bool CollectionState(std::vector<uint64_t> &State) override;
+		//	members for many records at once, with a single insert
+		bool AddMembers(Types::UUIDvec_t ProvObjects::Venue::*List,
+						const std::map<std::string, Types::UUIDvec_t> &Members);
 		bool EvaluateDeviceRules(const std::string &id, ProvObjects::DeviceRules &Rules);
+		//	the columns of every record, or of Id only, that the hierarchy index needs
+		bool GetHierarchyRecords(std::vector<VenueHierarchyRecord> &Records,
+								 const std::string &Id = "");
         bool DoesVenueNameAlreadyExist(const std::string &name, const std::string &entity_uuid, const std::string &parent_uuid);
 
 	  private:
+		IPRangeIndex SourceIPs_;
+
+		void LoadSourceIPs();
+		void AddLists(const ProvObjects::Venue &R);
+		void RemoveLists(const std::string &Id);
+
+	  protected:
+		//	every write keeps the member lists in step at once, and the sourceIP and hierarchy
+		//	indexes once it is durable
+		void Created(const ProvObjects::Venue &R) override {
+			AddLists(R);
+			Updated(R);
+		}
+
+		void Updated(const ProvObjects::Venue &R) override {
+			ORM::UnitOfWork::OnCommit(Pool_, [this, R]() {
+				SourceIPs_.Set(R.info.id, R.sourceIP);
+				HierarchyIndex()->SetVenue(R);
+			});
+		}
+
+		void Removed(const std::string &Id) override {
+			RemoveLists(Id);
+			ORM::UnitOfWork::OnCommit(Pool_, [this, Id]() {
+				SourceIPs_.Remove(Id);
+				HierarchyIndex()->Remove(Id);
+			});
+		}
+
+		void TableRewritten() override {
+			ORM::UnitOfWork::OnCommit(Pool_, [this]() {
+				SourceIPs_.Invalidate();
+				HierarchyIndex()->Invalidate();
+			});
+		}
 	};
 } // namespace OpenWifi